@@ -0,0 +1,411 @@
+#include "AudioCarrier.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+
+#include "FileIo.h"
+
+#ifdef STEG_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace Steganography {
+
+namespace {
+
+// Walks the RIFF chunks to "data", taking the sample format from "fmt ".
+// A data size past the end of the file (left by a writer that never went
+// back to fill it in) is cut to what the file holds.
+std::string parseWav(FILE* file, const std::string& path, WavFormat& format) {
+    const std::string notWav = "Error: " + path + " is not a WAV file.";
+    std::error_code ec;
+    const uint64_t fileBytes = std::filesystem::file_size(path, ec);
+    uint8_t riff[12];
+    if (ec || std::fread(riff, 1, 12, file) != 12 || std::memcmp(riff, "RIFF", 4) != 0 ||
+        std::memcmp(riff + 8, "WAVE", 4) != 0) {
+        return notWav;
+    }
+    bool haveFormat = false;
+    for (uint64_t at = 12;;) {
+        uint8_t chunk[8];
+        if (!seekTo(file, at) || std::fread(chunk, 1, 8, file) != 8) return notWav;
+        const uint64_t size = loadLe32(chunk + 4);
+        at += 8;
+        if (std::memcmp(chunk, "fmt ", 4) == 0) {
+            // WAVE_FORMAT_EXTENSIBLE keeps the real format tag at the start
+            // of its sub-format GUID
+            uint8_t fmt[40] = {};
+            const size_t fmtBytes = (size_t)std::min<uint64_t>(size, sizeof(fmt));
+            if (size < 16 || std::fread(fmt, 1, fmtBytes, file) != fmtBytes) return notWav;
+            unsigned tag = loadLe16(fmt);
+            if (tag == 0xFFFE && size >= 40) tag = loadLe16(fmt + 24);
+            format.channels = loadLe16(fmt + 2);
+            format.sampleRate = loadLe32(fmt + 4);
+            const unsigned bits = loadLe16(fmt + 14);
+            format.sampleBytes = bits / 8;
+            if (tag != 1 || (bits != 8 && bits != 16 && bits != 24) || format.channels == 0 ||
+                loadLe16(fmt + 12) != format.channels * format.sampleBytes) {
+                return "Error: " + path + " is not 8, 16 or 24-bit integer PCM audio.";
+            }
+            haveFormat = true;
+        } else if (std::memcmp(chunk, "data", 4) == 0) {
+            if (!haveFormat || at > fileBytes) return notWav;
+            format.dataOffset = at;
+            format.dataBytes = std::min<uint64_t>(size, fileBytes - at);
+            return "";
+        }
+        at += size + (size & 1);
+    }
+}
+
+// Copies `count` bytes, or everything up to the end of the input when count
+// is UINT64_MAX
+bool copyBytes(FILE* in, FILE* out, uint64_t count) {
+    std::vector<uint8_t> buffer(64 << 10);
+    while (count > 0) {
+        const size_t want = (size_t)std::min<uint64_t>(count, buffer.size());
+        const size_t got = std::fread(buffer.data(), 1, want, in);
+        if (got > 0 && std::fwrite(buffer.data(), 1, got, out) != got) return false;
+        if (got < want) return count == UINT64_MAX && !std::ferror(in);
+        if (count != UINT64_MAX) count -= got;
+    }
+    return true;
+}
+
+#ifdef STEG_X86_KERNELS
+
+// Per sample width: for each of the 32 * width bytes of a 32-sample block,
+// which payload byte and bit it takes and which of its bits it keeps (the
+// first byte of a sample takes its sample's bit, the others keep all 8);
+// for extraction, the shuffle that gathers the first bytes of a 16-sample
+// half from each of its 16-byte vectors, and the byte mask bits PEXT keeps
+// from each 32-byte vector
+struct SampleTables {
+    alignas(32) uint8_t shuffle[96];
+    alignas(32) uint8_t bit[96];
+    alignas(32) uint8_t keep[96];
+    alignas(16) uint8_t gather[6][16];
+    uint32_t firstBytes[3];
+    unsigned firstCounts[3];
+};
+
+SampleTables makeSampleTables(unsigned width) {
+    SampleTables t = {};
+    for (unsigned j = 0; j < 32 * width; ++j) {
+        const unsigned sample = j / width;
+        const bool first = j % width == 0;
+        t.shuffle[j] = first ? (uint8_t)(sample / 8) : 0x80;
+        t.bit[j] = first ? (uint8_t)(1 << (sample % 8)) : 0;
+        t.keep[j] = first ? 0xFE : 0xFF;
+    }
+    for (unsigned v = 0; v < 2 * width; ++v) {
+        const unsigned half = v / width;
+        for (unsigned lane = 0; lane < 16; ++lane) {
+            const unsigned byte = (16 * half + lane) * width;
+            t.gather[v][lane] = byte / 16 == v ? (uint8_t)(byte % 16) : 0x80;
+        }
+    }
+    for (unsigned v = 0; v < width; ++v) {
+        for (unsigned i = 0; i < 32; ++i) {
+            if ((32 * v + i) % width == 0) {
+                t.firstBytes[v] |= 1u << i;
+                ++t.firstCounts[v];
+            }
+        }
+    }
+    return t;
+}
+
+const SampleTables& sampleTablesFor(unsigned width) {
+    static const SampleTables tables[3] = {makeSampleTables(1), makeSampleTables(2), makeSampleTables(3)};
+    return tables[width - 1];
+}
+
+// Splits a call into a scalar head up to the first 4-byte block, whole
+// blocks, and a scalar tail
+struct SampleRange {
+    uint64_t headBytes;
+    uint64_t blocks;
+    uint64_t tailBytes;
+};
+
+SampleRange splitSampleBlocks(uint64_t streamOffset, uint64_t byteCount) {
+    SampleRange r;
+    r.headBytes = std::min<uint64_t>((4 - streamOffset % 4) % 4, byteCount);
+    r.blocks = (byteCount - r.headBytes) / 4;
+    r.tailBytes = byteCount - r.headBytes - r.blocks * 4;
+    return r;
+}
+
+#endif // STEG_X86_KERNELS
+
+} // namespace
+
+bool isWavPath(const std::string& path) {
+    return hasExtension(path, "wav");
+}
+
+std::string readWavFormat(const std::string& path, WavFormat& format) {
+    FileCloser source;
+    source.file = std::fopen(path.c_str(), "rb");
+    if (!source.file) return "Error: Could not read " + path + ".";
+    return parseWav(source.file, path, format);
+}
+
+std::string rewriteWav(const std::string& inputPath, const std::string& outputPath, const SampleBlockFn& block) {
+    FileCloser source, target;
+    source.file = std::fopen(inputPath.c_str(), "rb");
+    if (!source.file) return "Error: Could not read " + inputPath + ".";
+    WavFormat format;
+    std::string invalid = parseWav(source.file, inputPath, format);
+    if (!invalid.empty()) return invalid;
+    target.file = std::fopen(outputPath.c_str(), "wb");
+    if (!target.file) return "Error: Failed to save the output audio.";
+
+    std::string failed;
+    if (!seekTo(source.file, 0) || !copyBytes(source.file, target.file, format.dataOffset)) {
+        failed = "Error: Failed to save the output audio.";
+    }
+    std::vector<uint8_t> buffer(kWavBlockSamples * format.sampleBytes);
+    const uint64_t samples = format.sampleCount();
+    for (uint64_t first = 0; failed.empty() && first < samples; first += kWavBlockSamples) {
+        const uint64_t count = std::min<uint64_t>(kWavBlockSamples, samples - first);
+        const size_t bytes = (size_t)(count * format.sampleBytes);
+        if (std::fread(buffer.data(), 1, bytes, source.file) != bytes) {
+            failed = "Error: Could not read " + inputPath + ".";
+        } else if (!block(buffer.data(), first, count)) {
+            failed = "stopped";
+        } else if (std::fwrite(buffer.data(), 1, bytes, target.file) != bytes) {
+            failed = "Error: Failed to save the output audio.";
+        }
+    }
+    // A partial last sample, the pad byte and any chunks after the data
+    if (failed.empty() && !copyBytes(source.file, target.file, UINT64_MAX)) {
+        failed = "Error: Failed to save the output audio.";
+    }
+    const bool closed = std::fclose(target.file) == 0;
+    target.file = nullptr;
+    if (failed.empty() && !closed) failed = "Error: Failed to save the output audio.";
+    if (!failed.empty()) std::remove(outputPath.c_str());
+    return failed;
+}
+
+std::string scanWav(const std::string& path, uint64_t sampleLimit, const SampleBlockFn& block) {
+    FileCloser source;
+    source.file = std::fopen(path.c_str(), "rb");
+    if (!source.file) return "Error: Could not read " + path + ".";
+    WavFormat format;
+    std::string invalid = parseWav(source.file, path, format);
+    if (!invalid.empty()) return invalid;
+    if (!seekTo(source.file, format.dataOffset)) return "Error: Could not read " + path + ".";
+
+    std::vector<uint8_t> buffer(kWavBlockSamples * format.sampleBytes);
+    const uint64_t samples = std::min(sampleLimit, format.sampleCount());
+    for (uint64_t first = 0; first < samples; first += kWavBlockSamples) {
+        const uint64_t count = std::min<uint64_t>(kWavBlockSamples, samples - first);
+        const size_t bytes = (size_t)(count * format.sampleBytes);
+        if (std::fread(buffer.data(), 1, bytes, source.file) != bytes) return "Error: Could not read " + path + ".";
+        if (!block(buffer.data(), first, count)) break;
+    }
+    return "";
+}
+
+// --- Sample Kernels ---
+
+void embedSamplesScalar(uint8_t* samples, unsigned sampleBytes, unsigned depth, uint64_t streamOffset,
+                        const uint8_t* data, uint64_t byteCount) {
+    const uint8_t mask = (uint8_t)((1u << depth) - 1);
+    const unsigned groups = 8 / depth;
+    uint8_t* sample = samples + streamOffset * groups * sampleBytes;
+    for (uint64_t byte_i = 0; byte_i < byteCount; ++byte_i) {
+        unsigned bits = data[byte_i];
+        for (unsigned g = 0; g < groups; ++g, sample += sampleBytes) {
+            *sample = (uint8_t)((*sample & ~mask) | (bits & mask));
+            bits >>= depth;
+        }
+    }
+}
+
+void extractSamplesScalar(const uint8_t* samples, unsigned sampleBytes, unsigned depth, uint64_t streamOffset,
+                          uint8_t* data, uint64_t byteCount) {
+    const uint8_t mask = (uint8_t)((1u << depth) - 1);
+    const unsigned groups = 8 / depth;
+    const uint8_t* sample = samples + streamOffset * groups * sampleBytes;
+    for (uint64_t byte_i = 0; byte_i < byteCount; ++byte_i) {
+        unsigned bits = 0;
+        for (unsigned g = 0; g < groups; ++g, sample += sampleBytes) {
+            bits |= (unsigned)(*sample & mask) << (g * depth);
+        }
+        data[byte_i] = (uint8_t)bits;
+    }
+}
+
+#ifdef STEG_X86_KERNELS
+
+STEG_TARGET("ssse3")
+void embedSamplesSsse3(uint8_t* samples, unsigned sampleBytes, unsigned depth, uint64_t streamOffset,
+                       const uint8_t* data, uint64_t byteCount) {
+    if (depth != 1) {
+        embedSamplesScalar(samples, sampleBytes, depth, streamOffset, data, byteCount);
+        return;
+    }
+
+    const SampleTables& t = sampleTablesFor(sampleBytes);
+    SampleRange r = splitSampleBlocks(streamOffset, byteCount);
+    embedSamplesScalar(samples, sampleBytes, 1, streamOffset, data, r.headBytes);
+
+    const __m128i one = _mm_set1_epi8(1);
+    const unsigned vectors = 2 * sampleBytes;
+    const uint8_t* src = data + r.headBytes;
+    uint8_t* block = samples + (streamOffset + r.headBytes) / 4 * 32 * sampleBytes;
+    for (uint64_t b = 0; b < r.blocks; ++b, src += 4, block += 32 * sampleBytes) {
+        uint32_t word;
+        std::memcpy(&word, src, 4);
+        const __m128i bits = _mm_set1_epi32((int)word);
+        for (unsigned v = 0; v < vectors; ++v) {
+            const __m128i shuffle = _mm_load_si128((const __m128i*)(t.shuffle + 16 * v));
+            const __m128i bit = _mm_load_si128((const __m128i*)(t.bit + 16 * v));
+            const __m128i keep = _mm_load_si128((const __m128i*)(t.keep + 16 * v));
+            __m128i p = _mm_loadu_si128((const __m128i*)(block + 16 * v));
+            __m128i lsb = _mm_min_epu8(_mm_and_si128(_mm_shuffle_epi8(bits, shuffle), bit), one);
+            _mm_storeu_si128((__m128i*)(block + 16 * v), _mm_or_si128(_mm_and_si128(p, keep), lsb));
+        }
+    }
+
+    uint64_t done = r.headBytes + r.blocks * 4;
+    embedSamplesScalar(samples, sampleBytes, 1, streamOffset + done, data + done, r.tailBytes);
+}
+
+STEG_TARGET("ssse3")
+void extractSamplesSsse3(const uint8_t* samples, unsigned sampleBytes, unsigned depth, uint64_t streamOffset,
+                         uint8_t* data, uint64_t byteCount) {
+    if (depth != 1) {
+        extractSamplesScalar(samples, sampleBytes, depth, streamOffset, data, byteCount);
+        return;
+    }
+
+    const SampleTables& t = sampleTablesFor(sampleBytes);
+    SampleRange r = splitSampleBlocks(streamOffset, byteCount);
+    extractSamplesScalar(samples, sampleBytes, 1, streamOffset, data, r.headBytes);
+
+    uint8_t* dst = data + r.headBytes;
+    const uint8_t* block = samples + (streamOffset + r.headBytes) / 4 * 32 * sampleBytes;
+    for (uint64_t b = 0; b < r.blocks; ++b, dst += 4, block += 32 * sampleBytes) {
+        uint32_t word = 0;
+        for (unsigned half = 0; half < 2; ++half) {
+            __m128i firsts = _mm_setzero_si128();
+            for (unsigned v = half * sampleBytes; v < (half + 1) * sampleBytes; ++v) {
+                __m128i p = _mm_loadu_si128((const __m128i*)(block + 16 * v));
+                firsts = _mm_or_si128(firsts, _mm_shuffle_epi8(p, _mm_load_si128((const __m128i*)t.gather[v])));
+            }
+            word |= (uint32_t)_mm_movemask_epi8(_mm_slli_epi16(firsts, 7)) << (16 * half);
+        }
+        std::memcpy(dst, &word, 4);
+    }
+
+    uint64_t done = r.headBytes + r.blocks * 4;
+    extractSamplesScalar(samples, sampleBytes, 1, streamOffset + done, data + done, r.tailBytes);
+}
+
+STEG_TARGET("avx2,bmi2")
+void embedSamplesAvx2(uint8_t* samples, unsigned sampleBytes, unsigned depth, uint64_t streamOffset,
+                      const uint8_t* data, uint64_t byteCount) {
+    if (depth != 1) {
+        embedSamplesScalar(samples, sampleBytes, depth, streamOffset, data, byteCount);
+        return;
+    }
+
+    const SampleTables& t = sampleTablesFor(sampleBytes);
+    SampleRange r = splitSampleBlocks(streamOffset, byteCount);
+    embedSamplesScalar(samples, sampleBytes, 1, streamOffset, data, r.headBytes);
+
+    // The broadcast puts the 4 payload bytes in both 128-bit lanes, so the
+    // in-lane VPSHUFB finds them at offsets 0..3 either way
+    const __m256i one = _mm256_set1_epi8(1);
+    const uint8_t* src = data + r.headBytes;
+    uint8_t* block = samples + (streamOffset + r.headBytes) / 4 * 32 * sampleBytes;
+    for (uint64_t b = 0; b < r.blocks; ++b, src += 4, block += 32 * sampleBytes) {
+        uint32_t word;
+        std::memcpy(&word, src, 4);
+        const __m256i bits = _mm256_set1_epi32((int)word);
+        for (unsigned v = 0; v < sampleBytes; ++v) {
+            const __m256i shuffle = _mm256_load_si256((const __m256i*)(t.shuffle + 32 * v));
+            const __m256i bit = _mm256_load_si256((const __m256i*)(t.bit + 32 * v));
+            const __m256i keep = _mm256_load_si256((const __m256i*)(t.keep + 32 * v));
+            __m256i p = _mm256_loadu_si256((const __m256i*)(block + 32 * v));
+            __m256i lsb = _mm256_min_epu8(_mm256_and_si256(_mm256_shuffle_epi8(bits, shuffle), bit), one);
+            _mm256_storeu_si256((__m256i*)(block + 32 * v), _mm256_or_si256(_mm256_and_si256(p, keep), lsb));
+        }
+    }
+
+    uint64_t done = r.headBytes + r.blocks * 4;
+    embedSamplesScalar(samples, sampleBytes, 1, streamOffset + done, data + done, r.tailBytes);
+}
+
+STEG_TARGET("avx2,bmi2")
+void extractSamplesAvx2(const uint8_t* samples, unsigned sampleBytes, unsigned depth, uint64_t streamOffset,
+                        uint8_t* data, uint64_t byteCount) {
+    if (depth != 1) {
+        extractSamplesScalar(samples, sampleBytes, depth, streamOffset, data, byteCount);
+        return;
+    }
+
+    const SampleTables& t = sampleTablesFor(sampleBytes);
+    SampleRange r = splitSampleBlocks(streamOffset, byteCount);
+    extractSamplesScalar(samples, sampleBytes, 1, streamOffset, data, r.headBytes);
+
+    uint8_t* dst = data + r.headBytes;
+    const uint8_t* block = samples + (streamOffset + r.headBytes) / 4 * 32 * sampleBytes;
+    for (uint64_t b = 0; b < r.blocks; ++b, dst += 4, block += 32 * sampleBytes) {
+        uint32_t word = 0;
+        unsigned filled = 0;
+        for (unsigned v = 0; v < sampleBytes; ++v) {
+            __m256i p = _mm256_slli_epi16(_mm256_loadu_si256((const __m256i*)(block + 32 * v)), 7);
+            word |= _pext_u32((uint32_t)_mm256_movemask_epi8(p), t.firstBytes[v]) << filled;
+            filled += t.firstCounts[v];
+        }
+        std::memcpy(dst, &word, 4);
+    }
+
+    uint64_t done = r.headBytes + r.blocks * 4;
+    extractSamplesScalar(samples, sampleBytes, 1, streamOffset + done, data + done, r.tailBytes);
+}
+
+#endif // STEG_X86_KERNELS
+
+std::vector<SampleVariant> availableSampleKernels() {
+    std::vector<SampleVariant> kernels = {{"scalar", embedSamplesScalar, extractSamplesScalar}};
+#ifdef STEG_X86_KERNELS
+    if (cpuSupports("ssse3")) kernels.push_back({"ssse3", embedSamplesSsse3, extractSamplesSsse3});
+    if (cpuSupports("avx2")) kernels.push_back({"avx2", embedSamplesAvx2, extractSamplesAvx2});
+#endif
+    return kernels;
+}
+
+static const SampleVariant& fastestSampleKernel() {
+    static const SampleVariant chosen = [] {
+        std::vector<SampleVariant> kernels = availableSampleKernels();
+        if (const char* pinned = std::getenv("STEG_KERNEL")) {
+            for (const SampleVariant& kernel : kernels) {
+                if (std::strcmp(kernel.name, pinned) == 0) return kernel;
+            }
+        }
+        return kernels.back();
+    }();
+    return chosen;
+}
+
+void embedSamplesFast(uint8_t* samples, unsigned sampleBytes, unsigned depth, uint64_t streamOffset,
+                      const uint8_t* data, uint64_t byteCount) {
+    fastestSampleKernel().embed(samples, sampleBytes, depth, streamOffset, data, byteCount);
+}
+
+void extractSamplesFast(const uint8_t* samples, unsigned sampleBytes, unsigned depth, uint64_t streamOffset,
+                        uint8_t* data, uint64_t byteCount) {
+    fastestSampleKernel().extract(samples, sampleBytes, depth, streamOffset, data, byteCount);
+}
+
+} // namespace Steganography
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "Kernels.h"
+
+// --- WAV Carriers ---
+// A PCM WAV carrier keeps the payload in the low bits of its samples, taken
+// in file order across all channels. 8-bit samples are unsigned and wider
+// ones little-endian, so either way the bits to change are the low bits of
+// each sample's first byte. Files are streamed a block of samples at a time
+// and everything but the sample data is copied as it is, so a recording of
+// any length is embedded or read in the same few hundred kilobytes.
+namespace Steganography {
+
+// Samples per streamed block, a multiple of 8 so every block starts on a
+// whole stream byte at any depth
+const uint64_t kWavBlockSamples = 1 << 18;
+
+// True for .wav paths (case-insensitive)
+bool isWavPath(const std::string& path);
+
+// Where a PCM WAV file keeps its samples
+struct WavFormat {
+    unsigned channels = 0;
+    unsigned sampleRate = 0;
+    unsigned sampleBytes = 0; // 1, 2 or 3
+    uint64_t dataOffset = 0;  // File offset of the first sample
+    uint64_t dataBytes = 0;   // Bytes of sample data
+
+    uint64_t sampleCount() const { return dataBytes / sampleBytes; }
+};
+
+// Reads the chunks of a WAV file up to its sample data. Returns "" or an
+// error message; only 8, 16 and 24-bit integer PCM is accepted.
+std::string readWavFormat(const std::string& path, WavFormat& format);
+
+// Called with `count` whole samples starting at sample `first`; false stops
+// the stream
+typedef std::function<bool(uint8_t* samples, uint64_t first, uint64_t count)> SampleBlockFn;
+
+// Copies the WAV file at inputPath to outputPath, handing each block of
+// samples to `block` to change in place first. Returns "" once the whole file
+// is written, "stopped" if `block` stopped it (the output is then removed),
+// or an error message.
+std::string rewriteWav(const std::string& inputPath, const std::string& outputPath, const SampleBlockFn& block);
+
+// Hands the samples of a WAV file to `block` in order, up to `sampleLimit`
+// of them. Returns "" or an error message; stopping early is not an error.
+std::string scanWav(const std::string& path, uint64_t sampleLimit, const SampleBlockFn& block);
+
+// --- Sample Kernels ---
+// Stream bit i goes to bit plane (i % depth) of sample (i / depth), depth 1,
+// 2 or 4, as the pixel kernels do with channels; `streamOffset` is the first
+// stream byte touched. The SIMD kernels take 32 samples (4 stream bytes at
+// depth 1) per block: PSHUFB routes each payload byte to the first byte of
+// its samples and leaves the others, and extraction shuffles those bytes
+// together (or PEXTs their bits out of a byte mask) before MOVEMASK.
+typedef void (*SampleEmbedKernel)(uint8_t* samples, unsigned sampleBytes, unsigned depth, uint64_t streamOffset,
+                                  const uint8_t* data, uint64_t byteCount);
+typedef void (*SampleExtractKernel)(const uint8_t* samples, unsigned sampleBytes, unsigned depth,
+                                    uint64_t streamOffset, uint8_t* data, uint64_t byteCount);
+
+struct SampleVariant {
+    const char* name;
+    SampleEmbedKernel embed;
+    SampleExtractKernel extract;
+};
+
+void embedSamplesScalar(uint8_t* samples, unsigned sampleBytes, unsigned depth, uint64_t streamOffset,
+                        const uint8_t* data, uint64_t byteCount);
+void extractSamplesScalar(const uint8_t* samples, unsigned sampleBytes, unsigned depth, uint64_t streamOffset,
+                          uint8_t* data, uint64_t byteCount);
+#ifdef STEG_X86_KERNELS
+// Depth 1 only; other depths defer to the scalar kernels. Only call them
+// when cpuSupports() reports "ssse3" or "avx2".
+void embedSamplesSsse3(uint8_t* samples, unsigned sampleBytes, unsigned depth, uint64_t streamOffset,
+                       const uint8_t* data, uint64_t byteCount);
+void extractSamplesSsse3(const uint8_t* samples, unsigned sampleBytes, unsigned depth, uint64_t streamOffset,
+                         uint8_t* data, uint64_t byteCount);
+void embedSamplesAvx2(uint8_t* samples, unsigned sampleBytes, unsigned depth, uint64_t streamOffset,
+                      const uint8_t* data, uint64_t byteCount);
+void extractSamplesAvx2(const uint8_t* samples, unsigned sampleBytes, unsigned depth, uint64_t streamOffset,
+                        uint8_t* data, uint64_t byteCount);
+#endif
+
+// Every sample kernel this CPU can run, scalar first
+std::vector<SampleVariant> availableSampleKernels();
+
+// Fastest sample kernels; STEG_KERNEL pins one by name
+void embedSamplesFast(uint8_t* samples, unsigned sampleBytes, unsigned depth, uint64_t streamOffset,
+                      const uint8_t* data, uint64_t byteCount);
+void extractSamplesFast(const uint8_t* samples, unsigned sampleBytes, unsigned depth, uint64_t streamOffset,
+                        uint8_t* data, uint64_t byteCount);
+
+} // namespace Steganography
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+// --- Bit Helpers ---
+// Little-endian bit streams over byte buffers, matching the payload bit
+// order used by the kernels (bit 0 of byte 0 first).
+namespace Steganography {
+
+// Sequential reader for bit streams; reads of up to 56 bits at a time
+class BitReader {
+public:
+    BitReader(const uint8_t* data, uint64_t size) : data(data), size(size) {}
+
+    uint64_t read(unsigned count) {
+        if (available < count) refill();
+        uint64_t value = buffer & ((1ull << count) - 1);
+        buffer >>= count;
+        available -= count < available ? count : available;
+        return value;
+    }
+
+private:
+    // Tops the buffer up to at least 56 bits; past the end it fills with zeros
+    void refill() {
+        if (pos + 8 <= size) {
+            uint64_t word;
+            std::memcpy(&word, data + pos, 8);
+            buffer |= word << available;
+            pos += (63 - available) >> 3;
+            available |= 56;
+        } else {
+            while (available <= 56 && pos < size) {
+                buffer |= (uint64_t)data[pos++] << available;
+                available += 8;
+            }
+            available = 56 > available ? 56 : available;
+        }
+    }
+
+    const uint8_t* data;
+    uint64_t size;
+    uint64_t pos = 0;
+    uint64_t buffer = 0;
+    unsigned available = 0;
+};
+
+// Sequential writer for bit streams; writes of up to 56 bits at a time.
+// Bits past `size` bytes are dropped.
+class BitWriter {
+public:
+    BitWriter(uint8_t* data, uint64_t size) : data(data), size(size) {}
+    ~BitWriter() { flush(); }
+
+    void write(uint64_t value, unsigned count) {
+        buffer |= value << pending;
+        pending += count;
+        while (pending >= 8) {
+            if (pos < size) data[pos] = (uint8_t)buffer;
+            pos++;
+            buffer >>= 8;
+            pending -= 8;
+        }
+    }
+
+    void flush() {
+        if (pending && pos < size) data[pos] = (uint8_t)buffer;
+        pos += pending ? 1 : 0;
+        buffer = 0;
+        pending = 0;
+    }
+
+private:
+    uint8_t* data;
+    uint64_t size;
+    uint64_t pos = 0;
+    uint64_t buffer = 0;
+    unsigned pending = 0;
+};
+
+} // namespace Steganography
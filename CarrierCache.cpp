@@ -0,0 +1,91 @@
+#include "CarrierCache.h"
+
+#include <filesystem>
+
+namespace Steganography {
+
+namespace {
+
+FileStamp stampOf(const std::string& path) {
+    FileStamp stamp;
+    std::error_code ec;
+    const auto modified = std::filesystem::last_write_time(path, ec);
+    if (ec) return stamp;
+    stamp.size = std::filesystem::file_size(path, ec);
+    if (ec) return stamp;
+    stamp.modified = (int64_t)modified.time_since_epoch().count();
+    stamp.valid = true;
+    return stamp;
+}
+
+bool sameFile(const FileStamp& a, const FileStamp& b) {
+    return a.valid && b.valid && a.modified == b.modified && a.size == b.size;
+}
+
+} // namespace
+
+std::shared_ptr<const DecodedCarrier> CarrierCache::find(const std::string& path, FileStamp& stamp) {
+    stamp = stampOf(path);
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = byPath.find(path);
+    if (found == byPath.end() || !sameFile(found->second->stamp, stamp)) {
+        ++missCount;
+        return nullptr;
+    }
+    recent.splice(recent.begin(), recent, found->second);
+    ++hitCount;
+    return found->second->carrier;
+}
+
+void CarrierCache::insert(const std::string& path, const FileStamp& stamp, unsigned width, unsigned height,
+                          const uint8_t* rgba) {
+    const uint64_t size = (uint64_t)width * height * 4;
+    if (!stamp.valid || size > capacity) return;
+
+    // Copied before locking, so other jobs are not held up by it
+    auto carrier = std::make_shared<DecodedCarrier>();
+    carrier->width = width;
+    carrier->height = height;
+    carrier->rgba.assign(rgba, rgba + size);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = byPath.find(path);
+    if (found != byPath.end()) {
+        used -= found->second->carrier->rgba.size();
+        recent.erase(found->second);
+        byPath.erase(found);
+    }
+    // Dropped entries stay alive for jobs still copying from them
+    while (used + size > capacity && !recent.empty()) {
+        used -= recent.back().carrier->rgba.size();
+        byPath.erase(recent.back().path);
+        recent.pop_back();
+    }
+    recent.push_front(Entry{path, stamp, std::move(carrier)});
+    byPath[path] = recent.begin();
+    used += size;
+}
+
+void CarrierCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    recent.clear();
+    byPath.clear();
+    used = 0;
+}
+
+uint64_t CarrierCache::bytes() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return used;
+}
+
+uint64_t CarrierCache::hits() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return hitCount;
+}
+
+uint64_t CarrierCache::misses() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return missCount;
+}
+
+} // namespace Steganography
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// --- Carrier Cache ---
+// Decoded carrier pixels kept in memory between jobs of one process, so a
+// carrier used again costs a copy of its pixels rather than a file read and
+// a PNG inflate. An entry is keyed by path and stamped with the file's
+// modification time and size; a file changed on disk misses and is decoded
+// afresh. The cache holds at most a set number of pixel bytes and drops the
+// least recently used carriers to stay under it. Jobs on several threads may
+// share one cache.
+namespace Steganography {
+
+// RGBA pixels of a decoded carrier, row by row
+struct DecodedCarrier {
+    unsigned width = 0;
+    unsigned height = 0;
+    std::vector<uint8_t> rgba;
+};
+
+// What a file looked like on disk when it was decoded
+struct FileStamp {
+    bool valid = false;
+    int64_t modified = 0; // Modification time in the filesystem clock's ticks
+    uint64_t size = 0;
+};
+
+class CarrierCache {
+public:
+    explicit CarrierCache(uint64_t capacityBytes) : capacity(capacityBytes) {}
+    CarrierCache(const CarrierCache&) = delete;
+    CarrierCache& operator=(const CarrierCache&) = delete;
+
+    // The cached pixels of `path` if the file is unchanged since they were
+    // decoded, else null. Sets `stamp` to the file as it is now either way,
+    // to hand to insert() once the file has been decoded.
+    std::shared_ptr<const DecodedCarrier> find(const std::string& path, FileStamp& stamp);
+
+    // Caches a copy of the pixels of `path`, decoded from the file as
+    // `stamp` saw it. Carriers bigger than the whole cache are not kept.
+    void insert(const std::string& path, const FileStamp& stamp, unsigned width, unsigned height, const uint8_t* rgba);
+
+    void clear();
+
+    uint64_t bytes() const;
+    uint64_t hits() const;
+    uint64_t misses() const;
+
+private:
+    struct Entry {
+        std::string path;
+        FileStamp stamp;
+        std::shared_ptr<const DecodedCarrier> carrier;
+    };
+
+    const uint64_t capacity;
+    mutable std::mutex mutex;
+    std::list<Entry> recent; // Most recently used first
+    std::unordered_map<std::string, std::list<Entry>::iterator> byPath;
+    uint64_t used = 0;
+    uint64_t hitCount = 0;
+    uint64_t missCount = 0;
+};
+
+} // namespace Steganography
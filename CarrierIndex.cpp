@@ -0,0 +1,223 @@
+#include "CarrierIndex.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+#include <openssl/evp.h>
+
+#include "FileIo.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Steganography {
+
+namespace {
+
+const char kMagic[8] = {'S', 'T', 'E', 'G', 'I', 'D', 'X', '1'};
+const uint64_t kRecordFixedBytes = 72;
+
+// Frees the digest context however hashing ends
+struct DigestContext {
+    EVP_MD_CTX* context = EVP_MD_CTX_new();
+
+    ~DigestContext() { EVP_MD_CTX_free(context); }
+};
+
+} // namespace
+
+CarrierIndex::~CarrierIndex() {
+    close();
+}
+
+void CarrierIndex::close() {
+    if (data) {
+#ifdef _WIN32
+        UnmapViewOfFile(data);
+        CloseHandle((HANDLE)mapping);
+        mapping = nullptr;
+#else
+        munmap((void*)data, bytes);
+#endif
+    }
+    data = nullptr;
+    bytes = count = recordBytes = pathBytes = 0;
+    paths = nullptr;
+    modes = 0;
+}
+
+std::string CarrierIndex::open(const std::string& path) {
+    close();
+    const std::string unreadable = "Error: Could not read the carrier index " + path + ".";
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return unreadable;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart < (LONGLONG)kFixedBytes) {
+        CloseHandle(file);
+        return unreadable;
+    }
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (!mapping) return unreadable;
+    data = (const uint8_t*)MapViewOfFile((HANDLE)mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!data) {
+        CloseHandle((HANDLE)mapping);
+        mapping = nullptr;
+        return unreadable;
+    }
+    bytes = (uint64_t)size.QuadPart;
+#else
+    int file = ::open(path.c_str(), O_RDONLY);
+    if (file < 0) return unreadable;
+    struct stat status;
+    if (fstat(file, &status) != 0 || status.st_size < (off_t)kFixedBytes) {
+        ::close(file);
+        return unreadable;
+    }
+    void* mapped = mmap(nullptr, (size_t)status.st_size, PROT_READ, MAP_SHARED, file, 0);
+    ::close(file); // The mapping keeps the file open
+    if (mapped == MAP_FAILED) return unreadable;
+    data = (const uint8_t*)mapped;
+    bytes = (uint64_t)status.st_size;
+#endif
+
+    // The sizes in the header must account for the whole file exactly
+    modes = loadLe32(data + 8);
+    count = loadLe64(data + 16);
+    pathBytes = loadLe64(data + 24);
+    recordBytes = kRecordFixedBytes + 8 * (uint64_t)modes;
+    const uint64_t recordSpace = bytes - kFixedBytes;
+    if (std::memcmp(data, kMagic, 8) != 0 || modes > 64 || count > recordSpace / recordBytes ||
+        pathBytes != recordSpace - count * recordBytes) {
+        close();
+        return "Error: " + path + " is not a carrier index.";
+    }
+    paths = data + kFixedBytes + count * recordBytes;
+    return "";
+}
+
+std::string CarrierIndex::pathOf(const uint8_t* entry) const {
+    const uint64_t offset = loadLe64(entry);
+    const uint64_t length = loadLe32(entry + 8);
+    if (offset > pathBytes || length > pathBytes - offset) return std::string();
+    return std::string(reinterpret_cast<const char*>(paths + offset), length);
+}
+
+IndexedCarrier CarrierIndex::at(uint64_t i) const {
+    const uint8_t* entry = record(i);
+    IndexedCarrier carrier;
+    carrier.path = pathOf(entry);
+    carrier.info.format = (ImageFormat)entry[12];
+    carrier.info.alpha = entry[13] != 0;
+    carrier.info.width = loadLe32(entry + 16);
+    carrier.info.height = loadLe32(entry + 20);
+    carrier.modified = (int64_t)loadLe64(entry + 24);
+    carrier.fileSize = loadLe64(entry + 32);
+    std::memcpy(carrier.hash, entry + 40, kContentHashBytes);
+    for (unsigned m = 0; m < modes; ++m) carrier.capacities.push_back(loadLe64(entry + kRecordFixedBytes + 8 * m));
+    return carrier;
+}
+
+bool CarrierIndex::find(const std::string& path, IndexedCarrier& carrier) const {
+    uint64_t low = 0, high = count;
+    while (low < high) {
+        const uint64_t middle = low + (high - low) / 2;
+        const int order = pathOf(record(middle)).compare(path);
+        if (order == 0) {
+            carrier = at(middle);
+            return true;
+        }
+        if (order < 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return false;
+}
+
+uint64_t CarrierIndex::pixelCount(uint64_t i) const {
+    return (uint64_t)loadLe32(record(i) + 16) * loadLe32(record(i) + 20);
+}
+
+bool CarrierIndex::hasAlpha(uint64_t i) const {
+    return record(i)[13] != 0;
+}
+
+std::string writeCarrierIndex(const std::string& path, std::vector<IndexedCarrier> carriers) {
+    std::sort(carriers.begin(), carriers.end(),
+              [](const IndexedCarrier& a, const IndexedCarrier& b) { return a.path < b.path; });
+    const unsigned modes = carriers.empty() ? 0 : (unsigned)carriers.front().capacities.size();
+    const uint64_t recordBytes = kRecordFixedBytes + 8 * (uint64_t)modes;
+
+    std::vector<uint8_t> records(32 + carriers.size() * recordBytes);
+    std::string paths;
+    std::memcpy(records.data(), kMagic, 8);
+    storeLe32(modes, records.data() + 8);
+    storeLe64(carriers.size(), records.data() + 16);
+    for (size_t i = 0; i < carriers.size(); ++i) {
+        const IndexedCarrier& carrier = carriers[i];
+        uint8_t* entry = records.data() + 32 + i * recordBytes;
+        storeLe64(paths.size(), entry);
+        storeLe32((uint32_t)carrier.path.size(), entry + 8);
+        entry[12] = (uint8_t)carrier.info.format;
+        entry[13] = carrier.info.alpha ? 1 : 0;
+        storeLe32(carrier.info.width, entry + 16);
+        storeLe32(carrier.info.height, entry + 20);
+        storeLe64((uint64_t)carrier.modified, entry + 24);
+        storeLe64(carrier.fileSize, entry + 32);
+        std::memcpy(entry + 40, carrier.hash, kContentHashBytes);
+        for (unsigned m = 0; m < modes && m < carrier.capacities.size(); ++m) {
+            storeLe64(carrier.capacities[m], entry + kRecordFixedBytes + 8 * m);
+        }
+        paths += carrier.path;
+    }
+    storeLe64(paths.size(), records.data() + 24);
+
+    const std::string temporary = path + ".tmp";
+    FILE* file = std::fopen(temporary.c_str(), "wb");
+    if (!file) {
+        return "Error: Could not write the carrier index " + path + ".";
+    }
+    const bool written = std::fwrite(records.data(), 1, records.size(), file) == records.size() &&
+                         std::fwrite(paths.data(), 1, paths.size(), file) == paths.size();
+    if (std::fclose(file) != 0 || !written) {
+        std::remove(temporary.c_str());
+        return "Error: Could not write the carrier index " + path + ".";
+    }
+    std::error_code ec;
+    std::filesystem::rename(temporary, path, ec);
+    if (ec) {
+        std::remove(temporary.c_str());
+        return "Error: Could not replace the carrier index " + path + ".";
+    }
+    return "";
+}
+
+bool hashFile(const std::string& path, uint8_t* hash) {
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) return false;
+    DigestContext digest;
+    bool ok = digest.context && EVP_DigestInit_ex(digest.context, EVP_sha256(), nullptr) == 1;
+    std::vector<unsigned char> buffer(1 << 20);
+    size_t got;
+    while (ok && (got = std::fread(buffer.data(), 1, buffer.size(), file)) > 0) {
+        ok = EVP_DigestUpdate(digest.context, buffer.data(), got) == 1;
+    }
+    ok = ok && !std::ferror(file) && EVP_DigestFinal_ex(digest.context, hash, nullptr) == 1;
+    std::fclose(file);
+    return ok;
+}
+
+} // namespace Steganography
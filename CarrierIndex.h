@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "ImageProbe.h"
+
+// --- Carrier Index ---
+// A persistent catalogue of a carrier pool: one fixed-size record per image,
+// sorted by path, then the paths themselves. The file is memory-mapped
+// read-only, so opening an index of half a million carriers reads nothing up
+// front, and a lookup by path is a binary search over a few records.
+//
+// File layout (little-endian):
+//    0  magic "STEGIDX1" (8), mode count M (4), reserved (4),
+//       record count N (8), path bytes S (8)
+//   32  N records of 72 + 8M bytes: path offset (8) and length (4),
+//       format (1), alpha (1), reserved (2), width (4), height (4),
+//       modification time (8), file size (8), SHA-256 of the file (32),
+//       capacity under each plan mode (8 each)
+//  ...  the paths, S bytes
+namespace Steganography {
+
+const unsigned kContentHashBytes = 32;
+
+// One carrier as the index records it
+struct IndexedCarrier {
+    std::string path;
+    ImageInfo info;
+    int64_t modified = 0; // Modification time in the filesystem clock's ticks
+    uint64_t fileSize = 0;
+    uint8_t hash[kContentHashBytes] = {}; // SHA-256 of the file
+    std::vector<uint64_t> capacities;     // Bytes under each of planModes()
+};
+
+// A read-only view of an index file
+class CarrierIndex {
+public:
+    CarrierIndex() = default;
+    ~CarrierIndex();
+    CarrierIndex(const CarrierIndex&) = delete;
+    CarrierIndex& operator=(const CarrierIndex&) = delete;
+
+    // Maps the index file at `path`, unmapping any earlier one. Returns ""
+    // or an error message.
+    std::string open(const std::string& path);
+    void close();
+
+    uint64_t size() const { return count; }
+
+    // Record `i` (< size()); records are in path order
+    IndexedCarrier at(uint64_t i) const;
+
+    // Finds the record of `path`; false if the index has none
+    bool find(const std::string& path, IndexedCarrier& carrier) const;
+
+    // Single fields of record `i`, for scans that need no more
+    uint64_t pixelCount(uint64_t i) const;
+    bool hasAlpha(uint64_t i) const;
+
+private:
+    const uint8_t* record(uint64_t i) const { return data + kFixedBytes + i * recordBytes; }
+    std::string pathOf(const uint8_t* entry) const;
+
+    static const uint64_t kFixedBytes = 32;
+
+    const uint8_t* data = nullptr;
+    uint64_t bytes = 0;
+    uint64_t count = 0;
+    unsigned modes = 0;
+    uint64_t recordBytes = 0;
+    const uint8_t* paths = nullptr;
+    uint64_t pathBytes = 0;
+#ifdef _WIN32
+    void* mapping = nullptr;
+#endif
+};
+
+// Writes `carriers`, in any order, as the index file at `path`, through a
+// temporary file renamed over it so a reader never maps half an index. Close
+// any CarrierIndex open on `path` first. Returns "" or an error message.
+std::string writeCarrierIndex(const std::string& path, std::vector<IndexedCarrier> carriers);
+
+// SHA-256 of a file's contents; false if it cannot be read
+bool hashFile(const std::string& path, uint8_t* hash);
+
+} // namespace Steganography
@@ -0,0 +1,145 @@
+#include "Checksum.h"
+
+#include <cstdlib>
+#include <cstring>
+
+#ifdef STEG_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace Steganography {
+
+namespace {
+
+// Reflected Castagnoli polynomial
+const uint32_t kPoly = 0x82F63B78;
+
+// --- Slicing-by-8 ---
+// table[0] is the byte-at-a-time table; table[k] advances a byte's
+// contribution past k more bytes, so eight lookups consume eight bytes
+struct CrcTables {
+    uint32_t table[8][256];
+
+    CrcTables() {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int bit = 0; bit < 8; ++bit) c = (c >> 1) ^ (kPoly & (0u - (c & 1)));
+            table[0][i] = c;
+        }
+        for (uint32_t i = 0; i < 256; ++i) {
+            for (int k = 1; k < 8; ++k) {
+                uint32_t c = table[k - 1][i];
+                table[k][i] = (c >> 8) ^ table[0][c & 0xFF];
+            }
+        }
+    }
+};
+
+const CrcTables& crcTables() {
+    static const CrcTables tables;
+    return tables;
+}
+
+#ifdef STEG_X86_KERNELS
+
+// Bytes per stream of a three-way block
+const uint64_t kStride = 2048;
+
+// x^e mod P in the reflected representation (bit 31 is x^0)
+constexpr uint32_t xPowMod(uint64_t e) {
+    uint32_t v = 0x80000000u;
+    for (uint64_t i = 0; i < e; ++i) v = (v >> 1) ^ ((v & 1) ? kPoly : 0);
+    return v;
+}
+
+// A carry-less product of two reflected 32-bit values is the polynomial
+// product times x, and CRC32 of a 64-bit word multiplies by x^32 before
+// reducing. Multiplying by x^(8n - 33) therefore advances a CRC over n zero
+// bytes.
+constexpr uint32_t kShiftOne = xPowMod(8 * kStride - 33);
+constexpr uint32_t kShiftTwo = xPowMod(16 * kStride - 33);
+
+STEG_TARGET("sse4.2,pclmul")
+inline uint64_t shiftCrc(uint64_t crc, uint32_t constant) {
+    __m128i product = _mm_clmulepi64_si128(_mm_cvtsi64_si128((long long)crc), _mm_cvtsi32_si128((int)constant), 0);
+    return _mm_crc32_u64(0, (uint64_t)_mm_cvtsi128_si64(product));
+}
+
+inline uint64_t load64(const uint8_t* p) {
+    uint64_t word;
+    std::memcpy(&word, p, 8);
+    return word;
+}
+
+#endif // STEG_X86_KERNELS
+
+} // namespace
+
+uint32_t crc32cScalar(const uint8_t* data, uint64_t size, uint32_t crc) {
+    const uint32_t (*t)[256] = crcTables().table;
+    uint32_t c = ~crc;
+    for (; size >= 8; data += 8, size -= 8) {
+        uint32_t low, high;
+        std::memcpy(&low, data, 4);
+        std::memcpy(&high, data + 4, 4);
+        low ^= c;
+        c = t[7][low & 0xFF] ^ t[6][(low >> 8) & 0xFF] ^ t[5][(low >> 16) & 0xFF] ^ t[4][low >> 24] ^
+            t[3][high & 0xFF] ^ t[2][(high >> 8) & 0xFF] ^ t[1][(high >> 16) & 0xFF] ^ t[0][high >> 24];
+    }
+    for (; size > 0; ++data, --size) {
+        c = t[0][(c ^ *data) & 0xFF] ^ (c >> 8);
+    }
+    return ~c;
+}
+
+#ifdef STEG_X86_KERNELS
+
+// The CRC32 instruction has a latency of three cycles and a throughput of
+// one, so a single stream runs at a third of its speed. Blocks of three
+// strides are summed as three streams (CRC is linear: crc(A || B) is crc(A)
+// advanced over |B| zero bytes, XOR crc(B) from zero) and folded together.
+STEG_TARGET("sse4.2,pclmul")
+uint32_t crc32cSse42(const uint8_t* data, uint64_t size, uint32_t crc) {
+    uint64_t c = ~crc;
+    for (; size > 0 && ((uintptr_t)data & 7); ++data, --size) {
+        c = _mm_crc32_u8((uint32_t)c, *data);
+    }
+    for (; size >= 3 * kStride; data += 3 * kStride, size -= 3 * kStride) {
+        uint64_t c1 = 0, c2 = 0;
+        for (uint64_t i = 0; i < kStride; i += 8) {
+            c = _mm_crc32_u64(c, load64(data + i));
+            c1 = _mm_crc32_u64(c1, load64(data + kStride + i));
+            c2 = _mm_crc32_u64(c2, load64(data + 2 * kStride + i));
+        }
+        c = shiftCrc(c, kShiftTwo) ^ shiftCrc(c1, kShiftOne) ^ c2;
+    }
+    for (; size >= 8; data += 8, size -= 8) {
+        c = _mm_crc32_u64(c, load64(data));
+    }
+    for (; size > 0; ++data, --size) {
+        c = _mm_crc32_u8((uint32_t)c, *data);
+    }
+    return ~(uint32_t)c;
+}
+
+#endif // STEG_X86_KERNELS
+
+uint32_t crc32c(const uint8_t* data, uint64_t size, uint32_t crc) {
+    static const CrcKernel chosen = [] {
+        std::vector<CrcVariant> kernels = availableCrcKernels();
+        const char* pinned = std::getenv("STEG_KERNEL");
+        bool scalarOnly = pinned && std::strcmp(pinned, "scalar") == 0;
+        return scalarOnly ? kernels.front().update : kernels.back().update;
+    }();
+    return chosen(data, size, crc);
+}
+
+std::vector<CrcVariant> availableCrcKernels() {
+    std::vector<CrcVariant> kernels = {{"scalar", crc32cScalar}};
+#ifdef STEG_X86_KERNELS
+    if (cpuSupports("sse4.2") && cpuSupports("pclmul")) kernels.push_back({"sse4.2", crc32cSse42});
+#endif
+    return kernels;
+}
+
+} // namespace Steganography
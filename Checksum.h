@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Kernels.h"
+
+// --- Integrity Checksums ---
+// CRC32C (Castagnoli polynomial, as in iSCSI and ext4) guards the payload
+// header and, optionally, each payload chunk. Values are the standard CRC32C
+// (initial value and final XOR of 0xFFFFFFFF), so `crc` chains: the CRC of
+// A || B is crc32c(B, crc32c(A)).
+//
+// With SSE4.2 the CRC32 instruction runs three independent streams so its
+// latency is hidden, and PCLMULQDQ shifts the partial CRCs into place.
+// Elsewhere a slicing-by-8 table kernel does the work.
+namespace Steganography {
+
+typedef uint32_t (*CrcKernel)(const uint8_t* data, uint64_t size, uint32_t crc);
+
+struct CrcVariant {
+    const char* name;
+    CrcKernel update;
+};
+
+uint32_t crc32cScalar(const uint8_t* data, uint64_t size, uint32_t crc = 0);
+#ifdef STEG_X86_KERNELS
+// Only call it when cpuSupports() reports both "sse4.2" and "pclmul"
+uint32_t crc32cSse42(const uint8_t* data, uint64_t size, uint32_t crc = 0);
+#endif
+
+// Fastest CRC32C kernel this CPU can run; STEG_KERNEL=scalar pins the tables
+uint32_t crc32c(const uint8_t* data, uint64_t size, uint32_t crc = 0);
+
+// Every CRC32C kernel this CPU can run, scalar first
+std::vector<CrcVariant> availableCrcKernels();
+
+} // namespace Steganography
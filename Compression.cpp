@@ -0,0 +1,174 @@
+#include "Compression.h"
+
+#include <fstream>
+#include <lz4frame.h>
+#include <zstd.h>
+
+namespace Steganography {
+
+namespace {
+
+const size_t kReadBytes = 1 << 20; // Input block handed to the codec at a time
+const int kZstdLevel = 3;
+
+// Reads the next block of the file; false once the file is exhausted
+bool readBlock(std::ifstream& file, std::vector<char>& block, size_t& count) {
+    file.read(block.data(), (std::streamsize)block.size());
+    count = (size_t)file.gcount();
+    return count > 0;
+}
+
+std::string compressZstd(std::ifstream& file, std::vector<char>& out, uint64_t& rawBytes) {
+    ZSTD_CCtx* context = ZSTD_createCCtx();
+    if (!context) return "Error: Could not start the compressor.";
+    ZSTD_CCtx_setParameter(context, ZSTD_c_compressionLevel, kZstdLevel);
+
+    std::vector<char> block(kReadBytes);
+    std::string error;
+    bool last = false;
+    while (!last && error.empty()) {
+        size_t count = 0;
+        last = !readBlock(file, block, count) || file.eof();
+        rawBytes += count;
+
+        ZSTD_inBuffer input = {block.data(), count, 0};
+        const ZSTD_EndDirective mode = last ? ZSTD_e_end : ZSTD_e_continue;
+        size_t pending;
+        do {
+            size_t used = out.size();
+            out.resize(used + ZSTD_CStreamOutSize());
+            ZSTD_outBuffer output = {out.data() + used, ZSTD_CStreamOutSize(), 0};
+            pending = ZSTD_compressStream2(context, &output, &input, mode);
+            out.resize(used + output.pos);
+            if (ZSTD_isError(pending)) {
+                error = std::string("Error: Compression failed: ") + ZSTD_getErrorName(pending);
+                break;
+            }
+        } while (last ? pending != 0 : input.pos < input.size);
+    }
+    ZSTD_freeCCtx(context);
+    return error;
+}
+
+std::string compressLz4(std::ifstream& file, std::vector<char>& out, uint64_t& rawBytes) {
+    LZ4F_cctx* context = nullptr;
+    if (LZ4F_isError(LZ4F_createCompressionContext(&context, LZ4F_VERSION))) {
+        return "Error: Could not start the compressor.";
+    }
+
+    LZ4F_preferences_t preferences = LZ4F_INIT_PREFERENCES;
+    preferences.frameInfo.blockSizeID = LZ4F_max1MB;
+    const size_t bound = LZ4F_compressBound(kReadBytes, &preferences);
+
+    std::vector<char> block(kReadBytes);
+    out.resize(LZ4F_HEADER_SIZE_MAX);
+    size_t status = LZ4F_compressBegin(context, out.data(), out.size(), &preferences);
+    size_t used = LZ4F_isError(status) ? 0 : status;
+    bool more = true;
+    while (more && !LZ4F_isError(status)) {
+        size_t count = 0;
+        more = readBlock(file, block, count);
+        rawBytes += count;
+        out.resize(used + bound);
+        status = more ? LZ4F_compressUpdate(context, out.data() + used, bound, block.data(), count, nullptr)
+                      : LZ4F_compressEnd(context, out.data() + used, bound, nullptr);
+        if (!LZ4F_isError(status)) used += status;
+    }
+    out.resize(used);
+    LZ4F_freeCompressionContext(context);
+    if (LZ4F_isError(status)) {
+        return std::string("Error: Compression failed: ") + LZ4F_getErrorName(status);
+    }
+    return "";
+}
+
+std::string decompressZstd(const char* data, uint64_t size, std::ofstream& file, uint64_t& rawBytes) {
+    ZSTD_DCtx* context = ZSTD_createDCtx();
+    if (!context) return "Error: Could not start the decompressor.";
+
+    std::vector<char> block(ZSTD_DStreamOutSize());
+    ZSTD_inBuffer input = {data, (size_t)size, 0};
+    std::string error;
+    size_t pending = 1;
+    for (;;) {
+        ZSTD_outBuffer output = {block.data(), block.size(), 0};
+        pending = ZSTD_decompressStream(context, &output, &input);
+        if (ZSTD_isError(pending)) {
+            error = std::string("Error: Hidden data is not valid zstd: ") + ZSTD_getErrorName(pending);
+            break;
+        }
+        file.write(block.data(), (std::streamsize)output.pos);
+        rawBytes += output.pos;
+        // A full output block may leave decoded bytes buffered in the context
+        if (input.pos == input.size && output.pos < output.size) break;
+    }
+    if (error.empty() && pending != 0) error = "Error: Hidden zstd data is truncated.";
+    ZSTD_freeDCtx(context);
+    return error;
+}
+
+std::string decompressLz4(const char* data, uint64_t size, std::ofstream& file, uint64_t& rawBytes) {
+    LZ4F_dctx* context = nullptr;
+    if (LZ4F_isError(LZ4F_createDecompressionContext(&context, LZ4F_VERSION))) {
+        return "Error: Could not start the decompressor.";
+    }
+
+    std::vector<char> block(kReadBytes);
+    uint64_t consumed = 0;
+    size_t hint = 1;
+    std::string error;
+    while (consumed < size && hint != 0) {
+        size_t produced = block.size();
+        size_t taken = (size_t)(size - consumed);
+        hint = LZ4F_decompress(context, block.data(), &produced, data + consumed, &taken, nullptr);
+        if (LZ4F_isError(hint)) {
+            error = std::string("Error: Hidden data is not valid LZ4: ") + LZ4F_getErrorName(hint);
+            break;
+        }
+        consumed += taken;
+        file.write(block.data(), (std::streamsize)produced);
+        rawBytes += produced;
+    }
+    if (error.empty() && hint != 0) error = "Error: Hidden LZ4 data is truncated.";
+    LZ4F_freeDecompressionContext(context);
+    return error;
+}
+
+} // namespace
+
+std::string compressFile(const std::string& path, Compression codec, std::vector<char>& out, uint64_t& rawBytes) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return "Error: Could not open secret file.";
+    }
+    out.clear();
+    rawBytes = 0;
+    if (codec == Compression::Zstd) return compressZstd(file, out, rawBytes);
+    if (codec == Compression::Lz4) return compressLz4(file, out, rawBytes);
+    out.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    rawBytes = out.size();
+    return "";
+}
+
+std::string decompressToFile(const char* data, uint64_t size, Compression codec, const std::string& path,
+                             uint64_t& rawBytes) {
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+        return "Error: Could not create output file for decoded data.";
+    }
+    rawBytes = 0;
+    std::string error;
+    if (codec == Compression::Zstd) {
+        error = decompressZstd(data, size, file, rawBytes);
+    } else if (codec == Compression::Lz4) {
+        error = decompressLz4(data, size, file, rawBytes);
+    } else {
+        file.write(data, (std::streamsize)size);
+        rawBytes = size;
+    }
+    file.close();
+    if (error.empty() && !file) error = "Error: Could not write the decoded data.";
+    return error;
+}
+
+} // namespace Steganography
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// --- Payload Compression ---
+// The secret file can be compressed on its way into the carrier: the file is
+// streamed through the codec block by block, so only the compressed bytes are
+// ever held in memory, and the decoder streams the extracted bytes back out
+// to the output file through a fixed-size buffer. Both codecs write their
+// standard frame format, so an extracted payload is also a valid .zst/.lz4.
+namespace Steganography {
+
+enum class Compression {
+    None, // Raw bytes
+    Zstd, // Zstandard, level 3: best ratio per CPU time for logs and JSON
+    Lz4   // LZ4 frame: lower ratio, several times faster than zstd
+};
+
+// Streams the file at `path` through `codec` into `out` (replacing its
+// contents) and sets `rawBytes` to the file size. Returns "" or an error
+// message.
+std::string compressFile(const std::string& path, Compression codec, std::vector<char>& out, uint64_t& rawBytes);
+
+// Streams `size` compressed bytes through `codec` into the file at `path`
+// and sets `rawBytes` to the bytes written. Returns "" or an error message.
+std::string decompressToFile(const char* data, uint64_t size, Compression codec, const std::string& path,
+                             uint64_t& rawBytes);
+
+} // namespace Steganography
@@ -0,0 +1,243 @@
+#include "CostMap.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#include "Kernels.h"
+#include "Parallel.h"
+
+#ifdef STEG_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace Steganography {
+
+namespace {
+
+const unsigned kMaxRadius = 2;
+const uint64_t kRowsPerPiece = 32;
+
+unsigned radiusOf(CostFilter filter) {
+    return filter == CostFilter::Variance5x5 ? 2 : 1;
+}
+
+// --- Row Kernels ---
+// The map is built one output row at a time: luma rows of the window are
+// summed down each column, then the column sums are summed across the
+// window and turned into a cost. Column sum arrays are padded by the radius
+// on both sides so the horizontal pass never needs a bounds check.
+struct RowKernels {
+    // luma[x] = (R + 2G + B) / 4 and squared[x] = luma[x]^2
+    void (*luma)(const uint8_t* rgba, unsigned width, float* luma, float* squared);
+    // sum[x] = rows[0][x] + ... + rows[count - 1][x]
+    void (*columnSums)(const float* const* rows, unsigned count, unsigned width, float* sum);
+    // out[x] from the padded column sums sum[x .. x + 2r] and the center luma
+    void (*costs)(const float* center, const float* sum, const float* sumSq, unsigned width, unsigned radius,
+                  CostFilter filter, float* out);
+};
+
+void lumaScalar(const uint8_t* rgba, unsigned width, float* luma, float* squared) {
+    for (unsigned x = 0; x < width; ++x) {
+        const uint8_t* p = rgba + 4 * x;
+        float value = (float)(p[0] + 2 * p[1] + p[2]) * 0.25f;
+        luma[x] = value;
+        squared[x] = value * value;
+    }
+}
+
+void columnSumsScalar(const float* const* rows, unsigned count, unsigned width, float* sum) {
+    for (unsigned x = 0; x < width; ++x) {
+        float s = rows[0][x];
+        for (unsigned r = 1; r < count; ++r) s += rows[r][x];
+        sum[x] = s;
+    }
+}
+
+void costsScalar(const float* center, const float* sum, const float* sumSq, unsigned width, unsigned radius,
+                 CostFilter filter, float* out) {
+    const unsigned taps = 2 * radius + 1;
+    const float inverseArea = 1.0f / (float)(taps * taps);
+    for (unsigned x = 0; x < width; ++x) {
+        float s = sum[x];
+        for (unsigned dx = 1; dx < taps; ++dx) s += sum[x + dx];
+        float activity;
+        if (filter == CostFilter::HighPass3x3) {
+            activity = std::fabs(9.0f * center[x] - s) * 0.125f;
+        } else {
+            float q = sumSq[x];
+            for (unsigned dx = 1; dx < taps; ++dx) q += sumSq[x + dx];
+            float mean = s * inverseArea;
+            activity = std::max(q * inverseArea - mean * mean, 0.0f);
+        }
+        out[x] = 1.0f / (1.0f + activity);
+    }
+}
+
+#ifdef STEG_X86_KERNELS
+
+// 8 pixels per vector: one 32-bit lane per RGBA pixel
+STEG_TARGET("avx2")
+void lumaAvx2(const uint8_t* rgba, unsigned width, float* luma, float* squared) {
+    const __m256i byteMask = _mm256_set1_epi32(0xFF);
+    const __m256 quarter = _mm256_set1_ps(0.25f);
+    unsigned x = 0;
+    for (; x + 8 <= width; x += 8) {
+        __m256i p = _mm256_loadu_si256((const __m256i*)(rgba + 4 * x));
+        __m256i r = _mm256_and_si256(p, byteMask);
+        __m256i g = _mm256_and_si256(_mm256_srli_epi32(p, 8), byteMask);
+        __m256i b = _mm256_and_si256(_mm256_srli_epi32(p, 16), byteMask);
+        __m256i weighted = _mm256_add_epi32(_mm256_add_epi32(r, b), _mm256_add_epi32(g, g));
+        __m256 value = _mm256_mul_ps(_mm256_cvtepi32_ps(weighted), quarter);
+        _mm256_storeu_ps(luma + x, value);
+        _mm256_storeu_ps(squared + x, _mm256_mul_ps(value, value));
+    }
+    lumaScalar(rgba + 4 * x, width - x, luma + x, squared + x);
+}
+
+STEG_TARGET("avx2")
+void columnSumsAvx2(const float* const* rows, unsigned count, unsigned width, float* sum) {
+    unsigned x = 0;
+    for (; x + 8 <= width; x += 8) {
+        __m256 s = _mm256_loadu_ps(rows[0] + x);
+        for (unsigned r = 1; r < count; ++r) s = _mm256_add_ps(s, _mm256_loadu_ps(rows[r] + x));
+        _mm256_storeu_ps(sum + x, s);
+    }
+    for (; x < width; ++x) {
+        float s = rows[0][x];
+        for (unsigned r = 1; r < count; ++r) s += rows[r][x];
+        sum[x] = s;
+    }
+}
+
+// Same operations in the same order as costsScalar, so both give
+// bit-identical maps
+STEG_TARGET("avx2")
+void costsAvx2(const float* center, const float* sum, const float* sumSq, unsigned width, unsigned radius,
+               CostFilter filter, float* out) {
+    const unsigned taps = 2 * radius + 1;
+    const __m256 inverseArea = _mm256_set1_ps(1.0f / (float)(taps * taps));
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 nine = _mm256_set1_ps(9.0f);
+    const __m256 eighth = _mm256_set1_ps(0.125f);
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+    unsigned x = 0;
+    for (; x + 8 <= width; x += 8) {
+        __m256 s = _mm256_loadu_ps(sum + x);
+        for (unsigned dx = 1; dx < taps; ++dx) s = _mm256_add_ps(s, _mm256_loadu_ps(sum + x + dx));
+        __m256 activity;
+        if (filter == CostFilter::HighPass3x3) {
+            __m256 residual = _mm256_sub_ps(_mm256_mul_ps(nine, _mm256_loadu_ps(center + x)), s);
+            activity = _mm256_mul_ps(_mm256_and_ps(residual, absMask), eighth);
+        } else {
+            __m256 q = _mm256_loadu_ps(sumSq + x);
+            for (unsigned dx = 1; dx < taps; ++dx) q = _mm256_add_ps(q, _mm256_loadu_ps(sumSq + x + dx));
+            __m256 mean = _mm256_mul_ps(s, inverseArea);
+            activity = _mm256_sub_ps(_mm256_mul_ps(q, inverseArea), _mm256_mul_ps(mean, mean));
+            activity = _mm256_max_ps(activity, _mm256_setzero_ps());
+        }
+        _mm256_storeu_ps(out + x, _mm256_div_ps(one, _mm256_add_ps(one, activity)));
+    }
+    costsScalar(center + x, sum + x, sumSq + x, width - x, radius, filter, out + x);
+}
+
+#endif // STEG_X86_KERNELS
+
+const RowKernels kScalarRows = {lumaScalar, columnSumsScalar, costsScalar};
+#ifdef STEG_X86_KERNELS
+const RowKernels kAvx2Rows = {lumaAvx2, columnSumsAvx2, costsAvx2};
+#endif
+
+// STEG_KERNEL=scalar pins the scalar row kernels, like it does for the LSB kernels
+const RowKernels& rowKernels() {
+#ifdef STEG_X86_KERNELS
+    static const bool useAvx2 = [] {
+        const char* pinned = std::getenv("STEG_KERNEL");
+        return !(pinned && std::strcmp(pinned, "scalar") == 0) && cpuSupports("avx2");
+    }();
+    if (useAvx2) return kAvx2Rows;
+#endif
+    return kScalarRows;
+}
+
+std::vector<float> buildCostMap(const RowKernels& kernels, const uint8_t* pixels, unsigned width, unsigned height,
+                                CostFilter filter, unsigned threads) {
+    std::vector<float> costs((size_t)width * height, 1.0f);
+    if (filter == CostFilter::None || width == 0 || height == 0) {
+        return costs;
+    }
+
+    const unsigned radius = radiusOf(filter);
+    const unsigned taps = 2 * radius + 1;
+    const bool variance = filter != CostFilter::HighPass3x3;
+
+    parallelFor(height, kRowsPerPiece, threads, [&](uint64_t begin, uint64_t end) {
+        // Ring of the luma rows in the window; slot i holds virtual row
+        // y with y mod taps == i, where rows past the edges repeat the border
+        std::vector<float> ring((size_t)taps * 2 * width);
+        std::vector<float> sum(width + 2 * radius), sumSq(width + 2 * radius);
+        auto slot = [&](int64_t row) { return (size_t)(((row % taps) + taps) % taps) * 2 * width; };
+        auto load = [&](int64_t row) {
+            int64_t clamped = std::min<int64_t>(std::max<int64_t>(row, 0), (int64_t)height - 1);
+            float* luma = &ring[slot(row)];
+            kernels.luma(pixels + (size_t)clamped * width * 4, width, luma, luma + width);
+        };
+
+        for (int64_t row = (int64_t)begin - radius; row < (int64_t)begin + (int64_t)radius; ++row) {
+            load(row);
+        }
+        for (uint64_t y = begin; y < end; ++y) {
+            load((int64_t)y + radius);
+            const float* lumaRows[2 * kMaxRadius + 1];
+            const float* squaredRows[2 * kMaxRadius + 1];
+            for (unsigned dy = 0; dy < taps; ++dy) {
+                const float* luma = &ring[slot((int64_t)y - radius + dy)];
+                lumaRows[dy] = luma;
+                squaredRows[dy] = luma + width;
+            }
+
+            kernels.columnSums(lumaRows, taps, width, sum.data() + radius);
+            if (variance) kernels.columnSums(squaredRows, taps, width, sumSq.data() + radius);
+            for (unsigned p = 0; p < radius; ++p) {
+                sum[p] = sum[radius];
+                sum[radius + width + p] = sum[radius + width - 1];
+                sumSq[p] = sumSq[radius];
+                sumSq[radius + width + p] = sumSq[radius + width - 1];
+            }
+            kernels.costs(lumaRows[radius], sum.data(), sumSq.data(), width, radius, filter,
+                          costs.data() + (size_t)y * width);
+        }
+        return true;
+    });
+    return costs;
+}
+
+std::vector<float> costMapScalar(const uint8_t* pixels, unsigned width, unsigned height, CostFilter filter,
+                                 unsigned threads) {
+    return buildCostMap(kScalarRows, pixels, width, height, filter, threads);
+}
+
+#ifdef STEG_X86_KERNELS
+std::vector<float> costMapAvx2(const uint8_t* pixels, unsigned width, unsigned height, CostFilter filter,
+                               unsigned threads) {
+    return buildCostMap(kAvx2Rows, pixels, width, height, filter, threads);
+}
+#endif
+
+} // namespace
+
+std::vector<CostMapVariant> availableCostMapKernels() {
+    std::vector<CostMapVariant> kernels = {{"scalar", costMapScalar}};
+#ifdef STEG_X86_KERNELS
+    if (cpuSupports("avx2")) kernels.push_back({"avx2", costMapAvx2});
+#endif
+    return kernels;
+}
+
+std::vector<float> computeCostMap(const uint8_t* pixels, unsigned width, unsigned height, CostFilter filter,
+                                  unsigned threads) {
+    return buildCostMap(rowKernels(), pixels, width, height, filter, threads);
+}
+
+} // namespace Steganography
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// --- Adaptive Cost Maps ---
+// Per-pixel flip costs for the trellis embedder: low in textured regions
+// where a changed LSB hides in the noise, high in flat regions where it
+// stands out. Costs come from the luma plane (R + 2G + B) / 4 and lie in
+// (0, 1]: 1 / (1 + activity), where activity is the local variance or the
+// magnitude of a high-pass residual.
+namespace Steganography {
+
+enum class CostFilter {
+    None,        // Uniform costs
+    Variance3x3, // Luma variance over the 3x3 neighbourhood
+    Variance5x5, // Luma variance over the 5x5 neighbourhood
+    HighPass3x3  // |8 * center - sum of the 8 neighbours| / 8
+};
+
+// Cost of each pixel of a width x height RGBA8 buffer, row by row. Rows
+// are split over `threads` workers (0 = one per hardware thread). Edges
+// repeat the border pixels.
+std::vector<float> computeCostMap(const uint8_t* pixels, unsigned width, unsigned height, CostFilter filter,
+                                  unsigned threads = 0);
+
+// computeCostMap through one set of row kernels. Every set must give maps
+// bit-identical to the scalar one, or trellis embeds would vary by CPU.
+typedef std::vector<float> (*CostMapKernel)(const uint8_t* pixels, unsigned width, unsigned height,
+                                            CostFilter filter, unsigned threads);
+
+struct CostMapVariant {
+    const char* name;
+    CostMapKernel compute;
+};
+
+// Every set of cost map row kernels this CPU can run, scalar first
+std::vector<CostMapVariant> availableCostMapKernels();
+
+} // namespace Steganography
@@ -0,0 +1,201 @@
+#include "Encryption.h"
+
+#include <algorithm>
+#include <cstring>
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+
+#include "Parallel.h"
+
+namespace Steganography {
+
+namespace {
+
+const size_t kSaltBytes = 16;
+const size_t kPrefixBytes = 8;
+const size_t kKeyBytes = 32;
+const size_t kTagBytes = 16;
+
+// scrypt cost: 2^14 x 8 x 128 B = 16 MiB (the interactive setting from the
+// scrypt paper) and some tens of milliseconds, paid once per job
+const uint64_t kScryptN = 1 << 14;
+const uint64_t kScryptR = 8;
+const uint64_t kScryptP = 1;
+const uint64_t kScryptMaxMemory = 64 << 20;
+
+// At least one segment, so an empty payload still carries a tag
+uint64_t segmentCount(uint64_t plainBytes) {
+    return std::max<uint64_t>(1, (plainBytes + kSealSegmentBytes - 1) / kSealSegmentBytes);
+}
+
+// Inverts sealedSize: every segment but the last is full. Returns "" or an
+// error message.
+std::string plainSizeOf(uint64_t size, uint64_t& plainBytes, uint64_t& segments) {
+    if (size < kSealHeaderBytes + kTagBytes) {
+        return "Error: Hidden data is too short to be encrypted.";
+    }
+    const uint64_t body = size - kSealHeaderBytes;
+    segments = (body + kSealSegmentBytes + kTagBytes - 1) / (kSealSegmentBytes + kTagBytes);
+    plainBytes = body - segments * kTagBytes;
+    if (sealedSize(plainBytes) != size) {
+        return "Error: Hidden data is not a valid encrypted payload.";
+    }
+    return "";
+}
+
+// Holds a derived key and wipes it when the job is done
+struct Key {
+    unsigned char bytes[kKeyBytes];
+    ~Key() { OPENSSL_cleanse(bytes, sizeof(bytes)); }
+};
+
+bool deriveKey(const std::string& passphrase, const unsigned char* salt, unsigned char* key) {
+    return EVP_PBE_scrypt(passphrase.data(), passphrase.size(), salt, kSaltBytes, kScryptN, kScryptR, kScryptP,
+                          kScryptMaxMemory, key, kKeyBytes) == 1;
+}
+
+// Nonce of segment `index`: the prefix, then the index little-endian
+void segmentNonce(const unsigned char* prefix, uint64_t index, unsigned char* nonce) {
+    std::memcpy(nonce, prefix, kPrefixBytes);
+    for (size_t i = 0; i < 4; ++i) nonce[kPrefixBytes + i] = (unsigned char)(index >> (8 * i));
+}
+
+// Seals or opens segments [begin, end) with one cipher context. `in` and
+// `out` point at segment `begin` of their respective streams.
+bool processSegments(const unsigned char* key, const unsigned char* prefix, uint64_t plainBytes, uint64_t begin, uint64_t end,
+                     bool sealing, const unsigned char* in, unsigned char* out) {
+    EVP_CIPHER_CTX* context = EVP_CIPHER_CTX_new();
+    if (!context) return false;
+    bool ok = EVP_CipherInit_ex(context, EVP_chacha20_poly1305(), nullptr, key, nullptr, sealing ? 1 : 0) == 1;
+
+    const uint64_t last = segmentCount(plainBytes) - 1;
+    for (uint64_t s = begin; ok && s < end; ++s) {
+        const int length = (int)std::min<uint64_t>(kSealSegmentBytes, plainBytes - s * kSealSegmentBytes);
+        const unsigned char final = s == last ? 1 : 0;
+        unsigned char nonce[kPrefixBytes + 4];
+        segmentNonce(prefix, s, nonce);
+
+        int written = 0;
+        ok = EVP_CipherInit_ex(context, nullptr, nullptr, nullptr, nonce, -1) == 1 &&
+             EVP_CipherUpdate(context, nullptr, &written, &final, 1) == 1;
+        if (sealing) {
+            ok = ok && EVP_CipherUpdate(context, out, &written, in, length) == 1 &&
+                 EVP_CipherFinal_ex(context, out + written, &written) == 1 &&
+                 EVP_CIPHER_CTX_ctrl(context, EVP_CTRL_AEAD_GET_TAG, kTagBytes, out + length) == 1;
+            in += length;
+            out += length + kTagBytes;
+        } else {
+            ok = ok && EVP_CipherUpdate(context, out, &written, in, length) == 1 &&
+                 EVP_CIPHER_CTX_ctrl(context, EVP_CTRL_AEAD_SET_TAG, kTagBytes, (void*)(in + length)) == 1 &&
+                 EVP_CipherFinal_ex(context, out + written, &written) == 1;
+            in += length + kTagBytes;
+            out += length;
+        }
+    }
+    EVP_CIPHER_CTX_free(context);
+    return ok;
+}
+
+} // namespace
+
+uint64_t sealedSize(uint64_t plainBytes) {
+    return kSealHeaderBytes + plainBytes + segmentCount(plainBytes) * kTagBytes;
+}
+
+std::string seal(const std::string& passphrase, const char* plain, uint64_t size, std::vector<char>& sealed,
+                 unsigned threads) {
+    sealed.resize(sealedSize(size));
+    unsigned char* header = reinterpret_cast<unsigned char*>(sealed.data());
+    if (RAND_bytes(header, (int)kSealHeaderBytes) != 1) {
+        return "Error: Could not generate a random salt.";
+    }
+    Key key;
+    if (!deriveKey(passphrase, header, key.bytes)) {
+        return "Error: Could not derive the encryption key.";
+    }
+
+    const unsigned char* prefix = header + kSaltBytes;
+    const unsigned char* in = reinterpret_cast<const unsigned char*>(plain);
+    unsigned char* out = header + kSealHeaderBytes;
+    bool ok = parallelFor(segmentCount(size), 4, threads, [&](uint64_t begin, uint64_t end) {
+        return processSegments(key.bytes, prefix, size, begin, end, true, in + begin * kSealSegmentBytes,
+                               out + begin * (kSealSegmentBytes + kTagBytes));
+    });
+    return ok ? "" : "Error: Encryption failed.";
+}
+
+std::string open(const std::string& passphrase, const char* sealed, uint64_t size, std::vector<char>& plain,
+                 unsigned threads) {
+    uint64_t plainBytes = 0, segments = 0;
+    std::string invalid = plainSizeOf(size, plainBytes, segments);
+    if (!invalid.empty()) {
+        return invalid;
+    }
+
+    const unsigned char* header = reinterpret_cast<const unsigned char*>(sealed);
+    Key key;
+    if (!deriveKey(passphrase, header, key.bytes)) {
+        return "Error: Could not derive the encryption key.";
+    }
+
+    plain.resize(plainBytes);
+    const unsigned char* prefix = header + kSaltBytes;
+    const unsigned char* in = header + kSealHeaderBytes;
+    unsigned char* out = reinterpret_cast<unsigned char*>(plain.data());
+    bool ok = parallelFor(segments, 4, threads, [&](uint64_t begin, uint64_t end) {
+        return processSegments(key.bytes, prefix, plainBytes, begin, end, false,
+                               in + begin * (kSealSegmentBytes + kTagBytes), out + begin * kSealSegmentBytes);
+    });
+    if (!ok) {
+        plain.clear();
+        return "Error: Decryption failed: wrong passphrase or corrupted data.";
+    }
+    return "";
+}
+
+SealedReader::SealedReader(const std::string& passphrase, const char* header, uint64_t sealedBytes) {
+    uint64_t segments = 0;
+    failure = plainSizeOf(sealedBytes, plainBytes, segments);
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(header);
+    if (failure.empty() && !deriveKey(passphrase, bytes, key)) {
+        failure = "Error: Could not derive the encryption key.";
+    }
+    std::memcpy(prefix, bytes + kSaltBytes, kPrefixBytes);
+}
+
+SealedReader::~SealedReader() {
+    OPENSSL_cleanse(key, sizeof(key));
+}
+
+void SealedReader::span(uint64_t begin, uint64_t end, uint64_t& sealedBegin, uint64_t& sealedEnd,
+                        uint64_t& plainStart) const {
+    const uint64_t first = begin / kSealSegmentBytes;
+    const uint64_t last = std::max(end, begin + 1) - 1;
+    const uint64_t stride = kSealSegmentBytes + kTagBytes;
+    plainStart = first * kSealSegmentBytes;
+    sealedBegin = kSealHeaderBytes + first * stride;
+    sealedEnd = std::min(sealedSize(plainBytes), kSealHeaderBytes + (last / kSealSegmentBytes + 1) * stride);
+}
+
+std::string SealedReader::open(const char* sealed, uint64_t sealedBegin, uint64_t sealedEnd, std::vector<char>& plain,
+                               unsigned threads) const {
+    const uint64_t stride = kSealSegmentBytes + kTagBytes;
+    const uint64_t first = (sealedBegin - kSealHeaderBytes) / stride;
+    const uint64_t segments = (sealedEnd - sealedBegin + stride - 1) / stride;
+    const uint64_t plainStart = first * kSealSegmentBytes;
+    plain.resize(std::min(plainBytes - plainStart, segments * kSealSegmentBytes));
+    const unsigned char* in = reinterpret_cast<const unsigned char*>(sealed);
+    unsigned char* out = reinterpret_cast<unsigned char*>(plain.data());
+    bool ok = parallelFor(segments, 4, threads, [&](uint64_t begin, uint64_t end) {
+        return processSegments(key, prefix, plainBytes, first + begin, first + end, false, in + begin * stride,
+                               out + begin * kSealSegmentBytes);
+    });
+    if (!ok) {
+        plain.clear();
+        return "Error: Decryption failed: wrong passphrase or corrupted data.";
+    }
+    return "";
+}
+
+} // namespace Steganography
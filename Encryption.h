@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// --- Payload Encryption ---
+// Payloads can be sealed with ChaCha20-Poly1305 (OpenSSL's vectorized
+// implementation) before they are embedded. The key is derived from a
+// passphrase with scrypt and a random salt.
+//
+// The payload is cut into segments of kSealSegmentBytes, each sealed on its
+// own (the STREAM construction): the nonce is a random prefix followed by the
+// segment index, and the last segment is marked in its associated data. The
+// segments seal and open in parallel, and reordered, dropped or truncated
+// segments fail authentication like any other change.
+//
+// Sealed layout: salt (16) | nonce prefix (8) | segment 0 | tag 0 | segment 1 | ...
+namespace Steganography {
+
+const uint64_t kSealSegmentBytes = 64 * 1024;
+const uint64_t kSealHeaderBytes = 24; // Salt and nonce prefix
+
+// Sealed size of `plainBytes` bytes
+uint64_t sealedSize(uint64_t plainBytes);
+
+// Seals `size` bytes into `sealed` on up to `threads` workers. Returns "" or
+// an error message.
+std::string seal(const std::string& passphrase, const char* plain, uint64_t size, std::vector<char>& sealed,
+                 unsigned threads = 0);
+
+// Opens sealed data into `plain`; fails on a wrong passphrase or any change
+// to the sealed bytes. Returns "" or an error message.
+std::string open(const std::string& passphrase, const char* sealed, uint64_t size, std::vector<char>& plain,
+                 unsigned threads = 0);
+
+// Opens parts of a sealed payload without the rest: every segment opens on
+// its own, so a plain byte range needs only the sealed segments that cover
+// it. The key is derived once, when the reader is made.
+class SealedReader {
+public:
+    // `header` is the first kSealHeaderBytes of a sealed payload of
+    // `sealedBytes` bytes. Check error() before anything else.
+    SealedReader(const std::string& passphrase, const char* header, uint64_t sealedBytes);
+    ~SealedReader();
+    SealedReader(const SealedReader&) = delete;
+    SealedReader& operator=(const SealedReader&) = delete;
+
+    // "" or why the payload cannot be opened
+    const std::string& error() const { return failure; }
+    uint64_t plainSize() const { return plainBytes; }
+
+    // Sealed bytes [sealedBegin, sealedEnd) cover plain bytes [begin, end);
+    // they open into plain bytes starting at plainStart (segment aligned)
+    void span(uint64_t begin, uint64_t end, uint64_t& sealedBegin, uint64_t& sealedEnd, uint64_t& plainStart) const;
+
+    // Opens sealed bytes [sealedBegin, sealedEnd) from span() into `plain`.
+    // Returns "" or an error message.
+    std::string open(const char* sealed, uint64_t sealedBegin, uint64_t sealedEnd, std::vector<char>& plain,
+                     unsigned threads = 0) const;
+
+private:
+    unsigned char key[32];
+    unsigned char prefix[8];
+    uint64_t plainBytes = 0;
+    std::string failure;
+};
+
+} // namespace Steganography
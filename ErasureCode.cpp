@@ -0,0 +1,295 @@
+#include "ErasureCode.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include "Parallel.h"
+
+#ifdef STEG_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace Steganography {
+
+namespace {
+
+// x^8 + x^4 + x^3 + x^2 + 1, for which x generates the multiplicative group
+const unsigned kPoly = 0x11D;
+
+// Shard bytes per parallel piece: the sources of a piece stay in L2
+const uint64_t kPieceBytes = 64 << 10;
+
+struct GfTables {
+    uint8_t exp[512]; // Doubled so exp[log a + log b] needs no reduction
+    uint8_t log[256];
+    uint8_t mul[256][256];
+
+    GfTables() {
+        unsigned x = 1;
+        for (unsigned i = 0; i < 255; ++i) {
+            exp[i] = exp[i + 255] = (uint8_t)x;
+            log[x] = (uint8_t)i;
+            x <<= 1;
+            if (x & 0x100) x ^= kPoly;
+        }
+        exp[510] = exp[511] = exp[0];
+        log[0] = 0;
+        for (unsigned a = 0; a < 256; ++a) {
+            for (unsigned b = 0; b < 256; ++b) {
+                mul[a][b] = (a && b) ? exp[log[a] + log[b]] : 0;
+            }
+        }
+    }
+};
+
+const GfTables& gfTables() {
+    static const GfTables tables;
+    return tables;
+}
+
+// Cauchy coefficient of data shard `column` in parity shard `row`
+uint8_t cauchy(unsigned row, unsigned column, unsigned dataCount) {
+    return gfInverse((uint8_t)((dataCount + row) ^ column));
+}
+
+// Runs `dot` over [0, size) in pieces spread over the workers, with the
+// sources advanced to each piece
+void dotPieces(GfDotKernel dot, const std::vector<const uint8_t*>& sources, const uint8_t* coefficients,
+               uint8_t* out, uint64_t size, unsigned threads) {
+    parallelFor(size, kPieceBytes, threads, [&](uint64_t begin, uint64_t end) {
+        std::vector<const uint8_t*> piece(sources.size());
+        for (size_t j = 0; j < sources.size(); ++j) piece[j] = sources[j] + begin;
+        dot(piece.data(), coefficients, (unsigned)sources.size(), out + begin, end - begin);
+        return true;
+    });
+}
+
+#ifdef STEG_X86_KERNELS
+
+// Products of a coefficient with every low nibble (bytes 0-15) and every
+// high nibble (bytes 16-31)
+void nibbleTables(const uint8_t* coefficients, unsigned count, std::vector<uint8_t>& tables) {
+    const GfTables& t = gfTables();
+    tables.resize((size_t)count * 32);
+    for (unsigned j = 0; j < count; ++j) {
+        for (unsigned x = 0; x < 16; ++x) {
+            tables[32 * j + x] = t.mul[coefficients[j]][x];
+            tables[32 * j + 16 + x] = t.mul[coefficients[j]][x << 4];
+        }
+    }
+}
+
+// Bytes [done, size) through the scalar kernel
+void dotTail(const uint8_t* const* sources, const uint8_t* coefficients, unsigned count, uint8_t* out,
+             uint64_t done, uint64_t size) {
+    if (done == size) return;
+    std::vector<const uint8_t*> tail(count);
+    for (unsigned j = 0; j < count; ++j) tail[j] = sources[j] + done;
+    gfDotScalar(tail.data(), coefficients, count, out + done, size - done);
+}
+
+#endif // STEG_X86_KERNELS
+
+} // namespace
+
+uint8_t gfMul(uint8_t a, uint8_t b) {
+    return gfTables().mul[a][b];
+}
+
+uint8_t gfInverse(uint8_t a) {
+    const GfTables& t = gfTables();
+    return t.exp[255 - t.log[a]];
+}
+
+void gfDotScalar(const uint8_t* const* sources, const uint8_t* coefficients, unsigned count, uint8_t* out,
+                 uint64_t size) {
+    const GfTables& t = gfTables();
+    std::memset(out, 0, size);
+    for (unsigned j = 0; j < count; ++j) {
+        const uint8_t* row = t.mul[coefficients[j]];
+        const uint8_t* source = sources[j];
+        for (uint64_t i = 0; i < size; ++i) out[i] ^= row[source[i]];
+    }
+}
+
+#ifdef STEG_X86_KERNELS
+
+STEG_TARGET("ssse3")
+void gfDotSsse3(const uint8_t* const* sources, const uint8_t* coefficients, unsigned count, uint8_t* out,
+                uint64_t size) {
+    std::vector<uint8_t> tables;
+    nibbleTables(coefficients, count, tables);
+    const __m128i low = _mm_set1_epi8(0x0F);
+    uint64_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        __m128i sum = _mm_setzero_si128();
+        for (unsigned j = 0; j < count; ++j) {
+            __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sources[j] + i));
+            __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&tables[32 * j]));
+            __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&tables[32 * j + 16]));
+            sum = _mm_xor_si128(sum, _mm_shuffle_epi8(lo, _mm_and_si128(x, low)));
+            sum = _mm_xor_si128(sum, _mm_shuffle_epi8(hi, _mm_and_si128(_mm_srli_epi64(x, 4), low)));
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), sum);
+    }
+    dotTail(sources, coefficients, count, out, i, size);
+}
+
+// Two vectors per step, so each source's tables are loaded once per 64 bytes
+STEG_TARGET("avx2")
+void gfDotAvx2(const uint8_t* const* sources, const uint8_t* coefficients, unsigned count, uint8_t* out,
+               uint64_t size) {
+    std::vector<uint8_t> tables;
+    nibbleTables(coefficients, count, tables);
+    const __m256i low = _mm256_set1_epi8(0x0F);
+    uint64_t i = 0;
+    for (; i + 64 <= size; i += 64) {
+        __m256i sum0 = _mm256_setzero_si256(), sum1 = _mm256_setzero_si256();
+        for (unsigned j = 0; j < count; ++j) {
+            __m256i lo = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&tables[32 * j])));
+            __m256i hi =
+                _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&tables[32 * j + 16])));
+            __m256i x0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(sources[j] + i));
+            __m256i x1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(sources[j] + i + 32));
+            sum0 = _mm256_xor_si256(sum0, _mm256_shuffle_epi8(lo, _mm256_and_si256(x0, low)));
+            sum0 = _mm256_xor_si256(sum0, _mm256_shuffle_epi8(hi, _mm256_and_si256(_mm256_srli_epi64(x0, 4), low)));
+            sum1 = _mm256_xor_si256(sum1, _mm256_shuffle_epi8(lo, _mm256_and_si256(x1, low)));
+            sum1 = _mm256_xor_si256(sum1, _mm256_shuffle_epi8(hi, _mm256_and_si256(_mm256_srli_epi64(x1, 4), low)));
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), sum0);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i + 32), sum1);
+    }
+    dotTail(sources, coefficients, count, out, i, size);
+}
+
+// Multiplying by a constant is linear over GF(2): output bit r is the parity
+// of the input bits selected by row r of an 8x8 matrix, which
+// GF2P8AFFINEQB takes as a qword with row r in byte 7 - r. Unlike
+// GF2P8MULB, this works for any field polynomial.
+STEG_TARGET("gfni,avx2")
+void gfDotGfni(const uint8_t* const* sources, const uint8_t* coefficients, unsigned count, uint8_t* out,
+               uint64_t size) {
+    const GfTables& t = gfTables();
+    std::vector<uint64_t> matrices(count);
+    for (unsigned j = 0; j < count; ++j) {
+        uint64_t matrix = 0;
+        for (unsigned row = 0; row < 8; ++row) {
+            uint64_t bits = 0;
+            for (unsigned column = 0; column < 8; ++column) {
+                bits |= (uint64_t)((t.mul[coefficients[j]][1u << column] >> row) & 1) << column;
+            }
+            matrix |= bits << (8 * (7 - row));
+        }
+        matrices[j] = matrix;
+    }
+    uint64_t i = 0;
+    for (; i + 64 <= size; i += 64) {
+        __m256i sum0 = _mm256_setzero_si256(), sum1 = _mm256_setzero_si256();
+        for (unsigned j = 0; j < count; ++j) {
+            __m256i matrix = _mm256_set1_epi64x((long long)matrices[j]);
+            __m256i x0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(sources[j] + i));
+            __m256i x1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(sources[j] + i + 32));
+            sum0 = _mm256_xor_si256(sum0, _mm256_gf2p8affine_epi64_epi8(x0, matrix, 0));
+            sum1 = _mm256_xor_si256(sum1, _mm256_gf2p8affine_epi64_epi8(x1, matrix, 0));
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), sum0);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i + 32), sum1);
+    }
+    dotTail(sources, coefficients, count, out, i, size);
+}
+
+#endif // STEG_X86_KERNELS
+
+std::vector<GfVariant> availableGfKernels() {
+    std::vector<GfVariant> kernels = {{"scalar", gfDotScalar}};
+#ifdef STEG_X86_KERNELS
+    if (cpuSupports("ssse3")) kernels.push_back({"ssse3", gfDotSsse3});
+    if (cpuSupports("avx2")) kernels.push_back({"avx2", gfDotAvx2});
+    if (cpuSupports("avx2") && cpuSupports("gfni")) kernels.push_back({"gfni", gfDotGfni});
+#endif
+    return kernels;
+}
+
+// Fastest dot product kernel; STEG_KERNEL=<name> pins one
+static GfDotKernel gfDot() {
+    static const GfDotKernel chosen = [] {
+        std::vector<GfVariant> kernels = availableGfKernels();
+        if (const char* pinned = std::getenv("STEG_KERNEL")) {
+            for (const GfVariant& kernel : kernels) {
+                if (std::strcmp(kernel.name, pinned) == 0) return kernel.dot;
+            }
+        }
+        return kernels.back().dot;
+    }();
+    return chosen;
+}
+
+void encodeParity(const uint8_t* const* data, unsigned dataCount, uint8_t* const* parity, unsigned parityCount,
+                  uint64_t size, unsigned threads) {
+    std::vector<const uint8_t*> sources(data, data + dataCount);
+    std::vector<uint8_t> coefficients(dataCount);
+    for (unsigned row = 0; row < parityCount; ++row) {
+        for (unsigned column = 0; column < dataCount; ++column) {
+            coefficients[column] = cauchy(row, column, dataCount);
+        }
+        dotPieces(gfDot(), sources, coefficients.data(), parity[row], size, threads);
+    }
+}
+
+bool rebuildData(uint8_t* const* shards, const std::vector<bool>& present, unsigned dataCount, uint64_t size,
+                 unsigned threads) {
+    // The first dataCount present shards, and the rows of the encoding
+    // matrix (identity over Cauchy) that produced them
+    std::vector<unsigned> used;
+    for (unsigned s = 0; s < present.size() && used.size() < dataCount; ++s) {
+        if (present[s]) used.push_back(s);
+    }
+    if (used.size() < dataCount) return false;
+    bool complete = true;
+    for (unsigned j = 0; j < dataCount; ++j) complete = complete && present[j];
+    if (complete) return true;
+
+    const unsigned k = dataCount;
+    std::vector<uint8_t> matrix((size_t)k * k), inverse((size_t)k * k, 0);
+    for (unsigned r = 0; r < k; ++r) {
+        for (unsigned c = 0; c < k; ++c) {
+            matrix[r * k + c] = used[r] < k ? (uint8_t)(used[r] == c) : cauchy(used[r] - k, c, k);
+        }
+        inverse[r * k + r] = 1;
+    }
+
+    // Gauss-Jordan; any k rows of the encoding matrix are independent, so a
+    // pivot always exists
+    for (unsigned c = 0; c < k; ++c) {
+        unsigned pivot = c;
+        while (matrix[pivot * k + c] == 0) ++pivot;
+        for (unsigned x = 0; x < k; ++x) {
+            std::swap(matrix[c * k + x], matrix[pivot * k + x]);
+            std::swap(inverse[c * k + x], inverse[pivot * k + x]);
+        }
+        const uint8_t scale = gfInverse(matrix[c * k + c]);
+        for (unsigned x = 0; x < k; ++x) {
+            matrix[c * k + x] = gfMul(matrix[c * k + x], scale);
+            inverse[c * k + x] = gfMul(inverse[c * k + x], scale);
+        }
+        for (unsigned r = 0; r < k; ++r) {
+            const uint8_t factor = matrix[r * k + c];
+            if (r == c || factor == 0) continue;
+            for (unsigned x = 0; x < k; ++x) {
+                matrix[r * k + x] ^= gfMul(factor, matrix[c * k + x]);
+                inverse[r * k + x] ^= gfMul(factor, inverse[c * k + x]);
+            }
+        }
+    }
+
+    // Data shard j is row j of the inverse applied to the shards used
+    std::vector<const uint8_t*> sources(k);
+    for (unsigned r = 0; r < k; ++r) sources[r] = shards[used[r]];
+    for (unsigned j = 0; j < k; ++j) {
+        if (!present[j]) dotPieces(gfDot(), sources, &inverse[j * k], shards[j], size, threads);
+    }
+    return true;
+}
+
+} // namespace Steganography
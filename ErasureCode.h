@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Kernels.h"
+
+// --- Erasure Coding ---
+// Systematic Reed-Solomon over GF(2^8) (polynomial 0x11D): k data shards are
+// kept as they are and m parity shards are added, each parity byte a linear
+// combination of the data bytes at the same position. The coefficients form
+// a Cauchy matrix, every square submatrix of which is invertible, so any k of
+// the k + m shards rebuild the rest. k + m is at most 256.
+//
+// All the work is dot products of shards with coefficient vectors. The SIMD
+// kernels multiply 16 or 32 bytes by a constant at once: SSSE3 and AVX2 look
+// up the products of each nibble with PSHUFB, GFNI applies the constant's
+// 8x8 bit matrix with GF2P8AFFINEQB.
+namespace Steganography {
+
+// out[i] = sum over j < count of coefficients[j] * sources[j][i], for i < size
+typedef void (*GfDotKernel)(const uint8_t* const* sources, const uint8_t* coefficients, unsigned count, uint8_t* out,
+                            uint64_t size);
+
+struct GfVariant {
+    const char* name;
+    GfDotKernel dot;
+};
+
+uint8_t gfMul(uint8_t a, uint8_t b);
+uint8_t gfInverse(uint8_t a); // a != 0
+
+void gfDotScalar(const uint8_t* const* sources, const uint8_t* coefficients, unsigned count, uint8_t* out,
+                 uint64_t size);
+#ifdef STEG_X86_KERNELS
+// Only call them when cpuSupports() reports the instructions ("ssse3",
+// "avx2", and "gfni" together with "avx2")
+void gfDotSsse3(const uint8_t* const* sources, const uint8_t* coefficients, unsigned count, uint8_t* out,
+                uint64_t size);
+void gfDotAvx2(const uint8_t* const* sources, const uint8_t* coefficients, unsigned count, uint8_t* out,
+               uint64_t size);
+void gfDotGfni(const uint8_t* const* sources, const uint8_t* coefficients, unsigned count, uint8_t* out,
+               uint64_t size);
+#endif
+
+// Every GF(2^8) dot product kernel this CPU can run, scalar first
+std::vector<GfVariant> availableGfKernels();
+
+// Fills the `parityCount` parity shards from the `dataCount` data shards, all
+// `size` bytes, spread over `threads` workers (0 = one per hardware thread)
+void encodeParity(const uint8_t* const* data, unsigned dataCount, uint8_t* const* parity, unsigned parityCount,
+                  uint64_t size, unsigned threads);
+
+// Rebuilds lost data shards in place. `shards` holds the data shards then the
+// parity shards, `present` says which of them hold their contents; lost data
+// shards must still point at `size` writable bytes. False when fewer than
+// `dataCount` shards are present.
+bool rebuildData(uint8_t* const* shards, const std::vector<bool>& present, unsigned dataCount, uint64_t size,
+                 unsigned threads);
+
+} // namespace Steganography
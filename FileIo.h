@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+// --- File Helpers ---
+// Small pieces of file handling shared by the carrier formats, the payload
+// header and the carrier index: little-endian fields, closing files on every
+// path out, seeks past 2 GB, and extension checks.
+namespace Steganography {
+
+inline uint16_t loadLe16(const uint8_t* bytes) {
+    return (uint16_t)(bytes[0] | (bytes[1] << 8));
+}
+
+inline uint32_t loadLe32(const uint8_t* bytes) {
+    return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+}
+
+inline uint64_t loadLe64(const uint8_t* bytes) {
+    return loadLe32(bytes) | ((uint64_t)loadLe32(bytes + 4) << 32);
+}
+
+inline void storeLe32(uint32_t value, uint8_t* bytes) {
+    for (int i = 0; i < 4; ++i) bytes[i] = (uint8_t)(value >> (8 * i));
+}
+
+inline void storeLe64(uint64_t value, uint8_t* bytes) {
+    storeLe32((uint32_t)value, bytes);
+    storeLe32((uint32_t)(value >> 32), bytes + 4);
+}
+
+// Closes the file however a read or write ends
+struct FileCloser {
+    FILE* file = nullptr;
+
+    ~FileCloser() {
+        if (file) std::fclose(file);
+    }
+};
+
+// Seeks past the 2 GB a long reaches on some platforms
+inline bool seekTo(FILE* file, uint64_t offset) {
+#ifdef _WIN32
+    return _fseeki64(file, (long long)offset, SEEK_SET) == 0;
+#else
+    return fseeko(file, (off_t)offset, SEEK_SET) == 0;
+#endif
+}
+
+// Size of an open file of any size; leaves the position at the end
+inline bool fileSize(FILE* file, uint64_t& size) {
+#ifdef _WIN32
+    if (_fseeki64(file, 0, SEEK_END) != 0) return false;
+    const long long end = _ftelli64(file);
+#else
+    if (fseeko(file, 0, SEEK_END) != 0) return false;
+    const off_t end = ftello(file);
+#endif
+    if (end < 0) return false;
+    size = (uint64_t)end;
+    return true;
+}
+
+// True when the extension of `path` is `extension` (lower case, no dot),
+// compared case-insensitively
+inline bool hasExtension(const std::string& path, const char* extension) {
+    const size_t dot = path.find_last_of('.');
+    if (dot == std::string::npos) return false;
+    const char* expected = extension;
+    for (size_t i = dot + 1; i < path.size(); ++i, ++expected) {
+        if (!*expected || std::tolower((unsigned char)path[i]) != *expected) return false;
+    }
+    return !*expected;
+}
+
+} // namespace Steganography
@@ -0,0 +1,209 @@
+#include "ImageProbe.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include <png.h>
+
+#include "FileIo.h"
+
+namespace Steganography {
+
+namespace {
+
+uint32_t loadBe32(const uint8_t* bytes) {
+    return ((uint32_t)bytes[0] << 24) | (bytes[1] << 16) | (bytes[2] << 8) | bytes[3];
+}
+
+// Walks the JPEG marker segments after SOI to the first start-of-frame,
+// skipping each segment by its length
+bool readJpegSize(FILE* file, unsigned& width, unsigned& height) {
+    if (std::fseek(file, 2, SEEK_SET) != 0) return false;
+    for (;;) {
+        int marker = std::fgetc(file);
+        if (marker != 0xFF) return false;
+        while (marker == 0xFF) marker = std::fgetc(file); // Fill bytes
+        if (marker == EOF || marker == 0xD9 || marker == 0xDA) return false;
+        if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7)) continue; // No length
+        uint8_t segment[7];
+        if (std::fread(segment, 1, 2, file) != 2) return false;
+        const unsigned length = (segment[0] << 8) | segment[1];
+        if (length < 2) return false;
+        // SOF0..SOF15, less DHT (C4), JPG (C8) and DAC (CC)
+        if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC) {
+            if (length < 7 || std::fread(segment + 2, 1, 5, file) != 5) return false;
+            height = (segment[3] << 8) | segment[4];
+            width = (segment[5] << 8) | segment[6];
+            return true;
+        }
+        if (std::fseek(file, length - 2, SEEK_CUR) != 0) return false;
+    }
+}
+
+// Closes the file and frees the read structs however the read ends
+struct PngSource {
+    FILE* file = nullptr;
+    png_structp png = nullptr;
+    png_infop info = nullptr;
+
+    ~PngSource() {
+        if (png) png_destroy_read_struct(&png, info ? &info : nullptr, nullptr);
+        if (file) std::fclose(file);
+    }
+};
+
+} // namespace
+
+bool readPixelRows(const std::string& path, uint64_t firstPixel, uint64_t pixelCount, std::vector<uint8_t>& rgba,
+                   unsigned& width, unsigned& height, unsigned& firstRow) {
+    PngSource source;
+    source.file = std::fopen(path.c_str(), "rb");
+    if (!source.file) return false;
+    png_byte signature[8];
+    if (std::fread(signature, 1, 8, source.file) != 8 || png_sig_cmp(signature, 0, 8) != 0) return false;
+
+    source.png = png_create_read_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+    if (!source.png) return false;
+    source.info = png_create_info_struct(source.png);
+    if (!source.info) return false;
+    // libpng reports errors by longjmp; everything past here is plain data
+    if (setjmp(png_jmpbuf(source.png))) return false;
+
+    png_init_io(source.png, source.file);
+    png_set_sig_bytes(source.png, 8);
+    png_read_info(source.png, source.info);
+    if (png_get_interlace_type(source.png, source.info) != PNG_INTERLACE_NONE) return false;
+
+    // Same conversions as a full load: palettes, low bit depths and tRNS
+    // expanded, 16-bit samples cut to their high byte, grey spread to RGB
+    // and a missing alpha filled in as opaque
+    png_set_expand(source.png);
+    png_set_strip_16(source.png);
+    png_set_gray_to_rgb(source.png);
+    png_set_filler(source.png, 0xFF, PNG_FILLER_AFTER);
+    png_read_update_info(source.png, source.info);
+
+    width = png_get_image_width(source.png, source.info);
+    height = png_get_image_height(source.png, source.info);
+    if (width == 0 || png_get_rowbytes(source.png, source.info) != (size_t)width * 4) return false;
+
+    // Rows are filtered against the row above, so those ahead of the range
+    // are inflated into a scratch row and dropped; reading stops after the
+    // last row the range needs
+    firstRow = (unsigned)std::min<uint64_t>(height, firstPixel / width);
+    const unsigned endRow = (unsigned)std::min<uint64_t>(height, (firstPixel + pixelCount + width - 1) / width);
+    std::vector<uint8_t> scratch((size_t)width * 4);
+    for (unsigned row = 0; row < firstRow; ++row) {
+        png_read_row(source.png, scratch.data(), nullptr);
+    }
+    rgba.resize((size_t)(endRow - firstRow) * width * 4);
+    for (unsigned row = firstRow; row < endRow; ++row) {
+        png_read_row(source.png, rgba.data() + (size_t)(row - firstRow) * width * 4, nullptr);
+    }
+    return true;
+}
+
+bool readLeadingPixels(const std::string& path, uint64_t pixelCount, std::vector<uint8_t>& rgba, unsigned& width,
+                       unsigned& height) {
+    unsigned firstRow = 0;
+    return readPixelRows(path, 0, pixelCount, rgba, width, height, firstRow);
+}
+
+bool readImageInfo(const std::string& path, ImageInfo& info) {
+    FileCloser source;
+    source.file = std::fopen(path.c_str(), "rb");
+    if (!source.file) return false;
+    uint8_t header[30] = {};
+    const size_t headerBytes = std::fread(header, 1, sizeof(header), source.file);
+
+    static const uint8_t kPngSignature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    if (headerBytes >= 26 && std::memcmp(header, kPngSignature, 8) == 0 && std::memcmp(header + 12, "IHDR", 4) == 0) {
+        info.format = ImageFormat::Png;
+        info.width = loadBe32(header + 16);
+        info.height = loadBe32(header + 20);
+        info.alpha = header[25] == 4 || header[25] == 6; // Grey or RGB with alpha
+    } else if (headerBytes >= 30 && header[0] == 'B' && header[1] == 'M') {
+        info.format = ImageFormat::Bmp;
+        if (loadLe32(header + 14) == 12) { // OS/2 core header, 16-bit sizes
+            info.width = loadLe16(header + 18);
+            info.height = loadLe16(header + 20);
+            info.alpha = false;
+        } else {
+            const int32_t storedHeight = (int32_t)loadLe32(header + 22);
+            info.width = loadLe32(header + 18);
+            info.height = (unsigned)(storedHeight < 0 ? -(int64_t)storedHeight : storedHeight);
+            info.alpha = loadLe16(header + 28) == 32;
+        }
+    } else if (headerBytes >= 10 && (std::memcmp(header, "GIF87a", 6) == 0 || std::memcmp(header, "GIF89a", 6) == 0)) {
+        info.format = ImageFormat::Gif;
+        info.width = loadLe16(header + 6);
+        info.height = loadLe16(header + 8);
+        info.alpha = false;
+    } else if (headerBytes >= 2 && header[0] == 0xFF && header[1] == 0xD8) {
+        info.format = ImageFormat::Jpeg;
+        info.alpha = false;
+        if (!readJpegSize(source.file, info.width, info.height)) return false;
+    } else if (headerBytes >= 18 && hasExtension(path, "tga")) {
+        info.format = ImageFormat::Tga;
+        info.width = loadLe16(header + 12);
+        info.height = loadLe16(header + 14);
+        info.alpha = (header[17] & 0x0F) != 0; // Alpha bits per pixel
+    } else {
+        return false;
+    }
+    return info.width > 0 && info.height > 0;
+}
+
+bool rewriteBmpRows(const std::string& path, const uint8_t* rgba, unsigned width, unsigned height,
+                    const std::vector<bool>& changedRows, uint64_t& bytesWritten) {
+    FileCloser target;
+    target.file = std::fopen(path.c_str(), "r+b");
+    if (!target.file) return false;
+
+    // File header, info header and the channel masks a 32-bit BITFIELDS
+    // image keeps right after the info header
+    uint8_t header[66] = {};
+    const size_t headerBytes = std::fread(header, 1, sizeof(header), target.file);
+    if (headerBytes < 54 || header[0] != 'B' || header[1] != 'M' || loadLe32(header + 14) < 40) return false;
+    const uint32_t pixelOffset = loadLe32(header + 10);
+    const int32_t storedHeight = (int32_t)loadLe32(header + 22);
+    const unsigned bitCount = header[28] | (header[29] << 8);
+    const uint32_t compression = loadLe32(header + 30);
+    const bool topDown = storedHeight < 0;
+    if ((int32_t)loadLe32(header + 18) != (int32_t)width || (topDown ? -(int64_t)storedHeight : storedHeight) != height) {
+        return false;
+    }
+    const bool bgra = bitCount == 32 && (compression == 0 || (compression == 3 && headerBytes == 66 &&
+                                                               loadLe32(header + 54) == 0x00FF0000 &&
+                                                               loadLe32(header + 58) == 0x0000FF00 &&
+                                                               loadLe32(header + 62) == 0x000000FF));
+    if (!bgra && !(bitCount == 24 && compression == 0)) return false;
+
+    const unsigned pixelBytes = bitCount / 8;
+    const uint64_t stride = ((uint64_t)width * pixelBytes + 3) & ~(uint64_t)3;
+    uint64_t targetBytes = 0;
+    if (!fileSize(target.file, targetBytes) || targetBytes < pixelOffset + stride * height) return false;
+
+    std::vector<uint8_t> row(stride);
+    for (unsigned y = 0; y < height; ++y) {
+        if (!changedRows[y]) continue;
+        const uint8_t* source = rgba + (size_t)y * width * 4;
+        for (unsigned x = 0; x < width; ++x) {
+            uint8_t* pixel = row.data() + (size_t)x * pixelBytes;
+            pixel[0] = source[4 * x + 2];
+            pixel[1] = source[4 * x + 1];
+            pixel[2] = source[4 * x];
+            if (pixelBytes == 4) pixel[3] = source[4 * x + 3];
+        }
+        const uint64_t fileRow = topDown ? y : height - 1 - y;
+        if (!seekTo(target.file, pixelOffset + fileRow * stride) ||
+            std::fwrite(row.data(), 1, stride, target.file) != stride) {
+            return false;
+        }
+        bytesWritten += stride;
+    }
+    return std::fflush(target.file) == 0;
+}
+
+} // namespace Steganography
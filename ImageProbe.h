@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// --- Image Probing ---
+// Reads just part of an image: the rows that hold a run of its pixels,
+// without decoding the rest of the file. Checking a batch of images for a
+// payload header this way costs a few kilobytes of inflate per image instead
+// of a full decode, and reading part of a payload keeps only the rows it
+// lies in.
+namespace Steganography {
+
+// Decodes the leading rows of the PNG at `path` that cover its first
+// `pixelCount` pixels into `rgba` (RGBA8, converted the way a full load
+// converts them) and sets the image size. False when the file is not a
+// non-interlaced PNG (an interlaced image spreads its first rows over the
+// whole file) or cannot be read; callers then load the whole image.
+bool readLeadingPixels(const std::string& path, uint64_t pixelCount, std::vector<uint8_t>& rgba, unsigned& width,
+                       unsigned& height);
+
+// Decodes the rows of the PNG at `path` that cover pixels [firstPixel,
+// firstPixel + pixelCount) into `rgba`, which starts at row `firstRow`.
+// Earlier rows are still inflated (PNG rows decode in order) but not kept;
+// later ones are not read. Fails as readLeadingPixels does.
+bool readPixelRows(const std::string& path, uint64_t firstPixel, uint64_t pixelCount, std::vector<uint8_t>& rgba,
+                   unsigned& width, unsigned& height, unsigned& firstRow);
+
+// Image formats readImageInfo recognizes
+enum class ImageFormat { Png, Bmp, Gif, Tga, Jpeg };
+
+// What an image file's header says about it
+struct ImageInfo {
+    ImageFormat format = ImageFormat::Png;
+    unsigned width = 0;
+    unsigned height = 0;
+    bool alpha = false; // Stores an alpha channel of its own
+};
+
+// Reads an image's format, size and whether it has an alpha channel from its
+// file header alone (PNG IHDR, BMP info header, GIF screen descriptor, TGA
+// header, JPEG start-of-frame), without decoding any pixels. TGA, which has
+// no signature, is recognized by its .tga extension. False for anything
+// else.
+bool readImageInfo(const std::string& path, ImageInfo& info);
+
+// --- In-Place Writes ---
+// An uncompressed BMP stores each row at a fixed place in the file, so a
+// small change to a big image can be written back by rewriting only the
+// rows it touched.
+
+// Rewrites the rows of the BMP at `path` for which `changedRows` is true
+// from `rgba` (the whole image, RGBA8), adding the bytes written to
+// `bytesWritten`. False when the file is not a 24- or 32-bit uncompressed
+// BMP of this size, in which case nothing is written, or a write fails;
+// callers then save the whole image.
+bool rewriteBmpRows(const std::string& path, const uint8_t* rgba, unsigned width, unsigned height,
+                    const std::vector<bool>& changedRows, uint64_t& bytesWritten);
+
+} // namespace Steganography
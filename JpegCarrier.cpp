@@ -0,0 +1,244 @@
+#include "JpegCarrier.h"
+
+#include <algorithm>
+#include <csetjmp>
+#include <cstdio>
+#include <cstring>
+
+#include "Bits.h"
+#include "FileIo.h"
+
+// jpeglib.h relies on FILE and size_t being declared first
+#include <jpeglib.h>
+
+namespace Steganography {
+
+static_assert(sizeof(JCOEF) == sizeof(int16_t), "coefficients are copied as int16_t");
+
+namespace {
+
+// libjpeg reports fatal errors through error_exit, which must not return;
+// it jumps back to the setjmp in the JpegImage call that is running
+struct ErrorManager {
+    jpeg_error_mgr pub;
+    std::jmp_buf jump;
+};
+
+void onError(j_common_ptr info) {
+    std::longjmp(reinterpret_cast<ErrorManager*>(info->err)->jump, 1);
+}
+
+// Warnings (corrupt but readable data) are not worth a message on stderr
+void onMessage(j_common_ptr) {}
+
+// Bit an F5 coefficient carries: its LSB, inverted for negative values
+inline unsigned f5Bit(int16_t c) {
+    return (unsigned)(c ^ (c >> 15)) & 1;
+}
+
+inline unsigned groupSyndrome(const int16_t* coefficients, const uint64_t* group, unsigned n) {
+    unsigned syndrome = 0;
+    for (unsigned i = 0; i < n; ++i) {
+        syndrome ^= (i + 1) & (0u - f5Bit(coefficients[group[i]]));
+    }
+    return syndrome;
+}
+
+} // namespace
+
+bool isJpegPath(const std::string& path) {
+    return hasExtension(path, "jpg") || hasExtension(path, "jpeg");
+}
+
+// --- JpegImage ---
+
+// The decompressor stays alive after load: its coefficient arrays and
+// parameters are what save() writes back out
+struct JpegImage::Codec {
+    jpeg_decompress_struct source;
+    ErrorManager errors;
+    jvirt_barray_ptr* arrays = nullptr;
+    bool created = false;
+
+    ~Codec() {
+        if (created) jpeg_destroy_decompress(&source);
+    }
+
+    // Copies every block between the coefficient arrays and `coefficients`
+    void copyBlocks(int16_t* coefficients, bool toArrays) {
+        for (int ci = 0; ci < source.num_components; ++ci) {
+            const jpeg_component_info& info = source.comp_info[ci];
+            const size_t rowCoefficients = (size_t)info.width_in_blocks * DCTSIZE2;
+            for (JDIMENSION row = 0; row < info.height_in_blocks; ++row) {
+                JBLOCKARRAY blocks = source.mem->access_virt_barray((j_common_ptr)&source, arrays[ci], row, 1,
+                                                                    toArrays ? TRUE : FALSE);
+                if (toArrays) std::memcpy(blocks[0], coefficients, rowCoefficients * sizeof(int16_t));
+                else std::memcpy(coefficients, blocks[0], rowCoefficients * sizeof(int16_t));
+                coefficients += rowCoefficients;
+            }
+        }
+    }
+};
+
+JpegImage::JpegImage() = default;
+JpegImage::~JpegImage() = default;
+
+bool JpegImage::load(const std::string& path) {
+    codec.reset(new Codec());
+    coefficients.clear();
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) return false;
+
+    Codec& c = *codec;
+    c.source.err = jpeg_std_error(&c.errors.pub);
+    c.errors.pub.error_exit = onError;
+    c.errors.pub.output_message = onMessage;
+    if (setjmp(c.errors.jump)) {
+        std::fclose(file);
+        codec.reset();
+        coefficients.clear();
+        return false;
+    }
+
+    jpeg_create_decompress(&c.source);
+    c.created = true;
+    jpeg_stdio_src(&c.source, file);
+    jpeg_read_header(&c.source, TRUE);
+    c.arrays = jpeg_read_coefficients(&c.source);
+
+    uint64_t blocks = 0;
+    for (int ci = 0; ci < c.source.num_components; ++ci) {
+        blocks += (uint64_t)c.source.comp_info[ci].width_in_blocks * c.source.comp_info[ci].height_in_blocks;
+    }
+    coefficients.resize((size_t)blocks * DCTSIZE2);
+    c.copyBlocks(coefficients.data(), false);
+
+    // Everything up to EOI has been read; the arrays live in the decompressor
+    std::fclose(file);
+    imageWidth = c.source.image_width;
+    imageHeight = c.source.image_height;
+    return true;
+}
+
+bool JpegImage::save(const std::string& path) {
+    if (!codec) return false;
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) return false;
+
+    Codec& c = *codec;
+    jpeg_compress_struct target;
+    std::memset(&target, 0, sizeof(target));
+    target.err = &c.errors.pub;
+    if (setjmp(c.errors.jump)) {
+        jpeg_destroy_compress(&target);
+        std::fclose(file);
+        return false;
+    }
+
+    jpeg_create_compress(&target);
+    jpeg_stdio_dest(&target, file);
+    jpeg_copy_critical_parameters(&c.source, &target);
+    // Optimized Huffman tables keep the stego file close to the cover's size
+    target.optimize_coding = TRUE;
+
+    c.copyBlocks(coefficients.data(), true);
+    jpeg_write_coefficients(&target, c.arrays);
+    jpeg_finish_compress(&target);
+    jpeg_destroy_compress(&target);
+    return std::fclose(file) == 0;
+}
+
+// --- F5 ---
+
+F5Walk::F5Walk(const int16_t* coefficients, uint64_t count, const ChannelPermutation* permutation, uint64_t first)
+    : coefficients(coefficients), count(count), permutation(permutation), scanned(first), endIndex(first) {}
+
+bool F5Walk::refill() {
+    if (scanned == count) return false;
+    unsigned n = (unsigned)std::min<uint64_t>(ChannelPermutation::kBatch, count - scanned);
+    if (permutation) {
+        uint64_t positions[ChannelPermutation::kBatch];
+        permutation->map(scanned, n, positions);
+        for (unsigned i = 0; i < n; ++i) {
+            if ((positions[i] & 63) && coefficients[positions[i]]) usable.push_back(positions[i]);
+        }
+    } else {
+        for (uint64_t i = scanned; i < scanned + n; ++i) {
+            if ((i & 63) && coefficients[i]) usable.push_back(i);
+        }
+    }
+    scanned += n;
+    return true;
+}
+
+bool F5Walk::peek(uint64_t* group, unsigned n) {
+    // Drop what the cursor has passed so the list stays a few batches long
+    if (cursor >= 4 * ChannelPermutation::kBatch) {
+        usable.erase(usable.begin(), usable.begin() + cursor);
+        cursor = 0;
+    }
+
+    size_t at = cursor;
+    unsigned filled = 0;
+    while (filled < n) {
+        if (at == usable.size()) {
+            if (!refill()) return false;
+            continue;
+        }
+        uint64_t index = usable[at++];
+        if (coefficients[index]) group[filled++] = index;
+    }
+    peeked = at;
+    return true;
+}
+
+void F5Walk::advance() {
+    if (peeked > cursor) endIndex = usable[peeked - 1] + 1;
+    cursor = peeked;
+}
+
+F5Writer::F5Writer(JpegImage& image, const ChannelPermutation* permutation, uint64_t first)
+    : coefficients(image.data()), walk(image.data(), image.coefficientCount(), permutation, first) {}
+
+bool F5Writer::write(const uint8_t* data, uint64_t byteCount, unsigned k) {
+    const unsigned n = (1u << k) - 1;
+    const uint64_t groups = (byteCount * 8 + k - 1) / k;
+    BitReader in(data, byteCount);
+    uint64_t group[63];
+
+    for (uint64_t g = 0; g < groups; ++g) {
+        const unsigned message = (unsigned)in.read(k);
+        for (;;) {
+            if (!walk.peek(group, n)) return false;
+            unsigned change = groupSyndrome(coefficients, group, n) ^ message;
+            if (change == 0) break;
+
+            int16_t& c = coefficients[group[change - 1]];
+            c = (int16_t)(c - (c > 0) + (c < 0));
+            ++changeCount;
+            if (c != 0) break;
+            // Shrinkage: the group is gathered again without the new zero
+        }
+        walk.advance();
+    }
+    return true;
+}
+
+F5Reader::F5Reader(const JpegImage& image, const ChannelPermutation* permutation, uint64_t first)
+    : coefficients(image.data()), walk(image.data(), image.coefficientCount(), permutation, first) {}
+
+bool F5Reader::read(uint8_t* data, uint64_t byteCount, unsigned k) {
+    const unsigned n = (1u << k) - 1;
+    const uint64_t groups = (byteCount * 8 + k - 1) / k;
+    BitWriter out(data, byteCount);
+    uint64_t group[63];
+
+    for (uint64_t g = 0; g < groups; ++g) {
+        if (!walk.peek(group, n)) return false;
+        walk.advance();
+        out.write(groupSyndrome(coefficients, group, n), k);
+    }
+    return true;
+}
+
+} // namespace Steganography
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Traversal.h"
+
+// --- JPEG Carriers (F5) ---
+// A JPEG carrier keeps the payload in its quantized DCT coefficients, read
+// straight from the entropy-coded data with no IDCT or colour conversion and
+// written back with the same quantization tables, so nothing is lost on the
+// way out. Decoding JPEG pixels and re-encoding them would requantize and
+// wipe the payload.
+//
+// Embedding follows F5. Payload bits are matrix-encoded k at a time in groups
+// of n = 2^k - 1 non-zero AC coefficients. A coefficient carries its LSB,
+// inverted for negative values, and a change always lowers |c| by one. When
+// that leaves a zero (shrinkage) the decoder would skip the coefficient, so
+// the group is refilled from the next non-zero one and embedded again. k = 1
+// is plain F4.
+namespace Steganography {
+
+// True for .jpg/.jpeg paths (case-insensitive)
+bool isJpegPath(const std::string& path);
+
+// Quantized DCT coefficients of a JPEG file: 64 per 8x8 block in natural
+// (row-major) order, blocks ordered by component, then row, then column
+class JpegImage {
+public:
+    JpegImage();
+    ~JpegImage();
+
+    bool load(const std::string& path);
+
+    // Writes the coefficients as a baseline JPEG with the loaded file's
+    // quantization tables and sampling factors
+    bool save(const std::string& path);
+
+    unsigned width() const { return imageWidth; }
+    unsigned height() const { return imageHeight; }
+    uint64_t coefficientCount() const { return coefficients.size(); }
+    int16_t* data() { return coefficients.data(); }
+    const int16_t* data() const { return coefficients.data(); }
+
+private:
+    struct Codec;
+    std::unique_ptr<Codec> codec;
+    std::vector<int16_t> coefficients;
+    unsigned imageWidth = 0;
+    unsigned imageHeight = 0;
+};
+
+// Walk over the non-zero AC coefficients from index `first` on, in index
+// order or in the order of `permutation` (over all coefficients, holding the
+// first `first` in place) when one is given. Coefficients are
+// found a batch at a time as the coder reaches them, so a small payload never
+// touches the whole image. Zero coefficients never change, so the decoder
+// sees the same walk minus the coefficients that shrank to zero, which the
+// encoder skips as well.
+class F5Walk {
+public:
+    F5Walk(const int16_t* coefficients, uint64_t count, const ChannelPermutation* permutation, uint64_t first = 0);
+
+    // Next n non-zero coefficients from the cursor, leaving the cursor in
+    // place; false when the image runs out first
+    bool peek(uint64_t* group, unsigned n);
+
+    // Moves the cursor past the last peeked group
+    void advance();
+
+    // One past the last coefficient of the last group; in index order, where
+    // a walk over the rest of the image can start
+    uint64_t end() const { return endIndex; }
+
+private:
+    bool refill();
+
+    const int16_t* coefficients;
+    uint64_t count;
+    const ChannelPermutation* permutation;
+    uint64_t scanned = 0; // Traversal positions looked at so far
+    std::vector<uint64_t> usable;
+    size_t cursor = 0;
+    size_t peeked = 0;
+    uint64_t endIndex;
+};
+
+// Sequential F5 coder over a JpegImage. Successive calls continue where the
+// previous one stopped; a call that does not end on a whole group pads the
+// last group with zero bits.
+class F5Writer {
+public:
+    F5Writer(JpegImage& image, const ChannelPermutation* permutation = nullptr, uint64_t first = 0);
+
+    // Embeds `byteCount` bytes k bits per group (1 <= k <= 6); false when
+    // the non-zero coefficients run out
+    bool write(const uint8_t* data, uint64_t byteCount, unsigned k);
+
+    uint64_t changes() const { return changeCount; }
+    uint64_t end() const { return walk.end(); }
+
+private:
+    int16_t* coefficients;
+    F5Walk walk;
+    uint64_t changeCount = 0;
+};
+
+class F5Reader {
+public:
+    F5Reader(const JpegImage& image, const ChannelPermutation* permutation = nullptr, uint64_t first = 0);
+
+    // Extracts `byteCount` bytes written with the same k; false when the
+    // non-zero coefficients run out
+    bool read(uint8_t* data, uint64_t byteCount, unsigned k);
+
+    uint64_t end() const { return walk.end(); }
+
+private:
+    const int16_t* coefficients;
+    F5Walk walk;
+};
+
+} // namespace Steganography
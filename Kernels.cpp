@@ -0,0 +1,303 @@
+#include "Kernels.h"
+
+#include <cstdlib>
+#include <cstring>
+
+#if defined(STEG_X86_KERNELS) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include "Parallel.h"
+
+namespace Steganography {
+
+unsigned channelsPerPixel(ChannelLayout channels) {
+    return channels == ChannelLayout::RGBA ? 4 : 3;
+}
+
+uint64_t capacityBits(uint64_t pixelCount, const Layout& layout) {
+    return pixelCount * channelsPerPixel(layout.channels) * layout.bitsPerChannel;
+}
+
+uint64_t pixelsForBytes(uint64_t byteCount, const Layout& layout) {
+    uint64_t channels = (byteCount * 8 + layout.bitsPerChannel - 1) / layout.bitsPerChannel;
+    unsigned perPixel = channelsPerPixel(layout.channels);
+    return (channels + perPixel - 1) / perPixel;
+}
+
+void embedBit(sf::Uint8& colorChannel, bool bit, unsigned plane) {
+    if (bit) {
+        colorChannel |= (1 << plane); // Set bit to 1
+    } else {
+        colorChannel &= ~(1 << plane); // Set bit to 0
+    }
+}
+
+bool extractBit(const sf::Uint8& colorChannel, unsigned plane) {
+    return (colorChannel >> plane) & 1;
+}
+
+// Helper to pick a component of a pixel by index (r, g, b, a)
+static sf::Uint8& component(sf::Color& color, unsigned index) {
+    switch (index) {
+        case 0: return color.r;
+        case 1: return color.g;
+        case 2: return color.b;
+        default: return color.a;
+    }
+}
+
+// --- Reference Kernels ---
+
+void embedReference(sf::Image& image, const Layout& layout, uint64_t streamOffset, const uint8_t* data, uint64_t byteCount) {
+    unsigned width = image.getSize().x;
+    unsigned perPixel = channelsPerPixel(layout.channels);
+    uint64_t bitIndex = streamOffset * 8;
+
+    for (uint64_t byte_i = 0; byte_i < byteCount; ++byte_i) {
+        for (int i = 0; i < 8; ++i) {
+            uint64_t channel = bitIndex / layout.bitsPerChannel;
+            uint64_t pixel = channel / perPixel;
+            unsigned x = pixel % width;
+            unsigned y = pixel / width;
+
+            sf::Color color = image.getPixel(x, y);
+            bool bit = (data[byte_i] >> i) & 1;
+            embedBit(component(color, channel % perPixel), bit, bitIndex % layout.bitsPerChannel);
+            image.setPixel(x, y, color);
+            bitIndex++;
+        }
+    }
+}
+
+void extractReference(const sf::Image& image, const Layout& layout, uint64_t streamOffset, uint8_t* data, uint64_t byteCount) {
+    unsigned width = image.getSize().x;
+    unsigned perPixel = channelsPerPixel(layout.channels);
+    uint64_t bitIndex = streamOffset * 8;
+
+    for (uint64_t byte_i = 0; byte_i < byteCount; ++byte_i) {
+        uint8_t currentByte = 0;
+        for (int i = 0; i < 8; ++i) {
+            uint64_t channel = bitIndex / layout.bitsPerChannel;
+            uint64_t pixel = channel / perPixel;
+
+            sf::Color color = image.getPixel(pixel % width, pixel / width);
+            if (extractBit(component(color, channel % perPixel), bitIndex % layout.bitsPerChannel)) {
+                currentByte |= (1 << i);
+            }
+            bitIndex++;
+        }
+        data[byte_i] = currentByte;
+    }
+}
+
+// --- Scalar Kernels ---
+// Walk the buffer with a running pixel pointer and component index instead of
+// dividing per bit. Each channel takes `bitsPerChannel` bits at once.
+
+void embedScalar(uint8_t* pixels, const Layout& layout, uint64_t streamOffset, const uint8_t* data, uint64_t byteCount) {
+    const unsigned depth = layout.bitsPerChannel;
+    const unsigned perPixel = channelsPerPixel(layout.channels);
+    const uint8_t mask = (uint8_t)((1u << depth) - 1);
+    const unsigned groups = 8 / depth;
+
+    uint64_t channel = streamOffset * 8 / depth;
+    uint8_t* px = pixels + (channel / perPixel) * 4;
+    unsigned comp = channel % perPixel;
+
+    for (uint64_t byte_i = 0; byte_i < byteCount; ++byte_i) {
+        unsigned bits = data[byte_i];
+        for (unsigned g = 0; g < groups; ++g) {
+            px[comp] = (uint8_t)((px[comp] & ~mask) | (bits & mask));
+            bits >>= depth;
+            if (++comp == perPixel) {
+                comp = 0;
+                px += 4;
+            }
+        }
+    }
+}
+
+void extractScalar(const uint8_t* pixels, const Layout& layout, uint64_t streamOffset, uint8_t* data, uint64_t byteCount) {
+    const unsigned depth = layout.bitsPerChannel;
+    const unsigned perPixel = channelsPerPixel(layout.channels);
+    const uint8_t mask = (uint8_t)((1u << depth) - 1);
+    const unsigned groups = 8 / depth;
+
+    uint64_t channel = streamOffset * 8 / depth;
+    const uint8_t* px = pixels + (channel / perPixel) * 4;
+    unsigned comp = channel % perPixel;
+
+    for (uint64_t byte_i = 0; byte_i < byteCount; ++byte_i) {
+        unsigned bits = 0;
+        for (unsigned g = 0; g < groups; ++g) {
+            bits |= (unsigned)(px[comp] & mask) << (g * depth);
+            if (++comp == perPixel) {
+                comp = 0;
+                px += 4;
+            }
+        }
+        data[byte_i] = (uint8_t)bits;
+    }
+}
+
+// --- Dispatch ---
+
+bool cpuSupports(const char* feature) {
+#if defined(STEG_X86_KERNELS) && (defined(__GNUC__) || defined(__clang__))
+    __builtin_cpu_init();
+    if (std::strcmp(feature, "ssse3") == 0) return __builtin_cpu_supports("ssse3");
+    if (std::strcmp(feature, "avx2") == 0) return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("bmi2");
+    if (std::strcmp(feature, "sse4.2") == 0) return __builtin_cpu_supports("sse4.2");
+    if (std::strcmp(feature, "pclmul") == 0) return __builtin_cpu_supports("pclmul");
+    if (std::strcmp(feature, "gfni") == 0) return __builtin_cpu_supports("gfni");
+#elif defined(STEG_X86_KERNELS) && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    bool ssse3 = (info[2] >> 9) & 1;
+    bool sse42 = (info[2] >> 20) & 1;
+    bool pclmul = (info[2] >> 1) & 1;
+    bool osAvx = ((info[2] >> 27) & 1) && ((info[2] >> 28) & 1) && (_xgetbv(0) & 6) == 6;
+    __cpuidex(info, 7, 0);
+    bool avx2 = osAvx && ((info[1] >> 5) & 1) && ((info[1] >> 8) & 1); // AVX2 + BMI2
+    bool gfni = (info[2] >> 8) & 1;
+    if (std::strcmp(feature, "ssse3") == 0) return ssse3;
+    if (std::strcmp(feature, "avx2") == 0) return avx2;
+    if (std::strcmp(feature, "sse4.2") == 0) return sse42;
+    if (std::strcmp(feature, "pclmul") == 0) return pclmul;
+    if (std::strcmp(feature, "gfni") == 0) return gfni;
+#else
+    (void)feature;
+#endif
+    return false;
+}
+
+// Single-threaded kernels this CPU can run, slowest first
+static std::vector<KernelVariant> singleThreadedKernels() {
+    std::vector<KernelVariant> kernels = {{"scalar", embedScalar, extractScalar}};
+#ifdef STEG_X86_KERNELS
+    if (cpuSupports("ssse3")) kernels.push_back({"ssse3", embedSsse3, extractSsse3});
+    if (cpuSupports("avx2")) kernels.push_back({"avx2", embedAvx2, extractAvx2});
+#endif
+    return kernels;
+}
+
+// The kernel embedFast/extractFast use. STEG_KERNEL=<name> pins a specific
+// variant, e.g. to fall back to "scalar" without a rebuild.
+static const KernelVariant& fastestKernel() {
+    static const KernelVariant chosen = [] {
+        std::vector<KernelVariant> kernels = singleThreadedKernels();
+        if (const char* pinned = std::getenv("STEG_KERNEL")) {
+            for (const KernelVariant& kernel : kernels) {
+                if (std::strcmp(kernel.name, pinned) == 0) return kernel;
+            }
+        }
+        return kernels.back();
+    }();
+    return chosen;
+}
+
+void embedFast(uint8_t* pixels, const Layout& layout, uint64_t streamOffset, const uint8_t* data, uint64_t byteCount) {
+    fastestKernel().embed(pixels, layout, streamOffset, data, byteCount);
+}
+
+void extractFast(const uint8_t* pixels, const Layout& layout, uint64_t streamOffset, uint8_t* data, uint64_t byteCount) {
+    fastestKernel().extract(pixels, layout, streamOffset, data, byteCount);
+}
+
+// Pieces are whole stream bytes, and with 1, 2 or 4 bits per channel no
+// channel spans two bytes, so threads never write the same buffer byte.
+const uint64_t kThreadPieceBytes = 1 << 20;
+
+void embedThreaded(uint8_t* pixels, const Layout& layout, uint64_t streamOffset, const uint8_t* data, uint64_t byteCount) {
+    parallelFor(byteCount, kThreadPieceBytes, 0, [&](uint64_t begin, uint64_t end) {
+        embedFast(pixels, layout, streamOffset + begin, data + begin, end - begin);
+        return true;
+    });
+}
+
+void extractThreaded(const uint8_t* pixels, const Layout& layout, uint64_t streamOffset, uint8_t* data, uint64_t byteCount) {
+    parallelFor(byteCount, kThreadPieceBytes, 0, [&](uint64_t begin, uint64_t end) {
+        extractFast(pixels, layout, streamOffset + begin, data + begin, end - begin);
+        return true;
+    });
+}
+
+void gatherLsbs(const uint8_t* pixels, ChannelLayout channels, uint64_t firstChannel, uint64_t count, uint8_t* bits) {
+    Layout lsbPlane;
+    lsbPlane.channels = channels;
+    lsbPlane.bitsPerChannel = 1;
+    extractFast(pixels, lsbPlane, firstChannel / 8, bits, count / 8);
+
+    // The last partial byte may end before the buffer does, so read it channel by channel
+    unsigned perPixel = channelsPerPixel(channels);
+    uint64_t tail = count % 8;
+    if (tail) {
+        uint8_t last = 0;
+        uint64_t channel = firstChannel + count - tail;
+        for (uint64_t i = 0; i < tail; ++i, ++channel) {
+            last |= (uint8_t)((pixels[channelOffset(channel, perPixel)] & 1) << i);
+        }
+        bits[count / 8] = last;
+    }
+}
+
+// --- LSB Matching ---
+
+void embedMatchingScalar(uint8_t* pixels, ChannelLayout channels, uint64_t streamOffset, const uint8_t* data,
+                         uint64_t byteCount, uint64_t key) {
+    const unsigned perPixel = channelsPerPixel(channels);
+    uint64_t channel = streamOffset * 8;
+    uint64_t pixelByte = channel / perPixel * 4;
+    unsigned comp = channel % perPixel;
+
+    uint64_t signBlock = ~0ull;
+    uint32_t signs = 0;
+    for (uint64_t byte_i = 0; byte_i < byteCount; ++byte_i) {
+        unsigned bits = data[byte_i];
+        for (unsigned g = 0; g < 8; ++g) {
+            uint64_t at = pixelByte + comp;
+            if ((at >> 5) != signBlock) {
+                signBlock = at >> 5;
+                signs = matchingSigns(key, signBlock);
+            }
+            pixels[at] = matchBit(pixels[at], bits & 1, (signs >> (at & 31)) & 1);
+            bits >>= 1;
+            if (++comp == perPixel) {
+                comp = 0;
+                pixelByte += 4;
+            }
+        }
+    }
+}
+
+std::vector<MatchingVariant> availableMatchingKernels() {
+    std::vector<MatchingVariant> kernels = {{"scalar", embedMatchingScalar}};
+#ifdef STEG_X86_KERNELS
+    if (cpuSupports("ssse3")) kernels.push_back({"ssse3", embedMatchingSsse3});
+    if (cpuSupports("avx2")) kernels.push_back({"avx2", embedMatchingAvx2});
+#endif
+    return kernels;
+}
+
+void embedMatchingFast(uint8_t* pixels, ChannelLayout channels, uint64_t streamOffset, const uint8_t* data,
+                       uint64_t byteCount, uint64_t key) {
+    static const MatchingVariant chosen = [] {
+        std::vector<MatchingVariant> kernels = availableMatchingKernels();
+        if (const char* pinned = std::getenv("STEG_KERNEL")) {
+            for (const MatchingVariant& kernel : kernels) {
+                if (std::strcmp(kernel.name, pinned) == 0) return kernel;
+            }
+        }
+        return kernels.back();
+    }();
+    chosen.embed(pixels, channels, streamOffset, data, byteCount, key);
+}
+
+std::vector<KernelVariant> availableKernels() {
+    std::vector<KernelVariant> kernels = singleThreadedKernels();
+    kernels.push_back({"threaded", embedThreaded, extractThreaded});
+    return kernels;
+}
+
+} // namespace Steganography
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <cstdint>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define STEG_X86_KERNELS 1
+#endif
+
+// Compiles one function for extra instruction sets, so a kernel can use them
+// without the rest of the build assuming them; callers check cpuSupports()
+// first
+#if defined(STEG_X86_KERNELS) && (defined(__GNUC__) || defined(__clang__))
+#define STEG_TARGET(features) __attribute__((target(features)))
+#else
+#define STEG_TARGET(features)
+#endif
+
+// --- Embed/Extract Kernels ---
+// The payload is a little-endian bit stream (bit 0 of byte 0 first). Stream bit
+// i is stored in bit plane (i % bitsPerChannel) of channel (i / bitsPerChannel),
+// and channels are walked pixel by pixel over the selected color components.
+// All kernels work at byte granularity: `streamOffset` is the index of the
+// first stream byte touched, so a header and a payload can be written by two
+// separate calls.
+namespace Steganography {
+
+enum class ChannelLayout { RGB, RGBA };
+
+struct Layout {
+    ChannelLayout channels = ChannelLayout::RGB;
+    unsigned bitsPerChannel = 1; // 1, 2 or 4 so a byte never straddles a channel
+};
+
+// Number of color components per pixel used by a layout
+unsigned channelsPerPixel(ChannelLayout channels);
+
+// Buffer offset of a channel in an RGBA8 pixel buffer
+inline uint64_t channelOffset(uint64_t channel, unsigned perPixel) {
+    // Spelled out so the RGB case divides by a constant
+    return perPixel == 3 ? channel / 3 * 4 + channel % 3 : channel;
+}
+
+// Total payload bits a carrier of `pixelCount` pixels can hold
+uint64_t capacityBits(uint64_t pixelCount, const Layout& layout);
+
+// Pixels covered by the first `byteCount` stream bytes
+uint64_t pixelsForBytes(uint64_t byteCount, const Layout& layout);
+
+// Helper to embed a single bit into a color channel
+void embedBit(sf::Uint8& colorChannel, bool bit, unsigned plane = 0);
+
+// Helper to extract a single bit from a color channel
+bool extractBit(const sf::Uint8& colorChannel, unsigned plane = 0);
+
+// Reference kernels: one getPixel/setPixel round trip per bit. Slow, but they
+// define the format every faster kernel must reproduce.
+void embedReference(sf::Image& image, const Layout& layout, uint64_t streamOffset, const uint8_t* data, uint64_t byteCount);
+void extractReference(const sf::Image& image, const Layout& layout, uint64_t streamOffset, uint8_t* data, uint64_t byteCount);
+
+// Buffer kernels share one signature so callers can pick a variant at runtime
+typedef void (*EmbedKernel)(uint8_t* pixels, const Layout& layout, uint64_t streamOffset, const uint8_t* data, uint64_t byteCount);
+typedef void (*ExtractKernel)(const uint8_t* pixels, const Layout& layout, uint64_t streamOffset, uint8_t* data, uint64_t byteCount);
+
+struct KernelVariant {
+    const char* name;
+    EmbedKernel embed;
+    ExtractKernel extract;
+};
+
+// Scalar kernels working directly on an RGBA8 pixel buffer
+void embedScalar(uint8_t* pixels, const Layout& layout, uint64_t streamOffset, const uint8_t* data, uint64_t byteCount);
+void extractScalar(const uint8_t* pixels, const Layout& layout, uint64_t streamOffset, uint8_t* data, uint64_t byteCount);
+
+#ifdef STEG_X86_KERNELS
+// SIMD kernels for 1 bit per channel; other depths defer to the scalar kernels.
+// Only call them when cpuSupports() says the CPU has the instructions.
+void embedSsse3(uint8_t* pixels, const Layout& layout, uint64_t streamOffset, const uint8_t* data, uint64_t byteCount);
+void extractSsse3(const uint8_t* pixels, const Layout& layout, uint64_t streamOffset, uint8_t* data, uint64_t byteCount);
+void embedAvx2(uint8_t* pixels, const Layout& layout, uint64_t streamOffset, const uint8_t* data, uint64_t byteCount);
+void extractAvx2(const uint8_t* pixels, const Layout& layout, uint64_t streamOffset, uint8_t* data, uint64_t byteCount);
+#endif
+
+// Fastest single-threaded kernel this CPU can run
+void embedFast(uint8_t* pixels, const Layout& layout, uint64_t streamOffset, const uint8_t* data, uint64_t byteCount);
+void extractFast(const uint8_t* pixels, const Layout& layout, uint64_t streamOffset, uint8_t* data, uint64_t byteCount);
+
+// The fast kernels spread over all hardware threads in 1 MiB pieces
+void embedThreaded(uint8_t* pixels, const Layout& layout, uint64_t streamOffset, const uint8_t* data, uint64_t byteCount);
+void extractThreaded(const uint8_t* pixels, const Layout& layout, uint64_t streamOffset, uint8_t* data, uint64_t byteCount);
+
+// Copies the LSBs of `count` consecutive channels starting at `firstChannel`
+// into a packed bit array (channel i -> bit i). `firstChannel` must be a
+// multiple of 8; the bulk goes through extractFast.
+void gatherLsbs(const uint8_t* pixels, ChannelLayout channels, uint64_t firstChannel, uint64_t count, uint8_t* bits);
+
+// Every buffer kernel this CPU can run, scalar first
+std::vector<KernelVariant> availableKernels();
+
+// --- LSB Matching ---
+// A channel whose LSB must change moves by +1 or -1 instead of having its
+// LSB overwritten, which leaves none of the pairs-of-values pattern that
+// replacement does. The sign comes from a keyed bit stream over buffer
+// positions, forced inward at 0 and 255. The resulting LSBs are the same as
+// with replacement, so extraction uses the normal kernels. 1 bit per channel.
+typedef void (*MatchingKernel)(uint8_t* pixels, ChannelLayout channels, uint64_t streamOffset, const uint8_t* data,
+                               uint64_t byteCount, uint64_t key);
+
+struct MatchingVariant {
+    const char* name;
+    MatchingKernel embed;
+};
+
+// Sign bits of buffer bytes 32 * block .. 32 * block + 31 (bit i for byte i, 1 = +1)
+inline uint32_t matchingSigns(uint64_t key, uint64_t block) {
+    uint64_t z = key ^ (block * 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 32)) * 0xD6E8FEB86659FD93ull;
+    return (uint32_t)(z ^ (z >> 32));
+}
+
+// One channel moved to LSB `bit`, by +1 if `up` allows it and -1 otherwise
+inline uint8_t matchBit(uint8_t value, unsigned bit, unsigned up) {
+    int change = (value ^ bit) & 1;
+    int goUp = (up & (value != 255)) | (value == 0);
+    return (uint8_t)(value + change * (2 * goUp - 1));
+}
+
+void embedMatchingScalar(uint8_t* pixels, ChannelLayout channels, uint64_t streamOffset, const uint8_t* data,
+                         uint64_t byteCount, uint64_t key);
+#ifdef STEG_X86_KERNELS
+void embedMatchingSsse3(uint8_t* pixels, ChannelLayout channels, uint64_t streamOffset, const uint8_t* data,
+                        uint64_t byteCount, uint64_t key);
+void embedMatchingAvx2(uint8_t* pixels, ChannelLayout channels, uint64_t streamOffset, const uint8_t* data,
+                       uint64_t byteCount, uint64_t key);
+#endif
+
+// Fastest matching kernel this CPU can run; STEG_KERNEL pins one by name
+void embedMatchingFast(uint8_t* pixels, ChannelLayout channels, uint64_t streamOffset, const uint8_t* data,
+                       uint64_t byteCount, uint64_t key);
+
+// Every matching kernel this CPU can run, scalar first
+std::vector<MatchingVariant> availableMatchingKernels();
+
+// Runtime CPU feature checks ("ssse3", "avx2", "sse4.2", "pclmul", "gfni")
+bool cpuSupports(const char* feature);
+
+} // namespace Steganography
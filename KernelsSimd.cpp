@@ -0,0 +1,299 @@
+#include "Kernels.h"
+
+#ifdef STEG_X86_KERNELS
+
+#include <algorithm>
+#include <cstring>
+#include <immintrin.h>
+
+// --- SIMD Kernels (1 bit per channel) ---
+// A block is 8 pixels (32 buffer bytes) and carries one bit per used channel:
+// 3 payload bytes for RGB, 4 for RGBA. Payload bytes are broadcast to every
+// lane, PSHUFB routes the right byte to each channel, and a per-lane bit mask
+// picks that channel's bit. Alpha lanes of the RGB layout keep their value.
+// Partial blocks at either end go through the scalar kernels.
+namespace Steganography {
+
+namespace {
+
+struct BlockTables {
+    alignas(32) uint8_t shuffle[32];
+    alignas(32) uint8_t bit[32];
+    alignas(32) uint8_t keep[32];
+    // LSB matching: byte j of a block takes sign bit j of the block's sign
+    // word, broadcast like the payload bytes
+    alignas(32) uint8_t signShuffle[32];
+    alignas(32) uint8_t signBit[32];
+};
+
+BlockTables makeTables(unsigned perPixel) {
+    BlockTables t;
+    for (unsigned j = 0; j < 32; ++j) {
+        unsigned pixel = j / 4, comp = j % 4;
+        if (comp < perPixel) {
+            unsigned bit = pixel * perPixel + comp;
+            t.shuffle[j] = (uint8_t)(bit / 8);
+            t.bit[j] = (uint8_t)(1 << (bit % 8));
+            t.keep[j] = 0xFE;
+        } else {
+            t.shuffle[j] = 0x80; // PSHUFB writes zero
+            t.bit[j] = 0;
+            t.keep[j] = 0xFF;
+        }
+        t.signShuffle[j] = (uint8_t)(j / 8);
+        t.signBit[j] = (uint8_t)(1 << (j % 8));
+    }
+    return t;
+}
+
+const BlockTables& tablesFor(unsigned perPixel) {
+    static const BlockTables rgb = makeTables(3);
+    static const BlockTables rgba = makeTables(4);
+    return perPixel == 4 ? rgba : rgb;
+}
+
+// Packs the 32 per-byte bits of a block down to the used channels. For RGB
+// that drops every 4th bit: 3-bit groups are merged pairwise into 6, 12 and
+// finally 24 contiguous bits.
+inline uint32_t compactBits(uint32_t mask, unsigned perPixel) {
+    if (perPixel == 4) return mask;
+    uint32_t x = (mask & 0x07070707u) | ((mask & 0x70707070u) >> 1);
+    x = (x & 0x003F003Fu) | ((x & 0x3F003F00u) >> 2);
+    return (x & 0x00000FFFu) | ((x >> 4) & 0x00FFF000u);
+}
+
+// Payload bytes of one block. All but the last block may read a whole word:
+// the extra byte belongs to the next block and the shuffle tables ignore it.
+inline uint32_t loadBlock(const uint8_t* src, unsigned perPixel, bool last) {
+    uint32_t word = 0;
+    std::memcpy(&word, src, last ? perPixel : 4);
+    return word;
+}
+
+// Stores one block of extracted bytes; a full-word store is overwritten by
+// the next block, so only the last block needs an exact-size store
+inline void storeBlock(uint8_t* dst, uint32_t word, unsigned perPixel, bool last) {
+    std::memcpy(dst, &word, last ? perPixel : 4);
+}
+
+// Splits a call into a scalar head up to the first block boundary, whole
+// SIMD blocks, and a scalar tail
+struct BlockRange {
+    uint64_t headBytes;
+    uint64_t blocks;
+    uint64_t tailBytes;
+};
+
+BlockRange splitBlocks(unsigned perPixel, uint64_t streamOffset, uint64_t byteCount) {
+    BlockRange r;
+    r.headBytes = std::min<uint64_t>((perPixel - streamOffset % perPixel) % perPixel, byteCount);
+    r.blocks = (byteCount - r.headBytes) / perPixel;
+    r.tailBytes = byteCount - r.headBytes - r.blocks * perPixel;
+    return r;
+}
+
+} // namespace
+
+STEG_TARGET("ssse3")
+void embedSsse3(uint8_t* pixels, const Layout& layout, uint64_t streamOffset, const uint8_t* data, uint64_t byteCount) {
+    if (layout.bitsPerChannel != 1) {
+        embedScalar(pixels, layout, streamOffset, data, byteCount);
+        return;
+    }
+
+    const unsigned perPixel = channelsPerPixel(layout.channels);
+    const BlockTables& t = tablesFor(perPixel);
+    BlockRange r = splitBlocks(perPixel, streamOffset, byteCount);
+    embedScalar(pixels, layout, streamOffset, data, r.headBytes);
+
+    const __m128i one = _mm_set1_epi8(1);
+    const __m128i shuffle0 = _mm_load_si128((const __m128i*)t.shuffle);
+    const __m128i shuffle1 = _mm_load_si128((const __m128i*)(t.shuffle + 16));
+    const __m128i bit0 = _mm_load_si128((const __m128i*)t.bit);
+    const __m128i bit1 = _mm_load_si128((const __m128i*)(t.bit + 16));
+    const __m128i keep0 = _mm_load_si128((const __m128i*)t.keep);
+    const __m128i keep1 = _mm_load_si128((const __m128i*)(t.keep + 16));
+
+    const uint8_t* src = data + r.headBytes;
+    uint8_t* px = pixels + (streamOffset + r.headBytes) / perPixel * 32;
+    for (uint64_t b = 0; b < r.blocks; ++b, src += perPixel, px += 32) {
+        __m128i bits = _mm_set1_epi32((int)loadBlock(src, perPixel, b + 1 == r.blocks));
+
+        __m128i lo = _mm_loadu_si128((const __m128i*)px);
+        __m128i hi = _mm_loadu_si128((const __m128i*)(px + 16));
+        __m128i bitsLo = _mm_min_epu8(_mm_and_si128(_mm_shuffle_epi8(bits, shuffle0), bit0), one);
+        __m128i bitsHi = _mm_min_epu8(_mm_and_si128(_mm_shuffle_epi8(bits, shuffle1), bit1), one);
+        _mm_storeu_si128((__m128i*)px, _mm_or_si128(_mm_and_si128(lo, keep0), bitsLo));
+        _mm_storeu_si128((__m128i*)(px + 16), _mm_or_si128(_mm_and_si128(hi, keep1), bitsHi));
+    }
+
+    uint64_t done = r.headBytes + r.blocks * perPixel;
+    embedScalar(pixels, layout, streamOffset + done, data + done, r.tailBytes);
+}
+
+STEG_TARGET("ssse3")
+void extractSsse3(const uint8_t* pixels, const Layout& layout, uint64_t streamOffset, uint8_t* data, uint64_t byteCount) {
+    if (layout.bitsPerChannel != 1) {
+        extractScalar(pixels, layout, streamOffset, data, byteCount);
+        return;
+    }
+
+    const unsigned perPixel = channelsPerPixel(layout.channels);
+    BlockRange r = splitBlocks(perPixel, streamOffset, byteCount);
+    extractScalar(pixels, layout, streamOffset, data, r.headBytes);
+
+    uint8_t* dst = data + r.headBytes;
+    const uint8_t* px = pixels + (streamOffset + r.headBytes) / perPixel * 32;
+    for (uint64_t b = 0; b < r.blocks; ++b, dst += perPixel, px += 32) {
+        // Shifting 16-bit lanes left by 7 moves every byte's LSB to its MSB
+        __m128i lo = _mm_slli_epi16(_mm_loadu_si128((const __m128i*)px), 7);
+        __m128i hi = _mm_slli_epi16(_mm_loadu_si128((const __m128i*)(px + 16)), 7);
+        uint32_t mask = (uint32_t)_mm_movemask_epi8(lo) | ((uint32_t)_mm_movemask_epi8(hi) << 16);
+        storeBlock(dst, compactBits(mask, perPixel), perPixel, b + 1 == r.blocks);
+    }
+
+    uint64_t done = r.headBytes + r.blocks * perPixel;
+    extractScalar(pixels, layout, streamOffset + done, data + done, r.tailBytes);
+}
+
+STEG_TARGET("avx2,bmi2")
+void embedAvx2(uint8_t* pixels, const Layout& layout, uint64_t streamOffset, const uint8_t* data, uint64_t byteCount) {
+    if (layout.bitsPerChannel != 1) {
+        embedScalar(pixels, layout, streamOffset, data, byteCount);
+        return;
+    }
+
+    const unsigned perPixel = channelsPerPixel(layout.channels);
+    const BlockTables& t = tablesFor(perPixel);
+    BlockRange r = splitBlocks(perPixel, streamOffset, byteCount);
+    embedScalar(pixels, layout, streamOffset, data, r.headBytes);
+
+    // VPSHUFB shuffles within each 128-bit lane; the broadcast puts the
+    // payload bytes at offsets 0..3 of both lanes, so the tables still apply.
+    const __m256i one = _mm256_set1_epi8(1);
+    const __m256i shuffle = _mm256_load_si256((const __m256i*)t.shuffle);
+    const __m256i bit = _mm256_load_si256((const __m256i*)t.bit);
+    const __m256i keep = _mm256_load_si256((const __m256i*)t.keep);
+
+    const uint8_t* src = data + r.headBytes;
+    uint8_t* px = pixels + (streamOffset + r.headBytes) / perPixel * 32;
+    for (uint64_t b = 0; b < r.blocks; ++b, src += perPixel, px += 32) {
+        __m256i bits = _mm256_set1_epi32((int)loadBlock(src, perPixel, b + 1 == r.blocks));
+
+        __m256i p = _mm256_loadu_si256((const __m256i*)px);
+        __m256i lsb = _mm256_min_epu8(_mm256_and_si256(_mm256_shuffle_epi8(bits, shuffle), bit), one);
+        _mm256_storeu_si256((__m256i*)px, _mm256_or_si256(_mm256_and_si256(p, keep), lsb));
+    }
+
+    uint64_t done = r.headBytes + r.blocks * perPixel;
+    embedScalar(pixels, layout, streamOffset + done, data + done, r.tailBytes);
+}
+
+STEG_TARGET("avx2,bmi2")
+void extractAvx2(const uint8_t* pixels, const Layout& layout, uint64_t streamOffset, uint8_t* data, uint64_t byteCount) {
+    if (layout.bitsPerChannel != 1) {
+        extractScalar(pixels, layout, streamOffset, data, byteCount);
+        return;
+    }
+
+    const unsigned perPixel = channelsPerPixel(layout.channels);
+    const uint32_t channelMask = perPixel == 4 ? 0xFFFFFFFFu : 0x77777777u;
+    BlockRange r = splitBlocks(perPixel, streamOffset, byteCount);
+    extractScalar(pixels, layout, streamOffset, data, r.headBytes);
+
+    uint8_t* dst = data + r.headBytes;
+    const uint8_t* px = pixels + (streamOffset + r.headBytes) / perPixel * 32;
+    for (uint64_t b = 0; b < r.blocks; ++b, dst += perPixel, px += 32) {
+        __m256i p = _mm256_slli_epi16(_mm256_loadu_si256((const __m256i*)px), 7);
+        storeBlock(dst, _pext_u32((uint32_t)_mm256_movemask_epi8(p), channelMask), perPixel, b + 1 == r.blocks);
+    }
+
+    uint64_t done = r.headBytes + r.blocks * perPixel;
+    extractScalar(pixels, layout, streamOffset + done, data + done, r.tailBytes);
+}
+
+// --- LSB Matching ---
+// Same block layout as the replacement kernels. Per lane: `step` is all ones
+// where the LSB must change, `up` where the sign bit says +1 or the value is
+// 0 (and it is not 255); subtracting step & up and adding step & ~up moves
+// each changed lane by exactly one without branches or overflow.
+
+STEG_TARGET("ssse3")
+void embedMatchingSsse3(uint8_t* pixels, ChannelLayout channels, uint64_t streamOffset, const uint8_t* data,
+                        uint64_t byteCount, uint64_t key) {
+    const unsigned perPixel = channelsPerPixel(channels);
+    const BlockTables& t = tablesFor(perPixel);
+    BlockRange r = splitBlocks(perPixel, streamOffset, byteCount);
+    embedMatchingScalar(pixels, channels, streamOffset, data, r.headBytes, key);
+
+    const __m128i one = _mm_set1_epi8(1);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i full = _mm_set1_epi8((char)0xFF);
+    __m128i shuffle[2], bit[2], used[2], signShuffle[2], signBit[2];
+    for (unsigned h = 0; h < 2; ++h) {
+        shuffle[h] = _mm_load_si128((const __m128i*)(t.shuffle + 16 * h));
+        bit[h] = _mm_load_si128((const __m128i*)(t.bit + 16 * h));
+        used[h] = _mm_andnot_si128(_mm_load_si128((const __m128i*)(t.keep + 16 * h)), one);
+        signShuffle[h] = _mm_load_si128((const __m128i*)(t.signShuffle + 16 * h));
+        signBit[h] = _mm_load_si128((const __m128i*)(t.signBit + 16 * h));
+    }
+
+    const uint8_t* src = data + r.headBytes;
+    uint8_t* px = pixels + (streamOffset + r.headBytes) / perPixel * 32;
+    for (uint64_t b = 0; b < r.blocks; ++b, src += perPixel, px += 32) {
+        __m128i bits = _mm_set1_epi32((int)loadBlock(src, perPixel, b + 1 == r.blocks));
+        __m128i signs = _mm_set1_epi32((int)matchingSigns(key, (uint64_t)(px - pixels) / 32));
+        for (unsigned h = 0; h < 2; ++h) {
+            __m128i p = _mm_loadu_si128((const __m128i*)(px + 16 * h));
+            __m128i lsb = _mm_min_epu8(_mm_and_si128(_mm_shuffle_epi8(bits, shuffle[h]), bit[h]), one);
+            __m128i step = _mm_cmpeq_epi8(_mm_and_si128(_mm_xor_si128(p, lsb), used[h]), one);
+            __m128i up = _mm_cmpeq_epi8(_mm_and_si128(_mm_shuffle_epi8(signs, signShuffle[h]), signBit[h]), signBit[h]);
+            up = _mm_or_si128(_mm_andnot_si128(_mm_cmpeq_epi8(p, full), up), _mm_cmpeq_epi8(p, zero));
+            p = _mm_add_epi8(_mm_sub_epi8(p, _mm_and_si128(step, up)), _mm_andnot_si128(up, step));
+            _mm_storeu_si128((__m128i*)(px + 16 * h), p);
+        }
+    }
+
+    uint64_t done = r.headBytes + r.blocks * perPixel;
+    embedMatchingScalar(pixels, channels, streamOffset + done, data + done, r.tailBytes, key);
+}
+
+STEG_TARGET("avx2,bmi2")
+void embedMatchingAvx2(uint8_t* pixels, ChannelLayout channels, uint64_t streamOffset, const uint8_t* data,
+                       uint64_t byteCount, uint64_t key) {
+    const unsigned perPixel = channelsPerPixel(channels);
+    const BlockTables& t = tablesFor(perPixel);
+    BlockRange r = splitBlocks(perPixel, streamOffset, byteCount);
+    embedMatchingScalar(pixels, channels, streamOffset, data, r.headBytes, key);
+
+    const __m256i one = _mm256_set1_epi8(1);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i full = _mm256_set1_epi8((char)0xFF);
+    const __m256i shuffle = _mm256_load_si256((const __m256i*)t.shuffle);
+    const __m256i bit = _mm256_load_si256((const __m256i*)t.bit);
+    const __m256i used = _mm256_andnot_si256(_mm256_load_si256((const __m256i*)t.keep), one);
+    const __m256i signShuffle = _mm256_load_si256((const __m256i*)t.signShuffle);
+    const __m256i signBit = _mm256_load_si256((const __m256i*)t.signBit);
+
+    const uint8_t* src = data + r.headBytes;
+    uint8_t* px = pixels + (streamOffset + r.headBytes) / perPixel * 32;
+    for (uint64_t b = 0; b < r.blocks; ++b, src += perPixel, px += 32) {
+        __m256i bits = _mm256_set1_epi32((int)loadBlock(src, perPixel, b + 1 == r.blocks));
+        __m256i signs = _mm256_set1_epi32((int)matchingSigns(key, (uint64_t)(px - pixels) / 32));
+
+        __m256i p = _mm256_loadu_si256((const __m256i*)px);
+        __m256i lsb = _mm256_min_epu8(_mm256_and_si256(_mm256_shuffle_epi8(bits, shuffle), bit), one);
+        __m256i step = _mm256_cmpeq_epi8(_mm256_and_si256(_mm256_xor_si256(p, lsb), used), one);
+        __m256i up = _mm256_cmpeq_epi8(_mm256_and_si256(_mm256_shuffle_epi8(signs, signShuffle), signBit), signBit);
+        up = _mm256_or_si256(_mm256_andnot_si256(_mm256_cmpeq_epi8(p, full), up), _mm256_cmpeq_epi8(p, zero));
+        p = _mm256_add_epi8(_mm256_sub_epi8(p, _mm256_and_si256(step, up)), _mm256_andnot_si256(up, step));
+        _mm256_storeu_si256((__m256i*)px, p);
+    }
+
+    uint64_t done = r.headBytes + r.blocks * perPixel;
+    embedMatchingScalar(pixels, channels, streamOffset + done, data + done, r.tailBytes, key);
+}
+
+} // namespace Steganography
+
+#endif // STEG_X86_KERNELS
@@ -0,0 +1,125 @@
+#include "MatrixEmbedding.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "Bits.h"
+
+namespace Steganography {
+
+namespace {
+
+// The syndrome is linear over GF(2), so a group's syndrome is the XOR of the
+// syndromes of its bytes. Byte-sliced tables give a whole group in
+// ceil(n / 8) lookups: one for k = 3, eight for k = 6.
+struct SyndromeTables {
+    uint8_t table[kMaxHammingK + 1][8][256];
+};
+
+SyndromeTables makeTables() {
+    SyndromeTables tables = {};
+    for (unsigned k = kMinHammingK; k <= kMaxHammingK; ++k) {
+        for (unsigned slice = 0; slice < 8; ++slice) {
+            for (unsigned byte = 0; byte < 256; ++byte) {
+                unsigned syndrome = 0;
+                for (unsigned bit = 0; bit < 8; ++bit) {
+                    unsigned position = slice * 8 + bit + 1;
+                    if (((byte >> bit) & 1) && position < (1u << k)) {
+                        syndrome ^= position;
+                    }
+                }
+                tables.table[k][slice][byte] = (uint8_t)syndrome;
+            }
+        }
+    }
+    return tables;
+}
+
+const SyndromeTables& syndromeTables() {
+    static const SyndromeTables tables = makeTables();
+    return tables;
+}
+
+// Groups are processed in blocks so the gathered LSB plane stays in L1;
+// 4096 groups keep each block's first channel a multiple of 8
+const uint64_t kBlockGroups = 4096;
+
+inline unsigned syndromeOf(const uint8_t (*table)[256], unsigned slices, uint64_t lsbs) {
+    unsigned syndrome = table[0][lsbs & 0xFF];
+    for (unsigned slice = 1; slice < slices; ++slice) {
+        syndrome ^= table[slice][(lsbs >> (8 * slice)) & 0xFF];
+    }
+    return syndrome;
+}
+
+// Reads one n-bit group of LSBs; groups wider than a reader call (k = 6)
+// are read in two halves
+inline uint64_t readGroup(BitReader& reader, unsigned n) {
+    if (n <= 56) return reader.read(n);
+    uint64_t low = reader.read(32);
+    return low | (reader.read(n - 32) << 32);
+}
+
+} // namespace
+
+uint64_t hammingChannels(uint64_t byteCount, unsigned k) {
+    uint64_t groups = (byteCount * 8 + k - 1) / k;
+    return groups * ((1ull << k) - 1);
+}
+
+uint64_t hammingCapacityBytes(uint64_t channelCount, unsigned k) {
+    uint64_t groups = channelCount / ((1ull << k) - 1);
+    return groups * k / 8;
+}
+
+unsigned hammingSyndrome(uint64_t lsbs, unsigned k) {
+    return syndromeOf(syndromeTables().table[k], ((1u << k) - 1 + 7) / 8, lsbs);
+}
+
+void hammingEmbed(uint8_t* pixels, const ChannelOrder& order, uint64_t firstChannel, unsigned k,
+                  const uint8_t* data, uint64_t byteCount) {
+    const unsigned n = (1u << k) - 1;
+    const unsigned slices = (n + 7) / 8;
+    const uint8_t (*table)[256] = syndromeTables().table[k];
+    const uint64_t groups = (byteCount * 8 + k - 1) / k;
+
+    // The cover LSBs of each block are read with the fast extract kernel,
+    // then the groups are walked on the packed bits
+    std::vector<uint8_t> lsbs((size_t)(std::min(groups, kBlockGroups) * n + 7) / 8);
+    BitReader message(data, byteCount);
+    for (uint64_t block = 0; block < groups; block += kBlockGroups) {
+        uint64_t blockGroups = std::min(kBlockGroups, groups - block);
+        uint64_t blockChannel = firstChannel + block * n;
+        gatherLsbs(pixels, order, blockChannel, blockGroups * n, lsbs.data());
+
+        BitReader cover(lsbs.data(), (blockGroups * n + 7) / 8);
+        for (uint64_t g = 0; g < blockGroups; ++g) {
+            unsigned change = syndromeOf(table, slices, readGroup(cover, n)) ^ (unsigned)message.read(k);
+            if (change) {
+                pixels[channelByte(order, blockChannel + g * n + change - 1)] ^= 1;
+            }
+        }
+    }
+}
+
+void hammingExtract(const uint8_t* pixels, const ChannelOrder& order, uint64_t firstChannel, unsigned k,
+                    uint8_t* data, uint64_t byteCount) {
+    const unsigned n = (1u << k) - 1;
+    const unsigned slices = (n + 7) / 8;
+    const uint8_t (*table)[256] = syndromeTables().table[k];
+    const uint64_t groups = (byteCount * 8 + k - 1) / k;
+
+    std::vector<uint8_t> lsbs((size_t)(std::min(groups, kBlockGroups) * n + 7) / 8);
+    BitWriter message(data, byteCount);
+    for (uint64_t block = 0; block < groups; block += kBlockGroups) {
+        uint64_t blockGroups = std::min(kBlockGroups, groups - block);
+        gatherLsbs(pixels, order, firstChannel + block * n, blockGroups * n, lsbs.data());
+
+        BitReader stego(lsbs.data(), (blockGroups * n + 7) / 8);
+        for (uint64_t g = 0; g < blockGroups; ++g) {
+            message.write(syndromeOf(table, slices, readGroup(stego, n)), k);
+        }
+    }
+}
+
+} // namespace Steganography
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+
+#include "Traversal.h"
+
+// --- Matrix Embedding (binary Hamming codes) ---
+// k payload bits are carried by the LSBs of a group of n = 2^k - 1 channels:
+// the message is the group's syndrome, the XOR of the 1-based positions of
+// its LSBs that are set. Embedding changes at most one LSB per group, versus
+// an expected k/2 changes for plain LSB replacement.
+//
+// Groups are laid out back to back starting at `firstChannel`; payload bit i
+// belongs to group i / k. Only the LSB plane is used, so the layout's bit
+// depth is ignored.
+namespace Steganography {
+
+const unsigned kMinHammingK = 2;
+const unsigned kMaxHammingK = 6;
+
+// Channels needed to carry `byteCount` payload bytes
+uint64_t hammingChannels(uint64_t byteCount, unsigned k);
+
+// Payload bytes that fit in `channelCount` channels
+uint64_t hammingCapacityBytes(uint64_t channelCount, unsigned k);
+
+// Syndrome of one n-bit group of LSBs (bit i = LSB of the group's channel i)
+unsigned hammingSyndrome(uint64_t lsbs, unsigned k);
+
+// Embeds/extracts `byteCount` payload bytes in the groups starting at
+// `firstChannel`. Callers split work so `firstChannel` is a multiple of 8.
+void hammingEmbed(uint8_t* pixels, const ChannelOrder& order, uint64_t firstChannel, unsigned k,
+                  const uint8_t* data, uint64_t byteCount);
+void hammingExtract(const uint8_t* pixels, const ChannelOrder& order, uint64_t firstChannel, unsigned k,
+                    uint8_t* data, uint64_t byteCount);
+
+} // namespace Steganography
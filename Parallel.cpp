@@ -0,0 +1,54 @@
+#include "Parallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace Steganography {
+
+unsigned workerCount(unsigned requested) {
+    if (requested > 0) return requested;
+    unsigned hardware = std::thread::hardware_concurrency();
+    return hardware > 0 ? hardware : 1;
+}
+
+bool parallelFor(uint64_t count, uint64_t grain, unsigned threads,
+                 const std::function<bool(uint64_t, uint64_t)>& fn,
+                 const std::function<void()>& afterCallerPiece) {
+    if (count == 0) return true;
+    grain = std::max<uint64_t>(grain, 1);
+    uint64_t pieces = (count + grain - 1) / grain;
+    unsigned workers = (unsigned)std::min<uint64_t>(workerCount(threads), pieces);
+
+    std::atomic<uint64_t> next{0};
+    std::atomic<bool> stopped{false};
+
+    auto work = [&](bool isCaller) {
+        while (!stopped.load(std::memory_order_relaxed)) {
+            uint64_t piece = next.fetch_add(1, std::memory_order_relaxed);
+            if (piece >= pieces) break;
+
+            uint64_t begin = piece * grain;
+            uint64_t end = std::min(count, begin + grain);
+            if (!fn(begin, end)) {
+                stopped = true;
+            }
+            if (isCaller && afterCallerPiece) {
+                afterCallerPiece();
+            }
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned i = 1; i < workers; ++i) {
+        pool.emplace_back(work, false);
+    }
+    work(true);
+    for (auto& thread : pool) {
+        thread.join();
+    }
+    return !stopped;
+}
+
+} // namespace Steganography
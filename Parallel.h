@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+// --- Parallel Loops ---
+namespace Steganography {
+
+// Number of worker threads to use; 0 means one per hardware thread
+unsigned workerCount(unsigned requested);
+
+// Splits [0, count) into `grain`-sized pieces that up to `threads` workers
+// pull from a shared counter, calling fn(begin, end) for each. The calling
+// thread is one of the workers and runs `afterCallerPiece` after each of its
+// own pieces, so callbacks such as progress sinks never run on a worker.
+// Stops handing out pieces once fn returns false; returns false in that case.
+bool parallelFor(uint64_t count, uint64_t grain, unsigned threads,
+                 const std::function<bool(uint64_t, uint64_t)>& fn,
+                 const std::function<void()>& afterCallerPiece = nullptr);
+
+} // namespace Steganography
@@ -0,0 +1,2989 @@
+#include "Steganography.h"
+
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+#include "AudioCarrier.h"
+#include "CarrierCache.h"
+#include "CarrierIndex.h"
+#include "Checksum.h"
+#include "Encryption.h"
+#include "ErasureCode.h"
+#include "FileIo.h"
+#include "ImageProbe.h"
+#include "JpegCarrier.h"
+#include "MatrixEmbedding.h"
+#include "Parallel.h"
+#include "SyndromeTrellis.h"
+#include "Traversal.h"
+
+namespace Steganography {
+
+// --- Payload Header ---
+// The bit stream opens with a 24-byte versioned header. It is always written
+// at 1 bit per RGB channel over the first kHeaderPixels pixels in index
+// order (in a JPEG: F4, k = 1, over the first coefficients in index order;
+// in a WAV file: 1 bit per sample over the first samples), whatever the
+// job's layout and traversal, so a decoder finds it without knowing either:
+//    0  magic "StG", version
+//    4  flags: encrypted, chunk CRCs, RGBA, sharded, container
+//    5  codec
+//    6  bits per channel
+//    7  traversal mode
+//    8  embed mode, mode parameter (Hamming k or trellis width)
+//   10  reserved, zero (2)
+//   12  stored payload size (8)
+//   20  CRC32C of bytes 0-19
+// A damaged header is turned away after its 192 bits. A carrier whose first
+// 24 bits are not the magic and version is read as a bare size word stream
+// (below), which the size check turns away unless the word fits the image.
+//
+// The payload stream follows from the first pixel past the header, in the
+// recorded layout, mode and traversal (a keyed traversal holds the header
+// pixels in place). A shard of a sharded set opens it with a 36-byte shard
+// record:
+//    0  set ID (8), shared by every shard of the set
+//    8  offset of this shard in the set's payload (8; zero with parity)
+//   16  set payload size (8)
+//   24  shard index, shard count (2 each)
+//   28  data shards of a set with parity (2), zero for a plain split
+//   30  reserved, zero (2)
+//   32  CRC32C of bytes 0-31
+// Then comes an optional table of one CRC32C per payload chunk (see
+// chunkBytes), and then the payload. Record and table are written like the
+// header.
+//
+// Streams from before the header open with a bare 32-bit size word at the
+// start of the payload stream itself, and leave layout, mode and traversal
+// to the decoder's options.
+const uint8_t kHeaderVersion = 2;
+const uint32_t kHeaderBytes = 24;
+const uint64_t kHeaderPixels = kHeaderBytes * 8 / 3;
+const Layout kHeaderLayout; // 1 bit per RGB channel
+const uint8_t kHeaderMagic[3] = {'S', 't', 'G'};
+const uint8_t kFlagEncrypted = 1;
+const uint8_t kFlagChunkCrcs = 2;
+const uint8_t kFlagRgba = 4;
+const uint8_t kFlagSharded = 8;
+const uint8_t kFlagContainer = 16;
+const uint32_t kShardRecordBytes = 36;
+const uint32_t kLegacyHeaderBytes = 4;
+
+struct PayloadHeader {
+    uint8_t version = kHeaderVersion; // 0 for a bare size word
+    uint64_t bytes = 0;               // Stored (compressed, sealed) payload size
+    Compression codec = Compression::None;
+    bool encrypted = false;
+    bool chunkCrcs = false;
+    // Recorded from version 2 on
+    Layout layout;
+    TraversalMode traversal = TraversalMode::Sequential;
+    EmbedMode mode = EmbedMode::Replace;
+    unsigned modeParameter = 0;
+    // Shards only: this stream is bytes [shardOffset, shardOffset + bytes)
+    // of a setBytes payload split over shardCount images. With parity the
+    // first dataShards shards are equal slices of the payload (the last one
+    // zero-padded) and the rest are Reed-Solomon parity over them.
+    bool sharded = false;
+    bool container = false; // The payload is a container of named entries
+    uint64_t setId = 0;
+    uint32_t shardIndex = 0;
+    uint32_t shardCount = 0;
+    uint32_t dataShards = 0;
+    uint64_t shardOffset = 0;
+    uint64_t setBytes = 0;
+};
+
+// Helper to forward a progress update if the caller asked for one
+static void report(const Options& options, Phase phase, uint64_t done, uint64_t total) {
+    if (options.onProgress) {
+        options.onProgress(Progress{phase, done, total});
+    }
+}
+
+// Helper to check whether the caller asked the job to stop
+static bool isCancelled(const Options& options) {
+    return options.cancelToken && options.cancelToken->isCancelled();
+}
+
+// Monotonic stopwatch used to time each phase of a job
+class Stopwatch {
+public:
+    Stopwatch() : start(std::chrono::steady_clock::now()) {}
+    double elapsedMs() const {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+    double lapMs() {
+        auto now = std::chrono::steady_clock::now();
+        double ms = std::chrono::duration<double, std::milli>(now - start).count();
+        start = now;
+        return ms;
+    }
+private:
+    std::chrono::steady_clock::time_point start;
+};
+
+// Helper to stamp a job's outcome and total time before returning it
+static JobResult finish(JobResult result, bool ok, const std::string& message, const Stopwatch& total) {
+    result.ok = ok;
+    result.message = message;
+    result.timings.totalMs = total.elapsedMs();
+    return result;
+}
+
+// Header fields for a job with these options; the sizes and codec come later
+static PayloadHeader headerFor(const Options& options) {
+    PayloadHeader fields;
+    fields.chunkCrcs = options.chunkCrcs;
+    fields.layout = options.layout;
+    fields.traversal = options.traversal;
+    fields.mode = options.mode;
+    if (options.mode == EmbedMode::Hamming) fields.modeParameter = options.hammingK;
+    if (options.mode == EmbedMode::Stc) fields.modeParameter = options.stcWidth;
+    return fields;
+}
+
+static void packHeader(const PayloadHeader& fields, uint8_t* header) {
+    std::memset(header, 0, kHeaderBytes);
+    std::memcpy(header, kHeaderMagic, 3);
+    header[3] = kHeaderVersion;
+    header[4] = (uint8_t)((fields.encrypted ? kFlagEncrypted : 0) | (fields.chunkCrcs ? kFlagChunkCrcs : 0) |
+                          (fields.layout.channels == ChannelLayout::RGBA ? kFlagRgba : 0) |
+                          (fields.sharded ? kFlagSharded : 0) | (fields.container ? kFlagContainer : 0));
+    header[5] = (uint8_t)fields.codec;
+    header[6] = (uint8_t)fields.layout.bitsPerChannel;
+    header[7] = (uint8_t)fields.traversal;
+    header[8] = (uint8_t)fields.mode;
+    header[9] = (uint8_t)fields.modeParameter;
+    storeLe64(fields.bytes, header + 12);
+    storeLe32(crc32c(header, 20), header + 20);
+}
+
+static void packShardRecord(const PayloadHeader& fields, uint8_t* record) {
+    storeLe64(fields.setId, record);
+    storeLe64(fields.shardOffset, record + 8);
+    storeLe64(fields.setBytes, record + 16);
+    storeLe32(fields.shardIndex | (fields.shardCount << 16), record + 24);
+    storeLe32(fields.dataShards, record + 28);
+    storeLe32(crc32c(record, 32), record + 32);
+}
+
+// Parses a shard record into `fields`. Returns "" or an error message.
+static std::string unpackShardRecord(const uint8_t* record, PayloadHeader& fields) {
+    if (crc32c(record, 32) != loadLe32(record + 32)) {
+        return "Error: The shard record is corrupted.";
+    }
+    fields.setId = loadLe64(record);
+    fields.shardOffset = loadLe64(record + 8);
+    fields.setBytes = loadLe64(record + 16);
+    fields.shardIndex = loadLe32(record + 24) & 0xFFFF;
+    fields.shardCount = loadLe32(record + 24) >> 16;
+    fields.dataShards = loadLe32(record + 28);
+    bool fits = fields.dataShards == 0
+                    ? fields.shardOffset <= fields.setBytes && fields.bytes <= fields.setBytes - fields.shardOffset
+                    : fields.dataShards <= fields.shardCount && fields.shardOffset == 0 &&
+                          fields.bytes == (fields.setBytes + fields.dataShards - 1) / fields.dataShards;
+    if (fields.shardIndex >= fields.shardCount || !fits) {
+        return "Error: The shard record is invalid.";
+    }
+    return "";
+}
+
+// True when the first 4 stream bytes open a version 2 header
+static bool isVersioned(const uint8_t* header) {
+    return std::memcmp(header, kHeaderMagic, 3) == 0 && header[3] == kHeaderVersion;
+}
+
+// Parses a version 2 header. Returns "" or an error message.
+static std::string unpackHeader(const uint8_t* header, PayloadHeader& fields) {
+    if (crc32c(header, 20) != loadLe32(header + 20)) {
+        return "Error: The hidden data header is corrupted.";
+    }
+    const uint8_t flags = header[4];
+    fields.version = kHeaderVersion;
+    fields.encrypted = flags & kFlagEncrypted;
+    fields.chunkCrcs = flags & kFlagChunkCrcs;
+    fields.layout.channels = flags & kFlagRgba ? ChannelLayout::RGBA : ChannelLayout::RGB;
+    fields.sharded = flags & kFlagSharded;
+    fields.container = flags & kFlagContainer;
+    fields.codec = (Compression)header[5];
+    fields.layout.bitsPerChannel = header[6];
+    fields.traversal = (TraversalMode)header[7];
+    fields.mode = (EmbedMode)header[8];
+    fields.modeParameter = header[9];
+    fields.bytes = loadLe64(header + 12);
+    // Values are range-checked here; validate() checks how they combine
+    if ((flags & ~(kFlagEncrypted | kFlagChunkCrcs | kFlagRgba | kFlagSharded | kFlagContainer)) || fields.codec > Compression::Lz4 ||
+        fields.traversal > TraversalMode::Keyed || fields.mode > EmbedMode::Stc || header[10] || header[11]) {
+        return "Error: The hidden data header has fields this version does not know.";
+    }
+    return "";
+}
+
+// Reads a bare size word: a plain, uncompressed payload of that many bytes
+static void unpackLegacyHeader(const uint8_t* header, PayloadHeader& fields) {
+    fields.version = 0;
+    fields.bytes = loadLe32(header);
+}
+
+// Helper to read the secret file as the payload to embed: compressed when the
+// options ask for it, then sealed when they carry a passphrase. Data that
+// does not shrink is stored raw, with the header saying so.
+static std::string readSecret(const std::string& path, const Options& options, std::vector<char>& payload,
+                              PayloadHeader& fields, JobResult& result) {
+    Stopwatch timer;
+    uint64_t rawBytes = 0;
+    std::string error = compressFile(path, options.compression, payload, rawBytes);
+    if (!error.empty()) {
+        return error;
+    }
+    fields.codec = options.compression;
+    if (fields.codec != Compression::None) {
+        result.timings.codecMs = timer.lapMs();
+        if (payload.size() >= rawBytes) {
+            error = compressFile(path, Compression::None, payload, rawBytes);
+            fields.codec = Compression::None;
+        }
+    }
+    result.bytesRead += rawBytes;
+
+    fields.encrypted = !options.passphrase.empty();
+    if (error.empty() && fields.encrypted) {
+        timer.lapMs();
+        std::vector<char> sealed;
+        error = seal(options.passphrase, payload.data(), payload.size(), sealed, options.threads);
+        payload.swap(sealed);
+        result.timings.cryptoMs = timer.lapMs();
+    }
+    fields.bytes = payload.size();
+    return error;
+}
+
+// Helper to write an extracted payload out as the secret file, opening and
+// decompressing it as its header says
+static std::string writeSecret(const std::string& path, std::vector<char>& payload, const PayloadHeader& fields,
+                               const Options& options, JobResult& result) {
+    Stopwatch timer;
+    if (fields.encrypted) {
+        if (options.passphrase.empty()) {
+            return "Error: The hidden data is encrypted; a passphrase is needed.";
+        }
+        std::vector<char> plain;
+        std::string error = open(options.passphrase, payload.data(), payload.size(), plain, options.threads);
+        result.timings.cryptoMs = timer.lapMs();
+        if (!error.empty()) {
+            return error;
+        }
+        payload.swap(plain);
+    }
+
+    uint64_t rawBytes = 0;
+    std::string error = decompressToFile(payload.data(), payload.size(), fields.codec, path, rawBytes);
+    if (fields.codec != Compression::None) {
+        result.timings.codecMs = timer.lapMs();
+    }
+    result.bytesWritten = rawBytes;
+    return error;
+}
+
+// Helper to get a file's size without failing the job if it is unavailable
+static uint64_t fileSize(const std::string& path) {
+    std::error_code ec;
+    uintmax_t size = std::filesystem::file_size(path, ec);
+    return ec ? 0 : (uint64_t)size;
+}
+
+// Loads a lossless carrier, through the caller's cache when there is one;
+// only a load from disk counts as bytes read
+static bool loadCarrier(const std::string& path, const Options& options, sf::Image& image, JobResult& result) {
+    FileStamp stamp;
+    std::shared_ptr<const DecodedCarrier> cached = options.carrierCache ? options.carrierCache->find(path, stamp) : nullptr;
+    if (cached) {
+        image.create(cached->width, cached->height, cached->rgba.data());
+        return true;
+    }
+    if (!image.loadFromFile(path)) return false;
+    result.bytesRead += fileSize(path);
+    if (options.carrierCache) {
+        options.carrierCache->insert(path, stamp, image.getSize().x, image.getSize().y, image.getPixelsPtr());
+    }
+    return true;
+}
+
+// Helper to reject option combinations the kernels cannot handle
+static std::string validate(const Options& options) {
+    const Layout& layout = options.layout;
+    if (layout.bitsPerChannel != 1 && layout.bitsPerChannel != 2 && layout.bitsPerChannel != 4) {
+        return "Error: Bits per channel must be 1, 2 or 4.";
+    }
+    if (options.mode == EmbedMode::Matching && layout.bitsPerChannel != 1) {
+        return "Error: LSB matching needs 1 bit per channel.";
+    }
+    if (options.mode == EmbedMode::Hamming) {
+        if (layout.bitsPerChannel != 1) {
+            return "Error: Matrix embedding needs 1 bit per channel.";
+        }
+        if (options.hammingK < kMinHammingK || options.hammingK > kMaxHammingK) {
+            return "Error: Matrix embedding k must be between 2 and 6.";
+        }
+    }
+    if (options.mode == EmbedMode::Stc) {
+        if (layout.bitsPerChannel != 1) {
+            return "Error: Trellis embedding needs 1 bit per channel.";
+        }
+        if (options.stcWidth < kMinStcWidth || options.stcWidth > kMaxStcWidth) {
+            return "Error: Trellis width must be between 2 and 16.";
+        }
+    }
+    if (options.costFilter != CostFilter::None && options.mode != EmbedMode::Stc) {
+        return "Error: Adaptive costs need trellis embedding.";
+    }
+    if (options.traversal == TraversalMode::Keyed && options.key.empty()) {
+        return "Error: Keyed traversal needs a key.";
+    }
+    return "";
+}
+
+// The options a stream was written with: a version 2 header records the
+// layout, mode and traversal; older streams go by the caller's options.
+// Returns "" or an error message.
+static std::string streamOptions(const PayloadHeader& fields, const Options& options, Options& job) {
+    job = options;
+    if (fields.version < kHeaderVersion) {
+        return "";
+    }
+    job.layout = fields.layout;
+    job.traversal = fields.traversal;
+    job.mode = fields.mode;
+    if (fields.mode == EmbedMode::Hamming) job.hammingK = fields.modeParameter;
+    if (fields.mode == EmbedMode::Stc) job.stcWidth = fields.modeParameter;
+    job.costFilter = CostFilter::None;
+    if (job.traversal == TraversalMode::Keyed && job.key.empty()) {
+        return "Error: The hidden data is scattered with a key; the key is needed.";
+    }
+    return validate(job);
+}
+
+// Buffer channels ahead of the payload stream's permuted part: the header
+// pixels of a version 2 stream
+static uint64_t headerChannels(const PayloadHeader& fields, const Options& options) {
+    return fields.version >= kHeaderVersion ? kHeaderPixels * channelsPerPixel(options.layout.channels) : 0;
+}
+
+// Helper to build the permutation a keyed traversal walks; building one is
+// just deriving round keys, so each job makes its own
+static ChannelPermutation permutationFor(const Options& options, const sf::Vector2u& imageSize,
+                                         uint64_t fixedChannels) {
+    uint64_t channels = (uint64_t)imageSize.x * imageSize.y * channelsPerPixel(options.layout.channels);
+    return ChannelPermutation(channels, traversalKey(options.key), fixedChannels);
+}
+
+// --- Payload Modes ---
+// The header and chunk CRC table are plain LSB (matched rather than replaced
+// in Matching mode); the payload that follows is written according to
+// Options::mode. Matching only changes how LSBs are set, so it extracts like
+// Replace. Its sign stream is keyed by Options::key,
+// which the decoder never needs.
+
+// Channel-stream bits the payload occupies after the header
+static uint64_t payloadBits(uint64_t bytes, const Options& options) {
+    if (options.mode == EmbedMode::Hamming) {
+        return hammingChannels(bytes, options.hammingK);
+    }
+    if (options.mode == EmbedMode::Stc) {
+        return stcChannels(bytes, options.stcWidth);
+    }
+    return bytes * 8;
+}
+
+// Chunk size for progress/cancellation and threading. Hamming chunks are a
+// whole number of groups so each chunk starts on a byte of the LSB plane;
+// STC chunks are whole trellis blocks, kept small since each is far more work
+// per byte than plain LSB.
+static uint64_t chunkBytes(const Options& options) {
+    if (options.mode == EmbedMode::Hamming) {
+        return options.hammingK * (kChunkBytes / 8);
+    }
+    if (options.mode == EmbedMode::Stc) {
+        return 4 * kStcBlockBytes;
+    }
+    return kChunkBytes;
+}
+
+// Entries in the chunk CRC table of a payload of `bytes`
+static uint64_t chunkCount(uint64_t bytes, const Options& options) {
+    return (bytes + chunkBytes(options) - 1) / chunkBytes(options);
+}
+
+// Payload-stream bytes the header takes: those of the header pixels for a
+// version 2 stream, the size word for a bare one
+static uint64_t headerStreamBytes(const PayloadHeader& fields, const Options& options) {
+    if (fields.version >= kHeaderVersion) {
+        return kHeaderPixels * channelsPerPixel(options.layout.channels) * options.layout.bitsPerChannel / 8;
+    }
+    return kLegacyHeaderBytes;
+}
+
+// Payload-stream bytes ahead of the chunk CRC table: the header and any
+// shard record
+static uint64_t recordsEnd(const PayloadHeader& fields, const Options& options) {
+    return headerStreamBytes(fields, options) + (fields.sharded ? kShardRecordBytes : 0);
+}
+
+// Payload-stream bytes ahead of the payload: the header, any shard record
+// and any chunk CRC table
+static uint64_t prefixBytes(const PayloadHeader& fields, const Options& options) {
+    return recordsEnd(fields, options) + (fields.chunkCrcs ? 4 * chunkCount(fields.bytes, options) : 0);
+}
+
+// Chunk CRC table for the fields.bytes payload bytes at `data`, empty unless
+// the header asks for one
+static std::vector<uint8_t> chunkTable(const PayloadHeader& fields, const uint8_t* data, const Options& options) {
+    std::vector<uint8_t> table(fields.chunkCrcs ? 4 * chunkCount(fields.bytes, options) : 0);
+    if (!table.empty()) {
+        const uint64_t chunk = chunkBytes(options);
+        parallelFor(fields.bytes, chunk, options.threads, [&](uint64_t begin, uint64_t end) {
+            storeLe32(crc32c(data + begin, end - begin), table.data() + 4 * (begin / chunk));
+            return true;
+        });
+    }
+    return table;
+}
+
+// Writes header or table bytes: plain LSB, matched in Matching mode
+static void embedPlain(uint8_t* pixels, const Layout& layout, const ChannelOrder& order, const Options& options,
+                       uint64_t streamOffset, const uint8_t* data, uint64_t count) {
+    if (options.mode == EmbedMode::Matching) {
+        embedMatchingOrdered(pixels, order, streamOffset, data, count, traversalKey(options.key));
+    } else {
+        embedOrdered(pixels, layout, order, streamOffset, data, count);
+    }
+}
+
+// `prefix` is the stream bytes ahead of the payload (prefixBytes)
+static void embedPayload(uint8_t* pixels, const Options& options, const ChannelOrder& order, const float* pixelCosts,
+                         uint64_t prefix, uint64_t offset, const uint8_t* data, uint64_t count) {
+    if (options.mode == EmbedMode::Hamming) {
+        uint64_t firstChannel = prefix * 8 + payloadBits(offset, options);
+        hammingEmbed(pixels, order, firstChannel, options.hammingK, data, count);
+    } else if (options.mode == EmbedMode::Stc) {
+        uint64_t firstChannel = prefix * 8 + payloadBits(offset, options);
+        stcEmbed(pixels, order, firstChannel, options.stcWidth, data, count, pixelCosts);
+    } else if (options.mode == EmbedMode::Matching) {
+        embedMatchingOrdered(pixels, order, prefix + offset, data, count, traversalKey(options.key));
+    } else {
+        embedOrdered(pixels, options.layout, order, prefix + offset, data, count);
+    }
+}
+
+// `skipped` is the stream bytes ahead of `pixels` when they are a window
+// starting part way into the image (StoredPayload::setWindow)
+static void extractPayload(const uint8_t* pixels, const Options& options, const ChannelOrder& order, uint64_t prefix,
+                           uint64_t offset, uint8_t* data, uint64_t count, uint64_t skipped = 0) {
+    if (options.mode == EmbedMode::Hamming) {
+        uint64_t firstChannel = prefix * 8 + payloadBits(offset, options) - skipped * 8;
+        hammingExtract(pixels, order, firstChannel, options.hammingK, data, count);
+    } else if (options.mode == EmbedMode::Stc) {
+        uint64_t firstChannel = prefix * 8 + payloadBits(offset, options) - skipped * 8;
+        stcExtract(pixels, order, firstChannel, options.stcWidth, data, count);
+    } else {
+        extractOrdered(pixels, options.layout, order, prefix + offset - skipped, data, count);
+    }
+}
+
+// Pixels covered by `prefix` stream bytes plus a payload of `bytes`
+static uint64_t pixelsUsed(uint64_t prefix, uint64_t bytes, const Options& options) {
+    uint64_t bits = prefix * 8 + payloadBits(bytes, options);
+    return pixelsForBytes((bits + 7) / 8, options.layout);
+}
+
+// Message for a chunk whose CRC32C does not match the table
+static std::string corruptChunk(uint64_t index, uint64_t count) {
+    return "Error: Hidden data is corrupted (chunk " + std::to_string(index + 1) + " of " + std::to_string(count) +
+           " fails its checksum).";
+}
+
+// Message for a shard met outside a gather
+const char* const kShardedImage = "Error: This image holds one shard of a sharded payload; gather the whole set.";
+
+// Message for a container met by a single-payload decode
+const char* const kContainerImage = "Error: This image holds named entries; extract them by name.";
+
+// --- JPEG Carriers ---
+// JPEG jobs embed in the quantized DCT coefficients with F5 (see
+// JpegCarrier.h) instead of pixel LSBs. The header is F4-coded (k = 1) over
+// the first non-zero coefficients in index order, and the payload walk (keyed
+// or not) covers the coefficients after the last one the header used. The
+// chunk CRC table opens the payload walk, also F4-coded; the payload uses
+// k = Options::hammingK in Hamming mode and k = 1 otherwise. Shrinkage makes
+// F5 sequential, so these jobs run on the calling thread.
+
+static std::string validateJpeg(const Options& options) {
+    if (options.mode != EmbedMode::Replace && options.mode != EmbedMode::Hamming) {
+        return "Error: JPEG carriers support plain and matrix (--hamming) embedding only.";
+    }
+    if (options.layout.bitsPerChannel != 1) {
+        return "Error: JPEG carriers hold 1 bit per coefficient.";
+    }
+    return "";
+}
+
+// Payload bits per F5 group
+static unsigned jpegK(const Options& options) {
+    return options.mode == EmbedMode::Hamming ? options.hammingK : 1;
+}
+
+static JobResult encodeJpeg(const std::string& carrierPath, const std::string& secretPath,
+                            const std::string& outputPath, const Options& options) {
+    JobResult result;
+    Stopwatch total, phase;
+
+    std::string invalid = validateJpeg(options);
+    if (!invalid.empty()) {
+        return finish(result, false, invalid, total);
+    }
+    if (!isJpegPath(outputPath)) {
+        return finish(result, false, "Error: A JPEG carrier must be saved as a .jpg file.", total);
+    }
+
+    report(options, Phase::Loading, 0, 0);
+    JpegImage carrier;
+    if (!carrier.load(carrierPath)) {
+        return finish(result, false, "Error: Could not load carrier image.", total);
+    }
+    result.bytesRead += fileSize(carrierPath);
+
+    std::vector<char> secretData;
+    PayloadHeader fields = headerFor(options);
+    std::string unreadable = readSecret(secretPath, options, secretData, fields, result);
+    if (!unreadable.empty()) {
+        return finish(result, false, unreadable, total);
+    }
+    uint64_t secretSize = secretData.size();
+    result.timings.loadMs = phase.lapMs();
+
+    uint8_t header[kHeaderBytes];
+    packHeader(fields, header);
+    report(options, Phase::Embedding, 0, secretSize);
+    F5Writer headerWriter(carrier);
+    bool fits = headerWriter.write(header, kHeaderBytes, 1);
+
+    const uint64_t first = headerWriter.end();
+    ChannelPermutation permutation(carrier.coefficientCount(), traversalKey(options.key), first);
+    F5Writer writer(carrier, options.traversal == TraversalMode::Keyed ? &permutation : nullptr, first);
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(secretData.data());
+    std::vector<uint8_t> table = chunkTable(fields, data, options);
+    fits = fits && writer.write(table.data(), table.size(), 1);
+
+    // Chunks hold whole groups, so only the last one is padded
+    const uint64_t chunk = chunkBytes(options);
+    for (uint64_t begin = 0; fits && begin < secretSize; begin += chunk) {
+        if (isCancelled(options)) {
+            return finish(result, false, "Cancelled: Encoding stopped before completion. No output was written.", total);
+        }
+        uint64_t count = std::min<uint64_t>(chunk, secretSize - begin);
+        fits = writer.write(data + begin, count, jpegK(options));
+        report(options, Phase::Embedding, begin + count, secretSize);
+    }
+    if (!fits) {
+        return finish(result, false, "Error: Carrier image is too small to hold the secret data.", total);
+    }
+    result.pixelsTouched = (uint64_t)carrier.width() * carrier.height();
+    result.timings.processMs = phase.lapMs();
+
+    report(options, Phase::Saving, secretSize, secretSize);
+    if (!carrier.save(outputPath)) {
+        return finish(result, false, "Error: Failed to save the output image.", total);
+    }
+    result.bytesWritten = fileSize(outputPath);
+    result.timings.saveMs = phase.lapMs();
+
+    return finish(result, true, "Success! Data encoded and saved to " + outputPath, total);
+}
+
+static JobResult decodeJpeg(const std::string& stegoPath, const std::string& outputPath, const Options& options) {
+    JobResult result;
+    Stopwatch total, phase;
+
+    std::string invalid = validateJpeg(options);
+    if (!invalid.empty()) {
+        return finish(result, false, invalid, total);
+    }
+
+    report(options, Phase::Loading, 0, 0);
+    JpegImage stego;
+    if (!stego.load(stegoPath)) {
+        return finish(result, false, "Error: Could not load the steganographic image.", total);
+    }
+    result.bytesRead = fileSize(stegoPath);
+    result.timings.loadMs = phase.lapMs();
+    result.pixelsTouched = (uint64_t)stego.width() * stego.height();
+
+    // The version 2 header comes first, in index order, and the payload
+    // walk starts after it. JPEG carriers have never been written without
+    // one.
+    uint8_t header[kHeaderBytes];
+    F5Reader headerReader(stego);
+    if (!headerReader.read(header, 4, 1) || !isVersioned(header) ||
+        !headerReader.read(header + 4, kHeaderBytes - 4, 1)) {
+        return finish(result, false, "Error: The image holds no hidden data.", total);
+    }
+    PayloadHeader fields;
+    Options job = options;
+    invalid = unpackHeader(header, fields);
+    if (invalid.empty() && fields.sharded) invalid = kShardedImage;
+    if (invalid.empty() && fields.container) invalid = kContainerImage;
+    if (invalid.empty()) invalid = streamOptions(fields, options, job);
+    if (invalid.empty()) invalid = validateJpeg(job);
+    if (!invalid.empty()) {
+        return finish(result, false, invalid, total);
+    }
+    const uint64_t first = headerReader.end();
+    ChannelPermutation permutation(stego.coefficientCount(), traversalKey(job.key), first);
+    F5Reader reader(stego, job.traversal == TraversalMode::Keyed ? &permutation : nullptr, first);
+    uint64_t secretSize = fields.bytes;
+
+    // Sanity check: every group takes 2^k - 1 coefficients. The walk only
+    // finds out how many non-zero ones are left by reaching them, so a size
+    // that passes here can still run out below.
+    const unsigned k = jpegK(job);
+    const uint64_t tableBytes = prefixBytes(fields, job) - headerStreamBytes(fields, job);
+    if (secretSize > stego.coefficientCount() / 8 ||
+        tableBytes * 8 + (secretSize * 8 + k - 1) / k * ((1u << k) - 1) > stego.coefficientCount()) {
+        return finish(result, false, "Error: Decoded size is invalid or larger than image capacity.", total);
+    }
+    if (secretSize == 0) {
+        return finish(result, false, "Warning: Decoded size is 0. Nothing to extract.", total);
+    }
+    std::vector<uint8_t> table(tableBytes);
+    if (!reader.read(table.data(), tableBytes, 1)) {
+        return finish(result, false, "Error: Decoded size is invalid or larger than image capacity.", total);
+    }
+
+    std::vector<char> secretData(secretSize);
+    report(options, Phase::Extracting, 0, secretSize);
+    uint8_t* data = reinterpret_cast<uint8_t*>(secretData.data());
+    const uint64_t chunk = chunkBytes(job);
+    for (uint64_t begin = 0; begin < secretSize; begin += chunk) {
+        if (isCancelled(options)) {
+            return finish(result, false, "Cancelled: Decoding stopped before completion. No output was written.", total);
+        }
+        uint64_t count = std::min<uint64_t>(chunk, secretSize - begin);
+        if (!reader.read(data + begin, count, k)) {
+            return finish(result, false, "Error: Decoded size is invalid or larger than image capacity.", total);
+        }
+        if (fields.chunkCrcs && crc32c(data + begin, count) != loadLe32(table.data() + 4 * (begin / chunk))) {
+            return finish(result, false, corruptChunk(begin / chunk, chunkCount(secretSize, job)), total);
+        }
+        report(options, Phase::Extracting, begin + count, secretSize);
+    }
+    result.timings.processMs = phase.lapMs();
+
+    report(options, Phase::Saving, secretSize, secretSize);
+    std::string unwritable = writeSecret(outputPath, secretData, fields, options, result);
+    if (!unwritable.empty()) {
+        return finish(result, false, unwritable, total);
+    }
+    result.timings.saveMs = phase.lapMs();
+
+    return finish(result, true, "Success! Decoded data saved to " + outputPath, total);
+}
+
+// --- WAV Carriers ---
+// WAV jobs stream the sample data (see AudioCarrier.h) rather than load a
+// whole carrier. The header takes 1 bit per sample over the first
+// kWavHeaderSamples samples; the chunk CRC table and then the payload follow
+// from the next sample on at the job's depth (Options::layout's bits per
+// channel, here per sample). Each block of samples is seen once, in file
+// order, so only plain LSB replacement without a key fits, and the jobs run
+// on the calling thread with just the payload and one block in memory.
+
+const uint64_t kWavHeaderSamples = kHeaderBytes * 8;
+
+static std::string validateWav(const Options& options) {
+    if (options.mode != EmbedMode::Replace) {
+        return "Error: WAV carriers support plain LSB embedding only.";
+    }
+    if (options.traversal == TraversalMode::Keyed) {
+        return "Error: WAV carriers are streamed in order and cannot be scattered with a key.";
+    }
+    return "";
+}
+
+// Stream bytes [begin, end) of a stream of `bytes` written at `depth` bits
+// per sample from sample `origin` on that lie wholly within samples
+// [first, first + count). Blocks and origins fall on multiples of 8 samples,
+// so only the end of the file can cut a stream byte short.
+static void wavOverlap(uint64_t origin, unsigned depth, uint64_t bytes, uint64_t first, uint64_t count,
+                       uint64_t& begin, uint64_t& end) {
+    begin = std::min(bytes, first > origin ? (first - origin) * depth / 8 : 0);
+    end = first + count > origin ? std::min(bytes, (first + count - origin) * depth / 8) : 0;
+    end = std::max(begin, end);
+}
+
+static JobResult encodeWav(const std::string& carrierPath, const std::string& secretPath,
+                           const std::string& outputPath, const Options& options) {
+    JobResult result;
+    Stopwatch total, phase;
+
+    std::string invalid = validateWav(options);
+    if (!invalid.empty()) {
+        return finish(result, false, invalid, total);
+    }
+    if (!isWavPath(outputPath)) {
+        return finish(result, false, "Error: A WAV carrier must be saved as a .wav file.", total);
+    }
+    std::error_code ec;
+    if (std::filesystem::equivalent(carrierPath, outputPath, ec)) {
+        return finish(result, false, "Error: A WAV carrier is streamed and cannot be saved over itself.", total);
+    }
+
+    report(options, Phase::Loading, 0, 0);
+    WavFormat format;
+    std::string unreadable = readWavFormat(carrierPath, format);
+    if (!unreadable.empty()) {
+        return finish(result, false, unreadable, total);
+    }
+    std::vector<char> secretData;
+    PayloadHeader fields = headerFor(options);
+    fields.layout.channels = ChannelLayout::RGB; // Samples have no alpha
+    unreadable = readSecret(secretPath, options, secretData, fields, result);
+    if (!unreadable.empty()) {
+        return finish(result, false, unreadable, total);
+    }
+    const uint64_t secretSize = secretData.size();
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(secretData.data());
+    std::vector<uint8_t> table = chunkTable(fields, data, options);
+    result.timings.loadMs = phase.lapMs();
+
+    const unsigned depth = options.layout.bitsPerChannel;
+    const unsigned width = format.sampleBytes;
+    const uint64_t streamBytes = table.size() + secretSize;
+    const uint64_t samples = format.sampleCount();
+    if (samples < kWavHeaderSamples || (samples - kWavHeaderSamples) * depth / 8 < streamBytes) {
+        return finish(result, false, "Error: Carrier audio is too short to hold the secret data.", total);
+    }
+    uint8_t header[kHeaderBytes];
+    packHeader(fields, header);
+
+    // Every block is copied out, changed or not; the header and stream
+    // bytes a block holds are written into it on the way
+    report(options, Phase::Embedding, 0, secretSize);
+    std::string failed = rewriteWav(carrierPath, outputPath, [&](uint8_t* block, uint64_t first, uint64_t count) {
+        if (isCancelled(options)) return false;
+        uint64_t begin, end;
+        wavOverlap(0, 1, kHeaderBytes, first, count, begin, end);
+        if (begin < end) {
+            embedSamplesFast(block + (begin * 8 - first) * width, width, 1, 0, header + begin, end - begin);
+        }
+        wavOverlap(kWavHeaderSamples, depth, streamBytes, first, count, begin, end);
+        for (uint64_t at = begin; at < end;) {
+            const bool inTable = at < table.size();
+            const uint64_t stop = inTable ? std::min<uint64_t>(end, table.size()) : end;
+            const uint8_t* source = inTable ? table.data() + at : data + (at - table.size());
+            uint8_t* target = block + (kWavHeaderSamples + at * 8 / depth - first) * width;
+            embedSamplesFast(target, width, depth, 0, source, stop - at);
+            at = stop;
+        }
+        report(options, Phase::Embedding, end > table.size() ? end - table.size() : 0, secretSize);
+        return true;
+    });
+    if (failed == "stopped") {
+        return finish(result, false, "Cancelled: Encoding stopped before completion. No output was written.", total);
+    }
+    if (!failed.empty()) {
+        return finish(result, false, failed, total);
+    }
+    result.bytesRead += fileSize(carrierPath);
+    result.bytesWritten = fileSize(outputPath);
+    result.pixelsTouched = kWavHeaderSamples + streamBytes * 8 / depth; // Samples
+    result.timings.processMs = phase.lapMs();
+
+    report(options, Phase::Saving, secretSize, secretSize);
+    return finish(result, true, "Success! Data encoded and saved to " + outputPath, total);
+}
+
+// Reads the header samples of a WAV file, setting `found` when they hold a
+// version 2 header. Returns "" or an error message.
+static std::string readWavHeader(const std::string& path, const WavFormat& format, uint8_t* header, bool& found) {
+    found = false;
+    return scanWav(path, kWavHeaderSamples, [&](uint8_t* block, uint64_t first, uint64_t count) {
+        if (first == 0 && count >= kWavHeaderSamples) {
+            extractSamplesFast(block, format.sampleBytes, 1, 0, header, kHeaderBytes);
+            found = isVersioned(header);
+        }
+        return false;
+    });
+}
+
+static JobResult decodeWav(const std::string& stegoPath, const std::string& outputPath, const Options& options) {
+    JobResult result;
+    Stopwatch total, phase;
+
+    report(options, Phase::Loading, 0, 0);
+    WavFormat format;
+    std::string unreadable = readWavFormat(stegoPath, format);
+    uint8_t header[kHeaderBytes];
+    bool found = false;
+    if (unreadable.empty()) unreadable = readWavHeader(stegoPath, format, header, found);
+    if (!unreadable.empty()) {
+        return finish(result, false, unreadable, total);
+    }
+    if (!found) {
+        return finish(result, false, "Error: The audio holds no hidden data.", total);
+    }
+    PayloadHeader fields;
+    Options job = options;
+    std::string invalid = unpackHeader(header, fields);
+    if (invalid.empty() && fields.sharded) invalid = kShardedImage;
+    if (invalid.empty() && fields.container) invalid = kContainerImage;
+    if (invalid.empty()) invalid = streamOptions(fields, options, job);
+    if (invalid.empty()) invalid = validateWav(job);
+    if (!invalid.empty()) {
+        return finish(result, false, invalid, total);
+    }
+
+    const unsigned depth = job.layout.bitsPerChannel;
+    const unsigned width = format.sampleBytes;
+    const uint64_t secretSize = fields.bytes;
+    const uint64_t samples = format.sampleCount();
+    if (secretSize > (samples - kWavHeaderSamples) * depth / 8) {
+        return finish(result, false, "Error: Decoded size is invalid or larger than audio capacity.", total);
+    }
+    const uint64_t tableBytes = fields.chunkCrcs ? 4 * chunkCount(secretSize, job) : 0;
+    const uint64_t streamBytes = tableBytes + secretSize;
+    if (streamBytes > (samples - kWavHeaderSamples) * depth / 8) {
+        return finish(result, false, "Error: Decoded size is invalid or larger than audio capacity.", total);
+    }
+    if (secretSize == 0) {
+        return finish(result, false, "Warning: Decoded size is 0. Nothing to extract.", total);
+    }
+    result.timings.loadMs = phase.lapMs();
+
+    // Only the samples up to the end of the stream are read
+    std::vector<uint8_t> table(tableBytes);
+    std::vector<char> secretData(secretSize);
+    uint8_t* data = reinterpret_cast<uint8_t*>(secretData.data());
+    const uint64_t samplesUsed = kWavHeaderSamples + streamBytes * 8 / depth;
+    bool cancelled = false;
+    report(options, Phase::Extracting, 0, secretSize);
+    std::string failed = scanWav(stegoPath, samplesUsed, [&](uint8_t* block, uint64_t first, uint64_t count) {
+        if (isCancelled(options)) {
+            cancelled = true;
+            return false;
+        }
+        uint64_t begin, end;
+        wavOverlap(kWavHeaderSamples, depth, streamBytes, first, count, begin, end);
+        for (uint64_t at = begin; at < end;) {
+            const bool inTable = at < tableBytes;
+            const uint64_t stop = inTable ? std::min<uint64_t>(end, tableBytes) : end;
+            uint8_t* target = inTable ? table.data() + at : data + (at - tableBytes);
+            const uint8_t* source = block + (kWavHeaderSamples + at * 8 / depth - first) * width;
+            extractSamplesFast(source, width, depth, 0, target, stop - at);
+            at = stop;
+        }
+        report(options, Phase::Extracting, end > tableBytes ? end - tableBytes : 0, secretSize);
+        return true;
+    });
+    if (cancelled) {
+        return finish(result, false, "Cancelled: Decoding stopped before completion. No output was written.", total);
+    }
+    if (!failed.empty()) {
+        return finish(result, false, failed, total);
+    }
+    const uint64_t chunk = chunkBytes(job);
+    for (uint64_t begin = 0; fields.chunkCrcs && begin < secretSize; begin += chunk) {
+        const uint64_t count = std::min<uint64_t>(chunk, secretSize - begin);
+        if (crc32c(data + begin, count) != loadLe32(table.data() + 4 * (begin / chunk))) {
+            return finish(result, false, corruptChunk(begin / chunk, chunkCount(secretSize, job)), total);
+        }
+    }
+    result.bytesRead = format.dataOffset + samplesUsed * width;
+    result.pixelsTouched = samplesUsed; // Samples
+    result.timings.processMs = phase.lapMs();
+
+    report(options, Phase::Saving, secretSize, secretSize);
+    std::string unwritable = writeSecret(outputPath, secretData, fields, options, result);
+    if (!unwritable.empty()) {
+        return finish(result, false, unwritable, total);
+    }
+    result.timings.saveMs = phase.lapMs();
+
+    return finish(result, true, "Success! Decoded data saved to " + outputPath, total);
+}
+
+// Helper to escape a string for a JSON string literal
+static std::string jsonEscape(const std::string& text) {
+    std::string escaped;
+    for (char c : text) {
+        switch (c) {
+            case '"': escaped += "\\\""; break;
+            case '\\': escaped += "\\\\"; break;
+            case '\n': escaped += "\\n"; break;
+            default:
+                if ((unsigned char)c < 0x20) {
+                    char buf[8];
+                    snprintf(buf, sizeof(buf), "\\u%04x", c);
+                    escaped += buf;
+                } else {
+                    escaped += c;
+                }
+        }
+    }
+    return escaped;
+}
+
+std::string toJson(const JobResult& result) {
+    char numbers[384];
+    snprintf(numbers, sizeof(numbers),
+             "\"timings_ms\":{\"load\":%.3f,\"process\":%.3f,\"cost_map\":%.3f,\"codec\":%.3f,\"crypto\":%.3f,"
+             "\"parity\":%.3f,\"save\":%.3f,\"total\":%.3f},\"bytes_read\":%llu,\"bytes_written\":%llu,"
+             "\"pixels_touched\":%llu",
+             result.timings.loadMs, result.timings.processMs, result.timings.costMapMs, result.timings.codecMs,
+             result.timings.cryptoMs, result.timings.parityMs, result.timings.saveMs, result.timings.totalMs,
+             (unsigned long long)result.bytesRead, (unsigned long long)result.bytesWritten,
+             (unsigned long long)result.pixelsTouched);
+
+    return std::string("{\"ok\":") + (result.ok ? "true" : "false") +
+           ",\"message\":\"" + jsonEscape(result.message) + "\"," + numbers + "}";
+}
+
+std::string summarize(const JobResult& result) {
+    char buf[256];
+    snprintf(buf, sizeof(buf), "load %.1f ms | process %.1f ms | save %.1f ms | total %.1f ms | read %llu B | wrote %llu B | %llu px",
+             result.timings.loadMs, result.timings.processMs, result.timings.saveMs, result.timings.totalMs,
+             (unsigned long long)result.bytesRead, (unsigned long long)result.bytesWritten,
+             (unsigned long long)result.pixelsTouched);
+    std::string summary = buf;
+    if (result.timings.costMapMs > 0) {
+        snprintf(buf, sizeof(buf), " | cost map %.1f ms", result.timings.costMapMs);
+        summary += buf;
+    }
+    if (result.timings.codecMs > 0) {
+        snprintf(buf, sizeof(buf), " | codec %.1f ms", result.timings.codecMs);
+        summary += buf;
+    }
+    if (result.timings.cryptoMs > 0) {
+        snprintf(buf, sizeof(buf), " | crypto %.1f ms", result.timings.cryptoMs);
+        summary += buf;
+    }
+    if (result.timings.parityMs > 0) {
+        snprintf(buf, sizeof(buf), " | parity %.1f ms", result.timings.parityMs);
+        summary += buf;
+    }
+    return summary;
+}
+
+// --- Lossless Carriers ---
+// embedStream and extractStream move one stream between a pixel buffer and
+// memory; encode/decode wrap them with a single image, and the shard jobs
+// below with one image per shard.
+
+// Writes a stream into `image`: the header, any shard record and chunk CRC
+// table, then the fields.bytes payload bytes at `data`. Returns "" or an
+// error or cancellation message.
+static std::string embedStream(sf::Image& image, const PayloadHeader& fields, const uint8_t* data,
+                               const Options& options, JobResult& result) {
+    // Check if the image has enough capacity
+    sf::Vector2u imageSize = image.getSize();
+    const uint64_t secretSize = fields.bytes;
+    uint64_t capacity = capacityBits((uint64_t)imageSize.x * imageSize.y, options.layout);
+    const uint64_t prefixSize = prefixBytes(fields, options);
+    uint64_t requiredBits = prefixSize * 8 + payloadBits(secretSize, options);
+
+    if (capacity < requiredBits) {
+        return "Error: Carrier image is too small to hold the secret data.";
+    }
+
+    // --- Embed Data ---
+    // The kernels write straight into a copy of the pixel buffer, which is
+    // handed back to the image once the whole payload is in place.
+    const sf::Uint8* source = image.getPixelsPtr();
+    std::vector<uint8_t> pixels(source, source + (size_t)imageSize.x * imageSize.y * 4);
+    ChannelPermutation permutation = permutationFor(options, imageSize, headerChannels(fields, options));
+    ChannelOrder order(options.layout.channels, options.traversal == TraversalMode::Keyed ? &permutation : nullptr);
+
+    // 1. Adaptive costs come from the untouched cover, before the header or
+    // any payload bit lands, so every chunk sees the same map
+    report(options, Phase::Embedding, 0, secretSize);
+    std::vector<float> costs;
+    if (options.costFilter != CostFilter::None) {
+        Stopwatch costMap;
+        costs = computeCostMap(pixels.data(), imageSize.x, imageSize.y, options.costFilter, options.threads);
+        result.timings.costMapMs = costMap.elapsedMs();
+    }
+
+    // 2. Embed the header, shard record and chunk CRC table
+    uint8_t header[kHeaderBytes];
+    packHeader(fields, header);
+    embedPlain(pixels.data(), kHeaderLayout, ChannelOrder(kHeaderLayout.channels), options, 0, header, kHeaderBytes);
+    if (fields.sharded) {
+        uint8_t record[kShardRecordBytes];
+        packShardRecord(fields, record);
+        embedPlain(pixels.data(), options.layout, order, options, headerStreamBytes(fields, options), record,
+                   kShardRecordBytes);
+    }
+    std::vector<uint8_t> table = chunkTable(fields, data, options);
+    embedPlain(pixels.data(), options.layout, order, options, recordsEnd(fields, options), table.data(),
+               table.size());
+
+    // 3. Embed the secret data itself, chunks spread over the worker threads
+    std::atomic<uint64_t> bytesDone{0};
+    bool completed = parallelFor(secretSize, chunkBytes(options), options.threads, [&](uint64_t begin, uint64_t end) {
+        if (isCancelled(options)) return false;
+        embedPayload(pixels.data(), options, order, costs.empty() ? nullptr : costs.data(), prefixSize, begin, data + begin, end - begin);
+        bytesDone += end - begin;
+        return true;
+    }, [&]() { report(options, Phase::Embedding, bytesDone, secretSize); });
+
+    if (!completed || isCancelled(options)) {
+        return "Cancelled: Encoding stopped before completion. No output was written.";
+    }
+    report(options, Phase::Embedding, secretSize, secretSize);
+    image.create(imageSize.x, imageSize.y, pixels.data());
+    result.pixelsTouched += pixelsUsed(prefixSize, secretSize, options);
+    return "";
+}
+
+// Reads the header from the stego pixels: a version 2 header from the
+// header pixels, else a bare size word from the start of the payload stream
+// as the caller's options lay it out. Returns "" or an error message.
+static std::string readHeader(const uint8_t* pixels, const sf::Vector2u& imageSize, const Options& options,
+                              PayloadHeader& fields) {
+    uint8_t header[kHeaderBytes];
+    const uint64_t pixelCount = (uint64_t)imageSize.x * imageSize.y;
+    if (pixelCount >= kHeaderPixels) {
+        extractOrdered(pixels, kHeaderLayout, ChannelOrder(kHeaderLayout.channels), 0, header, kHeaderBytes);
+        if (isVersioned(header)) {
+            return unpackHeader(header, fields);
+        }
+    }
+
+    uint64_t capacity = capacityBits(pixelCount, options.layout);
+    if (capacity < kLegacyHeaderBytes * 8) {
+        return "Error: Image is too small to contain any hidden data.";
+    }
+    ChannelPermutation permutation = permutationFor(options, imageSize, 0);
+    ChannelOrder order(options.layout.channels, options.traversal == TraversalMode::Keyed ? &permutation : nullptr);
+    extractOrdered(pixels, options.layout, order, 0, header, kLegacyHeaderBytes);
+    unpackLegacyHeader(header, fields);
+    return "";
+}
+
+// A stream's stored payload, opened for reading: the header, any shard
+// record and the chunk CRC table are read when it is opened, payload bytes
+// only as they are asked for.
+class StoredPayload {
+public:
+    // Reads the header and what follows it from `pixels`. Shards are only
+    // accepted when `gathering`. Returns "" or an error message.
+    std::string open(const uint8_t* pixels, const sf::Vector2u& imageSize, const Options& options, bool gathering);
+
+    const PayloadHeader& header() const { return fields; }
+    const Options& options() const { return job; }
+    const ChannelOrder& channelOrder() const { return *order; }
+    const std::vector<uint8_t>& crcTable() const { return table; }
+
+    // Reads stored bytes [begin, end) into `out`. Plain and matched streams
+    // without CRCs are read byte for byte; otherwise whole chunks are read,
+    // checked against the table and cut down to the range. Safe to call
+    // from several threads. Returns "" or an error message.
+    std::string read(uint64_t begin, uint64_t end, uint8_t* out) const;
+
+    // Pixels read so far: the header pixels plus those the reads covered
+    uint64_t pixelsTouched() const;
+
+    // Whether the stream runs through the image in order, so that any range
+    // of it lies in one run of pixels
+    bool sequential() const { return job.traversal != TraversalMode::Keyed; }
+
+    // Pixels [firstPixel, endPixel) that read(begin, end) covers in a
+    // sequential stream; firstPixel is a multiple of 8
+    void pixelSpan(uint64_t begin, uint64_t end, uint64_t& firstPixel, uint64_t& endPixel) const;
+
+    // Points later reads at `windowPixels`, which hold the image from pixel
+    // `firstPixel` (from pixelSpan) on. Sequential streams only; not safe
+    // while reads are running.
+    void setWindow(const uint8_t* windowPixels, uint64_t firstPixel);
+
+private:
+    bool byteExact() const {
+        return !fields.chunkCrcs && (job.mode == EmbedMode::Replace || job.mode == EmbedMode::Matching);
+    }
+
+    const uint8_t* pixels = nullptr;
+    uint64_t skipped = 0; // Stream bytes ahead of `pixels`
+    Options job;
+    PayloadHeader fields;
+    std::unique_ptr<ChannelPermutation> permutation;
+    std::unique_ptr<ChannelOrder> order;
+    uint64_t prefixSize = 0;
+    uint64_t headerPixels = 0;
+    std::vector<uint8_t> table;
+    mutable std::atomic<uint64_t> bitsRead{0};
+};
+
+std::string StoredPayload::open(const uint8_t* imagePixels, const sf::Vector2u& imageSize, const Options& options,
+                                bool gathering) {
+    // 1. Read and check the header, which says how the rest was written
+    pixels = imagePixels;
+    std::string invalid = readHeader(pixels, imageSize, options, fields);
+    headerPixels = std::min<uint64_t>(kHeaderPixels, (uint64_t)imageSize.x * imageSize.y);
+    if (invalid.empty() && fields.sharded != gathering) {
+        invalid = gathering ? "Error: The image is not part of a sharded set." : kShardedImage;
+    }
+    if (invalid.empty()) invalid = streamOptions(fields, options, job);
+    if (!invalid.empty()) {
+        return invalid;
+    }
+
+    // Sanity check
+    uint64_t capacity = capacityBits((uint64_t)imageSize.x * imageSize.y, job.layout);
+    prefixSize = prefixBytes(fields, job);
+    if (fields.bytes > capacity / 8 || prefixSize * 8 + payloadBits(fields.bytes, job) > capacity) {
+        return "Error: Decoded size is invalid or larger than image capacity.";
+    }
+    permutation.reset(new ChannelPermutation(permutationFor(job, imageSize, headerChannels(fields, job))));
+    order.reset(new ChannelOrder(job.layout.channels, job.traversal == TraversalMode::Keyed ? permutation.get() : nullptr));
+
+    // 2. The shard record and chunk CRC table, written like the header
+    if (fields.sharded) {
+        uint8_t record[kShardRecordBytes];
+        extractOrdered(pixels, job.layout, *order, headerStreamBytes(fields, job), record, kShardRecordBytes);
+        invalid = unpackShardRecord(record, fields);
+        if (!invalid.empty()) {
+            return invalid;
+        }
+    }
+    const uint64_t tableOffset = recordsEnd(fields, job);
+    table.resize(prefixSize - tableOffset);
+    extractOrdered(pixels, job.layout, *order, tableOffset, table.data(), table.size());
+    return "";
+}
+
+std::string StoredPayload::read(uint64_t begin, uint64_t end, uint8_t* out) const {
+    if (byteExact()) {
+        extractPayload(pixels, job, *order, prefixSize, begin, out, end - begin, skipped);
+        bitsRead += (end - begin) * 8;
+        return "";
+    }
+    const uint64_t chunk = chunkBytes(job);
+    std::vector<uint8_t> partial;
+    for (uint64_t first = begin / chunk * chunk; first < end; first += chunk) {
+        const uint64_t last = std::min(first + chunk, fields.bytes);
+        const bool whole = first >= begin && last <= end;
+        if (!whole) partial.resize(last - first);
+        uint8_t* data = whole ? out + (first - begin) : partial.data();
+        extractPayload(pixels, job, *order, prefixSize, first, data, last - first, skipped);
+        bitsRead += payloadBits(last - first, job);
+        if (fields.chunkCrcs && crc32c(data, last - first) != loadLe32(table.data() + 4 * (first / chunk))) {
+            return corruptChunk(first / chunk, chunkCount(fields.bytes, job));
+        }
+        if (!whole) {
+            const uint64_t from = std::max(first, begin), to = std::min(last, end);
+            std::memcpy(out + (from - begin), data + (from - first), to - from);
+        }
+    }
+    return "";
+}
+
+void StoredPayload::pixelSpan(uint64_t begin, uint64_t end, uint64_t& firstPixel, uint64_t& endPixel) const {
+    if (!byteExact()) {
+        const uint64_t chunk = chunkBytes(job);
+        begin = begin / chunk * chunk;
+        end = std::min((end + chunk - 1) / chunk * chunk, fields.bytes);
+    }
+    const uint64_t bits = job.layout.bitsPerChannel;
+    const uint64_t perPixel = channelsPerPixel(job.layout.channels);
+    const uint64_t firstChannel = (prefixSize * 8 + payloadBits(begin, job)) / bits;
+    const uint64_t endChannel = (prefixSize * 8 + payloadBits(end, job) + bits - 1) / bits;
+    firstPixel = firstChannel / perPixel / 8 * 8;
+    endPixel = (endChannel + perPixel - 1) / perPixel;
+}
+
+void StoredPayload::setWindow(const uint8_t* windowPixels, uint64_t firstPixel) {
+    pixels = windowPixels;
+    skipped = firstPixel * channelsPerPixel(job.layout.channels) * job.layout.bitsPerChannel / 8;
+}
+
+uint64_t StoredPayload::pixelsTouched() const {
+    const uint64_t bitsPerPixel = channelsPerPixel(job.layout.channels) * job.layout.bitsPerChannel;
+    return headerPixels + (bitsRead + bitsPerPixel - 1) / bitsPerPixel;
+}
+
+// Reads the stream in `image` into `payload`, filling `fields` from its
+// header and any shard record. Shards are only accepted when `gathering`.
+// Returns "" or an error, warning or cancellation message.
+static std::string extractStream(const sf::Image& image, const Options& options, bool gathering,
+                                 PayloadHeader& fields, std::vector<char>& payload, JobResult& result) {
+    StoredPayload stored;
+    std::string invalid = stored.open(image.getPixelsPtr(), image.getSize(), options, gathering);
+    fields = stored.header();
+    if (!invalid.empty()) {
+        result.pixelsTouched += stored.pixelsTouched();
+        return invalid;
+    }
+    if (fields.container) {
+        result.pixelsTouched += stored.pixelsTouched();
+        return kContainerImage;
+    }
+    const uint64_t secretSize = fields.bytes;
+    if (secretSize == 0) {
+        // An empty shard is part of a valid set
+        result.pixelsTouched += stored.pixelsTouched();
+        return fields.sharded ? "" : "Warning: Decoded size is 0. Nothing to extract.";
+    }
+
+    // 3. Extract the secret data, chunks spread over the worker threads. With
+    // a CRC table each chunk is checked while it is still in cache.
+    payload.resize(secretSize);
+    report(options, Phase::Extracting, 0, secretSize);
+    std::atomic<uint64_t> bytesDone{0};
+    std::string corrupt;
+    std::mutex corruptLock;
+    bool completed = parallelFor(secretSize, chunkBytes(stored.options()), options.threads, [&](uint64_t begin, uint64_t end) {
+        if (isCancelled(options)) return false;
+        std::string failed = stored.read(begin, end, reinterpret_cast<uint8_t*>(payload.data()) + begin);
+        if (!failed.empty()) {
+            std::lock_guard<std::mutex> lock(corruptLock);
+            corrupt = failed;
+            return false;
+        }
+        bytesDone += end - begin;
+        return true;
+    }, [&]() { report(options, Phase::Extracting, bytesDone, secretSize); });
+
+    result.pixelsTouched += stored.pixelsTouched();
+    if (!corrupt.empty()) {
+        return corrupt;
+    }
+    if (!completed || isCancelled(options)) {
+        return "Cancelled: Decoding stopped before completion. No output was written.";
+    }
+    report(options, Phase::Extracting, secretSize, secretSize);
+    return "";
+}
+
+JobResult encode(const std::string& carrierPath, const std::string& secretPath, const std::string& outputPath, const Options& options) {
+    JobResult result;
+    Stopwatch total, phase;
+
+    std::string invalid = validate(options);
+    if (!invalid.empty()) {
+        return finish(result, false, invalid, total);
+    }
+    if (isJpegPath(carrierPath)) {
+        return encodeJpeg(carrierPath, secretPath, outputPath, options);
+    }
+    if (isWavPath(carrierPath)) {
+        return encodeWav(carrierPath, secretPath, outputPath, options);
+    }
+
+    report(options, Phase::Loading, 0, 0);
+    sf::Image carrierImage;
+    if (!loadCarrier(carrierPath, options, carrierImage, result)) {
+        return finish(result, false, "Error: Could not load carrier image.", total);
+    }
+
+    // Read the secret file (compressed if asked) into a vector
+    std::vector<char> secretData;
+    PayloadHeader fields = headerFor(options);
+    std::string unreadable = readSecret(secretPath, options, secretData, fields, result);
+    if (!unreadable.empty()) {
+        return finish(result, false, unreadable, total);
+    }
+    uint64_t secretSize = secretData.size();
+    result.timings.loadMs = phase.lapMs();
+
+    std::string failed =
+        embedStream(carrierImage, fields, reinterpret_cast<const uint8_t*>(secretData.data()), options, result);
+    if (!failed.empty()) {
+        return finish(result, false, failed, total);
+    }
+    result.timings.processMs = phase.lapMs();
+
+    report(options, Phase::Saving, secretSize, secretSize);
+    if (!carrierImage.saveToFile(outputPath)) {
+        return finish(result, false, "Error: Failed to save the output image. Ensure it's a .png file.", total);
+    }
+    result.bytesWritten = fileSize(outputPath);
+    result.timings.saveMs = phase.lapMs();
+
+    return finish(result, true, "Success! Data encoded and saved to " + outputPath, total);
+}
+
+JobResult decode(const std::string& stegoPath, const std::string& outputPath, const Options& options) {
+    JobResult result;
+    Stopwatch total, phase;
+
+    std::string invalid = validate(options);
+    if (!invalid.empty()) {
+        return finish(result, false, invalid, total);
+    }
+    if (isJpegPath(stegoPath)) {
+        return decodeJpeg(stegoPath, outputPath, options);
+    }
+    if (isWavPath(stegoPath)) {
+        return decodeWav(stegoPath, outputPath, options);
+    }
+
+    report(options, Phase::Loading, 0, 0);
+    sf::Image stegoImage;
+    if (!stegoImage.loadFromFile(stegoPath)) {
+        return finish(result, false, "Error: Could not load the steganographic image.", total);
+    }
+    result.bytesRead = fileSize(stegoPath);
+    result.timings.loadMs = phase.lapMs();
+
+    PayloadHeader fields;
+    std::vector<char> secretData;
+    std::string failed = extractStream(stegoImage, options, false, fields, secretData, result);
+    if (!failed.empty()) {
+        return finish(result, false, failed, total);
+    }
+    result.timings.processMs = phase.lapMs();
+
+    report(options, Phase::Saving, fields.bytes, fields.bytes);
+    std::string unwritable = writeSecret(outputPath, secretData, fields, options, result);
+    if (!unwritable.empty()) {
+        return finish(result, false, unwritable, total);
+    }
+    result.timings.saveMs = phase.lapMs();
+
+    return finish(result, true, "Success! Decoded data saved to " + outputPath, total);
+}
+
+// --- Sharded Sets ---
+// A payload too big for one carrier is split over several. Each image holds
+// one slice as a complete stream of its own, tagged with a shard record, so
+// the images are loaded, embedded and saved (or loaded and extracted)
+// concurrently. Compression and sealing apply to the whole payload before it
+// is split. Sets use lossless carriers only: F5 shrinkage means a JPEG's
+// capacity is only known once the walk gets there.
+
+// Pixel count of an image, from its file header where possible
+static bool pixelCountOf(const std::string& path, uint64_t& pixelCount) {
+    ImageInfo info;
+    sf::Image image;
+    if (readImageInfo(path, info)) {
+        pixelCount = (uint64_t)info.width * info.height;
+    } else if (image.loadFromFile(path)) {
+        pixelCount = (uint64_t)image.getSize().x * image.getSize().y;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Largest payload a carrier of `pixelCount` pixels holds under these header
+// fields; stream bits only grow with the payload size, so this is a binary
+// search
+static uint64_t payloadCapacity(uint64_t pixelCount, PayloadHeader fields, const Options& options) {
+    const uint64_t capacity = capacityBits(pixelCount, options.layout);
+    auto fits = [&](uint64_t bytes) {
+        fields.bytes = bytes;
+        return prefixBytes(fields, options) * 8 + payloadBits(bytes, options) <= capacity;
+    };
+    if (!fits(0)) return 0;
+    uint64_t low = 0, high = capacity / 8 + 1; // fits(low), !fits(high)
+    while (high - low > 1) {
+        uint64_t middle = low + (high - low) / 2;
+        (fits(middle) ? low : high) = middle;
+    }
+    return low;
+}
+
+// Options for one shard of a set: workers shared out between the shards,
+// progress reported for the set as a whole
+static Options shardOptions(const Options& options, uint64_t shards) {
+    Options shard = options;
+    shard.onProgress = nullptr;
+    shard.threads = (unsigned)std::max<uint64_t>(1, workerCount(options.threads) / shards);
+    return shard;
+}
+
+// Prefixes the message of a failed shard with its image
+static std::string inImage(const std::string& message, const std::string& path) {
+    size_t colon = message.find(": ");
+    return colon == std::string::npos ? message : message.substr(0, colon + 2) + path + ": " + message.substr(colon + 2);
+}
+
+JobResult encodeShards(const std::vector<std::string>& carrierPaths, const std::string& secretPath,
+                       const std::vector<std::string>& outputPaths, const Options& options) {
+    JobResult result;
+    Stopwatch total, phase;
+
+    std::string invalid = validate(options);
+    if (!invalid.empty()) {
+        return finish(result, false, invalid, total);
+    }
+    const uint64_t shards = carrierPaths.size();
+    if (shards == 0 || outputPaths.size() != shards) {
+        return finish(result, false, "Error: Each carrier needs one output path.", total);
+    }
+    if (shards > 0xFFFF) {
+        return finish(result, false, "Error: A sharded set holds at most 65535 images.", total);
+    }
+    const uint64_t parity = options.parityShards;
+    if (parity > 0 && (parity >= shards || shards > 256)) {
+        return finish(result, false, "Error: Parity needs at least one data carrier and at most 256 carriers in all.",
+                      total);
+    }
+    for (uint64_t i = 0; i < shards; ++i) {
+        if (isJpegPath(carrierPaths[i]) || isJpegPath(outputPaths[i])) {
+            return finish(result, false, "Error: Sharded sets need lossless carriers.", total);
+        }
+    }
+
+    // 1. Size up the carriers from their headers
+    report(options, Phase::Loading, 0, 0);
+    std::vector<uint64_t> pixelCounts(shards);
+    std::atomic<uint64_t> unreadable{UINT64_MAX};
+    parallelFor(shards, 1, options.threads, [&](uint64_t begin, uint64_t end) {
+        for (uint64_t i = begin; i < end; ++i) {
+            if (!pixelCountOf(carrierPaths[i], pixelCounts[i])) {
+                unreadable = i;
+                return false;
+            }
+        }
+        return true;
+    });
+    if (unreadable != UINT64_MAX) {
+        return finish(result, false, inImage("Error: Could not load carrier image.", carrierPaths[unreadable]), total);
+    }
+
+    std::vector<char> secretData;
+    PayloadHeader fields = headerFor(options);
+    fields.sharded = true;
+    fields.shardCount = (uint32_t)shards;
+    fields.dataShards = (uint32_t)(parity > 0 ? shards - parity : 0);
+    std::string failed = readSecret(secretPath, options, secretData, fields, result);
+    if (!failed.empty()) {
+        return finish(result, false, failed, total);
+    }
+    fields.setBytes = secretData.size();
+    std::random_device entropy;
+    fields.setId = ((uint64_t)entropy() << 32) | entropy();
+
+    // 2. Split the payload. A plain split goes in proportion to what each
+    // carrier holds, any rounding remainder to carriers with room left; with
+    // parity every shard is the same size.
+    std::vector<uint64_t> capacities(shards), sizes(shards), offsets(shards);
+    std::vector<const uint8_t*> shardData(shards);
+    uint64_t totalCapacity = 0, smallest = UINT64_MAX;
+    for (uint64_t i = 0; i < shards; ++i) {
+        capacities[i] = payloadCapacity(pixelCounts[i], fields, options);
+        totalCapacity += capacities[i];
+        smallest = std::min(smallest, capacities[i]);
+    }
+    const uint8_t* payload = reinterpret_cast<const uint8_t*>(secretData.data());
+    std::vector<uint8_t> parityData;
+    if (fields.dataShards > 0) {
+        const uint64_t dataShards = fields.dataShards;
+        const uint64_t slice = (fields.setBytes + dataShards - 1) / dataShards;
+        if (slice > smallest) {
+            return finish(result, false, "Error: The carriers are too small to hold the secret data with parity.",
+                          total);
+        }
+        Stopwatch timer;
+        secretData.resize(slice * dataShards);
+        parityData.resize(slice * parity);
+        payload = reinterpret_cast<const uint8_t*>(secretData.data());
+        std::vector<const uint8_t*> data(dataShards);
+        std::vector<uint8_t*> parityShards(parity);
+        for (uint64_t i = 0; i < shards; ++i) {
+            sizes[i] = slice;
+            shardData[i] = i < dataShards ? payload + i * slice : parityData.data() + (i - dataShards) * slice;
+            if (i < dataShards) data[i] = shardData[i];
+            else parityShards[i - dataShards] = parityData.data() + (i - dataShards) * slice;
+        }
+        encodeParity(data.data(), (unsigned)dataShards, parityShards.data(), (unsigned)parity, slice, options.threads);
+        result.timings.parityMs = timer.elapsedMs();
+    } else {
+        if (fields.setBytes > totalCapacity) {
+            return finish(result, false, "Error: The carriers are too small to hold the secret data together.",
+                          total);
+        }
+        uint64_t assigned = 0;
+        for (uint64_t i = 0; i < shards; ++i) {
+            double share = (double)fields.setBytes * capacities[i] / (double)totalCapacity;
+            sizes[i] = std::min<uint64_t>(capacities[i], (uint64_t)share);
+            assigned += sizes[i];
+        }
+        for (uint64_t i = 0; i < shards && assigned < fields.setBytes; ++i) {
+            uint64_t extra = std::min(capacities[i] - sizes[i], fields.setBytes - assigned);
+            sizes[i] += extra;
+            assigned += extra;
+        }
+        for (uint64_t i = 0, offset = 0; i < shards; offset += sizes[i++]) {
+            offsets[i] = offset;
+            shardData[i] = payload + offset;
+        }
+    }
+    result.timings.loadMs = phase.lapMs();
+
+    // 3. Load, embed and save the shards concurrently
+    const Options shard = shardOptions(options, shards);
+    std::vector<JobResult> shardResults(shards);
+    std::vector<std::string> errors(shards);
+    std::atomic<uint64_t> bytesDone{0};
+    uint64_t bytesTotal = 0;
+    for (uint64_t size : sizes) bytesTotal += size;
+    report(options, Phase::Embedding, 0, bytesTotal);
+    bool completed = parallelFor(shards, 1, options.threads, [&](uint64_t begin, uint64_t end) {
+        for (uint64_t i = begin; i < end; ++i) {
+            PayloadHeader shardFields = fields;
+            shardFields.bytes = sizes[i];
+            shardFields.shardIndex = (uint32_t)i;
+            shardFields.shardOffset = offsets[i];
+            sf::Image image;
+            JobResult& shardResult = shardResults[i];
+            if (!loadCarrier(carrierPaths[i], shard, image, shardResult)) {
+                errors[i] = "Error: Could not load carrier image.";
+                return false;
+            }
+            errors[i] = embedStream(image, shardFields, shardData[i], shard, shardResult);
+            if (!errors[i].empty()) return false;
+            if (!image.saveToFile(outputPaths[i])) {
+                errors[i] = "Error: Failed to save the output image. Ensure it's a .png file.";
+                return false;
+            }
+            shardResult.bytesWritten = fileSize(outputPaths[i]);
+            bytesDone += sizes[i];
+        }
+        return true;
+    }, [&]() { report(options, Phase::Embedding, bytesDone, bytesTotal); });
+
+    for (uint64_t i = 0; i < shards; ++i) {
+        result.bytesRead += shardResults[i].bytesRead;
+        result.bytesWritten += shardResults[i].bytesWritten;
+        result.pixelsTouched += shardResults[i].pixelsTouched;
+        if (!errors[i].empty()) {
+            return finish(result, false, inImage(errors[i], carrierPaths[i]), total);
+        }
+    }
+    if (!completed) {
+        return finish(result, false, "Cancelled: Encoding stopped before completion.", total);
+    }
+    report(options, Phase::Embedding, bytesTotal, bytesTotal);
+    result.timings.processMs = phase.lapMs();
+
+    std::string message = "Success! Data split over " + std::to_string(shards) + " images";
+    if (parity > 0) message += ", any " + std::to_string(parity) + " of which may be lost";
+    return finish(result, true, message + ".", total);
+}
+
+JobResult decodeShards(const std::vector<std::string>& stegoPaths, const std::string& outputPath,
+                       const Options& options) {
+    JobResult result;
+    Stopwatch total, phase;
+
+    std::string invalid = validate(options);
+    if (!invalid.empty()) {
+        return finish(result, false, invalid, total);
+    }
+    const uint64_t images = stegoPaths.size();
+    if (images == 0) {
+        return finish(result, false, "Error: No shard images were given.", total);
+    }
+
+    // 1. Load and extract the shards concurrently. An image that fails is
+    // only fatal if the set has no parity to make up for it, which is not
+    // known until the rest are in.
+    const Options shard = shardOptions(options, images);
+    std::vector<PayloadHeader> fields(images);
+    std::vector<std::vector<char>> slices(images);
+    std::vector<JobResult> shardResults(images);
+    std::vector<std::string> errors(images);
+    // Each shard records the set's size, so progress has a total once the
+    // first one is in
+    std::atomic<uint64_t> bytesDone{0}, bytesTotal{0};
+    report(options, Phase::Extracting, 0, 0);
+    bool completed = parallelFor(images, 1, options.threads, [&](uint64_t begin, uint64_t end) {
+        for (uint64_t i = begin; i < end; ++i) {
+            if (isCancelled(options)) return false;
+            sf::Image image;
+            if (isJpegPath(stegoPaths[i]) || !image.loadFromFile(stegoPaths[i])) {
+                errors[i] = "Error: Could not load the steganographic image.";
+                continue;
+            }
+            shardResults[i].bytesRead = fileSize(stegoPaths[i]);
+            errors[i] = extractStream(image, shard, true, fields[i], slices[i], shardResults[i]);
+            if (!errors[i].empty()) continue;
+            bytesDone += slices[i].size();
+            bytesTotal = fields[i].dataShards ? fields[i].bytes * images : fields[i].setBytes;
+        }
+        return true;
+    }, [&]() { report(options, Phase::Extracting, bytesDone, bytesTotal); });
+
+    if (!completed || isCancelled(options)) {
+        return finish(result, false, "Cancelled: Decoding stopped before completion. No output was written.", total);
+    }
+    uint64_t first = UINT64_MAX;
+    for (uint64_t i = 0; i < images; ++i) {
+        result.bytesRead += shardResults[i].bytesRead;
+        result.pixelsTouched += shardResults[i].pixelsTouched;
+        if (errors[i].empty() && first == UINT64_MAX) first = i;
+    }
+    result.timings.loadMs = phase.lapMs();
+
+    // 2. Check that the shards come from one set and have the same index at
+    // most once
+    const PayloadHeader& set = fields[first == UINT64_MAX ? 0 : first];
+    const uint64_t shards = set.shardCount;
+    std::vector<uint64_t> byIndex(shards, UINT64_MAX);
+    uint64_t lost = 0;
+    for (uint64_t i = 0; i < images; ++i) {
+        if (!errors[i].empty()) {
+            // Without parity every shard is needed
+            if (first == UINT64_MAX || set.dataShards == 0) {
+                return finish(result, false, inImage(errors[i], stegoPaths[i]), total);
+            }
+            ++lost;
+            continue;
+        }
+        if (fields[i].setId != set.setId || fields[i].setBytes != set.setBytes || fields[i].codec != set.codec ||
+            fields[i].encrypted != set.encrypted || fields[i].shardCount != shards ||
+            fields[i].dataShards != set.dataShards) {
+            return finish(result, false, "Error: The images belong to different shard sets.", total);
+        }
+        if (byIndex[fields[i].shardIndex] != UINT64_MAX) {
+            return finish(result, false, inImage("Error: Shard " + std::to_string(fields[i].shardIndex + 1) +
+                                                     " was given twice.", stegoPaths[i]), total);
+        }
+        byIndex[fields[i].shardIndex] = i;
+    }
+    if (set.dataShards == 0 && images != shards) {
+        return finish(result, false, "Error: The set has " + std::to_string(shards) + " shards but " +
+                                         std::to_string(images) + " images were given.", total);
+    }
+
+    // 3. Join the data shards in index order, rebuilding lost ones from
+    // parity first
+    std::vector<char> secretData;
+    uint64_t rebuilt = 0;
+    if (set.dataShards > 0) {
+        const uint64_t slice = set.bytes;
+        std::vector<uint8_t*> pointers(shards);
+        std::vector<bool> present(shards);
+        std::vector<uint8_t> spare;
+        uint64_t found = 0;
+        secretData.resize(slice * set.dataShards);
+        for (uint64_t index = 0; index < shards; ++index) {
+            present[index] = byIndex[index] != UINT64_MAX;
+            found += present[index];
+        }
+        if (found < set.dataShards) {
+            return finish(result, false, "Error: Only " + std::to_string(found) + " of the " +
+                                             std::to_string(set.dataShards) + " shards needed could be read" +
+                                             (lost > 0 ? " (" + std::to_string(lost) + (lost == 1 ? " image" : " images") + " failed)." : "."),
+                          total);
+        }
+        for (uint64_t index = 0; index < shards; ++index) {
+            if (index < set.dataShards) {
+                pointers[index] = reinterpret_cast<uint8_t*>(secretData.data()) + index * slice;
+                if (present[index]) std::memcpy(pointers[index], slices[byIndex[index]].data(), slice);
+                else ++rebuilt;
+            } else if (present[index]) {
+                pointers[index] = reinterpret_cast<uint8_t*>(slices[byIndex[index]].data());
+            }
+        }
+        Stopwatch timer;
+        rebuildData(pointers.data(), present, set.dataShards, slice, options.threads);
+        result.timings.parityMs = timer.elapsedMs();
+        secretData.resize(set.setBytes);
+    } else {
+        secretData.reserve(set.setBytes);
+        for (uint64_t index = 0; index < shards; ++index) {
+            const uint64_t i = byIndex[index];
+            if (fields[i].shardOffset != secretData.size()) {
+                return finish(result, false, "Error: The shard records do not fit together.", total);
+            }
+            secretData.insert(secretData.end(), slices[i].begin(), slices[i].end());
+            std::vector<char>().swap(slices[i]);
+        }
+        if (secretData.size() != set.setBytes) {
+            return finish(result, false, "Error: The shard records do not fit together.", total);
+        }
+    }
+    if (secretData.empty()) {
+        return finish(result, false, "Warning: Decoded size is 0. Nothing to extract.", total);
+    }
+    result.timings.processMs = phase.lapMs();
+
+    report(options, Phase::Saving, set.setBytes, set.setBytes);
+    PayloadHeader joined = set;
+    joined.bytes = set.setBytes;
+    std::string unwritable = writeSecret(outputPath, secretData, joined, options, result);
+    if (!unwritable.empty()) {
+        return finish(result, false, unwritable, total);
+    }
+    result.timings.saveMs = phase.lapMs();
+
+    std::string message = "Success! Decoded data saved to " + outputPath;
+    if (rebuilt > 0) {
+        message += " (" + std::to_string(rebuilt) + (rebuilt == 1 ? " shard" : " shards") + " rebuilt from parity)";
+    }
+    return finish(result, true, message, total);
+}
+
+// --- Capacity Planning ---
+// Capacity depends only on an image's pixel count and the options, and every
+// lossless format a carrier may come in records its size in the first bytes
+// of the file, so a plan reads a few dozen bytes per carrier instead of
+// decoding it. JPEG capacity depends on the quantized coefficients, so JPEGs
+// are left out.
+
+// The modes a plan reports, each on top of the caller's channels and CRC
+// choice
+static std::vector<std::pair<std::string, Options>> modesFor(const Options& options) {
+    std::vector<std::pair<std::string, Options>> modes;
+    Options mode = options;
+    mode.mode = EmbedMode::Replace;
+    mode.costFilter = CostFilter::None;
+    for (unsigned bits : {1u, 2u, 4u}) {
+        mode.layout.bitsPerChannel = bits;
+        modes.emplace_back("bits" + std::to_string(bits), mode);
+    }
+    mode.layout.bitsPerChannel = 1;
+    mode.mode = EmbedMode::Matching;
+    modes.emplace_back("match", mode);
+    mode.mode = EmbedMode::Hamming;
+    for (unsigned k = kMinHammingK; k <= kMaxHammingK; ++k) {
+        mode.hammingK = k;
+        modes.emplace_back("hamming" + std::to_string(k), mode);
+    }
+    mode.mode = EmbedMode::Stc;
+    for (unsigned width : {2u, 4u, 8u}) {
+        mode.stcWidth = width;
+        modes.emplace_back("stc" + std::to_string(width), mode);
+    }
+    return modes;
+}
+
+std::vector<std::string> planModes() {
+    std::vector<std::string> names;
+    for (const auto& mode : modesFor(Options())) names.push_back(mode.first);
+    return names;
+}
+
+uint64_t capacityFor(uint64_t pixelCount, const Options& options) {
+    return payloadCapacity(pixelCount, headerFor(options), options);
+}
+
+std::vector<uint64_t> planCapacities(uint64_t pixelCount, const Options& options) {
+    std::vector<uint64_t> capacities;
+    for (const auto& mode : modesFor(options)) capacities.push_back(capacityFor(pixelCount, mode.second));
+    return capacities;
+}
+
+JobResult planCarriers(const std::string& directory, std::vector<CarrierCapacity>& plan, const Options& options) {
+    JobResult result;
+    Stopwatch total, phase;
+    plan.clear();
+
+    std::string invalid = validate(options);
+    if (!invalid.empty()) {
+        return finish(result, false, invalid, total);
+    }
+
+    // 1. List the files
+    std::vector<std::string> paths;
+    std::error_code ec;
+    for (std::filesystem::recursive_directory_iterator it(directory, ec), end; !ec && it != end; it.increment(ec)) {
+        std::error_code typeError;
+        if (it->is_regular_file(typeError)) paths.push_back(it->path().string());
+    }
+    if (ec) {
+        return finish(result, false, "Error: Could not read the directory " + directory + ".", total);
+    }
+    result.timings.loadMs = phase.lapMs();
+
+    // 2. Sizes from the file headers and the capacities they give, files
+    // spread over the worker threads
+    std::vector<CarrierCapacity> found(paths.size());
+    std::vector<char> usable(paths.size()), skipped(paths.size());
+    parallelFor(paths.size(), 16, options.threads, [&](uint64_t begin, uint64_t end) {
+        for (uint64_t i = begin; i < end; ++i) {
+            ImageInfo info;
+            if (!readImageInfo(paths[i], info)) continue;
+            if (info.format == ImageFormat::Jpeg) {
+                skipped[i] = 1;
+                continue;
+            }
+            const uint64_t pixelCount = (uint64_t)info.width * info.height;
+            CarrierCapacity& carrier = found[i];
+            carrier.path = paths[i];
+            carrier.width = info.width;
+            carrier.height = info.height;
+            carrier.chosen = capacityFor(pixelCount, options);
+            carrier.byMode = planCapacities(pixelCount, options);
+            usable[i] = 1;
+        }
+        return true;
+    });
+
+    uint64_t jpegs = 0;
+    for (size_t i = 0; i < paths.size(); ++i) {
+        if (usable[i]) plan.push_back(std::move(found[i]));
+        jpegs += skipped[i];
+    }
+    std::sort(plan.begin(), plan.end(), [](const CarrierCapacity& a, const CarrierCapacity& b) {
+        return a.chosen != b.chosen ? a.chosen > b.chosen : a.path < b.path;
+    });
+    result.timings.processMs = phase.lapMs();
+
+    std::string message = "Planned " + std::to_string(plan.size()) + " carriers";
+    if (jpegs > 0) message += " (" + std::to_string(jpegs) + " JPEGs skipped)";
+    if (!plan.empty()) message += "; the largest holds " + std::to_string(plan.front().chosen) + " bytes";
+    return finish(result, true, message, total);
+}
+
+std::string toJson(const CarrierCapacity& carrier) {
+    std::string json = "{\"path\":\"" + jsonEscape(carrier.path) + "\",\"width\":" + std::to_string(carrier.width) +
+                       ",\"height\":" + std::to_string(carrier.height) +
+                       ",\"chosen\":" + std::to_string(carrier.chosen) + ",\"modes\":{";
+    const std::vector<std::string> names = planModes();
+    for (size_t m = 0; m < names.size() && m < carrier.byMode.size(); ++m) {
+        json += (m ? ",\"" : "\"") + names[m] + "\":" + std::to_string(carrier.byMode[m]);
+    }
+    return json + "}}";
+}
+
+// --- Carrier Index ---
+// A refresh walks the pool once, but only files that are new or whose
+// modification time or size changed are read: their headers for the size
+// and their whole contents for the hash. Everything else is carried over
+// from the old index, with capacities recomputed from the recorded size so
+// they always follow planModes().
+
+JobResult refreshIndex(const std::string& indexPath, const std::string& directory, const Options& options) {
+    JobResult result;
+    Stopwatch total, phase;
+
+    std::string invalid = validate(options);
+    if (!invalid.empty()) {
+        return finish(result, false, invalid, total);
+    }
+
+    // 1. List the files with their modification times and sizes; paths are
+    // absolute so lookups do not depend on the working directory
+    struct Listed {
+        std::string path;
+        int64_t modified;
+        uint64_t size;
+    };
+    std::vector<Listed> listed;
+    std::error_code ec;
+    const std::filesystem::path root = std::filesystem::absolute(directory, ec).lexically_normal();
+    for (std::filesystem::recursive_directory_iterator it(root, ec), end; !ec && it != end; it.increment(ec)) {
+        std::error_code statError;
+        if (!it->is_regular_file(statError)) continue;
+        const uint64_t size = it->file_size(statError);
+        const int64_t modified = (int64_t)it->last_write_time(statError).time_since_epoch().count();
+        if (!statError) listed.push_back({it->path().string(), modified, size});
+    }
+    if (ec) {
+        return finish(result, false, "Error: Could not read the directory " + directory + ".", total);
+    }
+
+    // A missing or unreadable old index just means every file is new
+    CarrierIndex old;
+    const bool hadIndex = old.open(indexPath).empty();
+    const uint64_t oldCount = hadIndex ? old.size() : 0;
+    result.timings.loadMs = phase.lapMs();
+
+    // 2. Carry over unchanged records, read the rest; files spread over the
+    // worker threads
+    std::vector<IndexedCarrier> carriers(listed.size());
+    std::vector<char> state(listed.size()); // 0 skipped, 1 unchanged, 2 read
+    std::atomic<uint64_t> bytesHashed{0};
+    parallelFor(listed.size(), 16, options.threads, [&](uint64_t begin, uint64_t end) {
+        for (uint64_t i = begin; i < end; ++i) {
+            IndexedCarrier& carrier = carriers[i];
+            if (hadIndex && old.find(listed[i].path, carrier) && carrier.modified == listed[i].modified &&
+                carrier.fileSize == listed[i].size) {
+                state[i] = 1;
+            } else if (readImageInfo(listed[i].path, carrier.info) && carrier.info.format != ImageFormat::Jpeg &&
+                       hashFile(listed[i].path, carrier.hash)) {
+                carrier.path = listed[i].path;
+                carrier.modified = listed[i].modified;
+                carrier.fileSize = listed[i].size;
+                bytesHashed += listed[i].size;
+                state[i] = 2;
+            } else {
+                continue;
+            }
+            carrier.capacities = planCapacities((uint64_t)carrier.info.width * carrier.info.height);
+        }
+        return true;
+    });
+    result.bytesRead = bytesHashed;
+
+    uint64_t unchanged = 0, read = 0;
+    std::vector<IndexedCarrier> kept;
+    kept.reserve(listed.size());
+    for (size_t i = 0; i < listed.size(); ++i) {
+        if (state[i] == 0) continue;
+        (state[i] == 1 ? unchanged : read) += 1;
+        kept.push_back(std::move(carriers[i]));
+    }
+    result.timings.processMs = phase.lapMs();
+
+    // 3. Replace the index file
+    old.close();
+    const uint64_t indexed = kept.size();
+    std::string failed = writeCarrierIndex(indexPath, std::move(kept));
+    if (!failed.empty()) {
+        return finish(result, false, failed, total);
+    }
+    result.bytesWritten = fileSize(indexPath);
+    result.timings.saveMs = phase.lapMs();
+
+    return finish(result, true,
+                  "Success! Indexed " + std::to_string(indexed) + " carriers: " + std::to_string(read) +
+                      " new or changed, " + std::to_string(unchanged) + " unchanged, " +
+                      std::to_string(oldCount - unchanged) + " dropped or replaced.",
+                  total);
+}
+
+JobResult chooseCarrier(const std::string& indexPath, uint64_t payloadBytes, const Options& options,
+                        std::string& carrierPath) {
+    JobResult result;
+    Stopwatch total, phase;
+    carrierPath.clear();
+
+    std::string invalid = validate(options);
+    if (!invalid.empty()) {
+        return finish(result, false, invalid, total);
+    }
+    CarrierIndex index;
+    std::string failed = index.open(indexPath);
+    if (!failed.empty()) {
+        return finish(result, false, failed, total);
+    }
+    result.timings.loadMs = phase.lapMs();
+
+    // The smallest carrier that holds the payload: capacity only grows with
+    // the pixel count, so each record needs its size and nothing else.
+    // RGBA layouts only use carriers with an alpha channel of their own.
+    const bool needsAlpha = options.layout.channels == ChannelLayout::RGBA;
+    uint64_t best = index.size(), bestPixels = UINT64_MAX;
+    for (uint64_t i = 0; i < index.size(); ++i) {
+        const uint64_t pixels = index.pixelCount(i);
+        if (pixels >= bestPixels || (needsAlpha && !index.hasAlpha(i))) continue;
+        if (capacityFor(pixels, options) >= payloadBytes) {
+            best = i;
+            bestPixels = pixels;
+        }
+    }
+    result.timings.processMs = phase.lapMs();
+    if (best == index.size()) {
+        return finish(result, false,
+                      "Error: No indexed carrier holds " + std::to_string(payloadBytes) + " bytes this way.", total);
+    }
+    const IndexedCarrier carrier = index.at(best);
+    carrierPath = carrier.path;
+    return finish(result, true,
+                  carrier.path + " (" + std::to_string(carrier.info.width) + "x" +
+                      std::to_string(carrier.info.height) + ", holds " +
+                      std::to_string(capacityFor(bestPixels, options)) + " bytes)",
+                  total);
+}
+
+// --- Partial Reads ---
+// Byte ranges of a payload, read without extracting the rest. A range of the
+// stored stream maps to the pixels (and, for whole chunks, the CRCs) that
+// hold it; a sealed payload opens only the segments that cover the range.
+// When the stream runs through a PNG in order, each read decodes only the
+// rows it lies in, so nothing after the range is inflated and only those
+// rows are kept. A keyed stream is scattered over the whole image, which is
+// then loaded whole.
+
+// A payload opened for partial reads
+struct OpenPayload {
+    std::string path;
+    bool streaming = false; // Rows are decoded per read, not the image loaded whole
+    sf::Image image;
+    std::vector<uint8_t> rows; // The rows of the latest read when streaming
+    StoredPayload stored;
+    std::unique_ptr<SealedReader> sealed;
+    uint64_t plainBytes = 0; // Payload size once opened
+};
+
+// Reads stored bytes [begin, end) into `out`, chunk by chunk over the worker
+// threads. Returns "" or an error message.
+static std::string readStored(OpenPayload& payload, uint64_t begin, uint64_t end, std::vector<char>& out,
+                              unsigned threads) {
+    out.resize(end - begin);
+    if (begin >= end) {
+        return "";
+    }
+    const StoredPayload& stored = payload.stored;
+    if (payload.streaming) {
+        uint64_t firstPixel = 0, endPixel = 0;
+        unsigned width = 0, height = 0, firstRow = 0;
+        stored.pixelSpan(begin, end, firstPixel, endPixel);
+        if (!readPixelRows(payload.path, firstPixel, endPixel - firstPixel, payload.rows, width, height, firstRow)) {
+            return "Error: Could not load the steganographic image.";
+        }
+        payload.stored.setWindow(payload.rows.data() + (firstPixel - (uint64_t)firstRow * width) * 4, firstPixel);
+    }
+
+    const uint64_t chunk = chunkBytes(stored.options());
+    const uint64_t first = begin / chunk;
+    std::string failure;
+    std::mutex failureLock;
+    parallelFor((end + chunk - 1) / chunk - first, 1, threads, [&](uint64_t from, uint64_t to) {
+        const uint64_t pieceBegin = std::max(begin, (first + from) * chunk);
+        const uint64_t pieceEnd = std::min(end, (first + to) * chunk);
+        std::string failed =
+            stored.read(pieceBegin, pieceEnd, reinterpret_cast<uint8_t*>(out.data()) + (pieceBegin - begin));
+        if (!failed.empty()) {
+            std::lock_guard<std::mutex> lock(failureLock);
+            failure = failed;
+            return false;
+        }
+        return true;
+    });
+    return failure;
+}
+
+// Plain payload bytes [begin, end), opening only the sealed segments that
+// cover them when the payload is sealed. Returns "" or an error message.
+static std::string readPlain(OpenPayload& payload, uint64_t begin, uint64_t end, std::vector<char>& out,
+                             unsigned threads) {
+    if (!payload.sealed) {
+        return readStored(payload, begin, end, out, threads);
+    }
+    uint64_t sealedBegin = 0, sealedEnd = 0, plainStart = 0;
+    payload.sealed->span(begin, end, sealedBegin, sealedEnd, plainStart);
+    std::vector<char> sealedBytes, plain;
+    std::string failed = readStored(payload, sealedBegin, sealedEnd, sealedBytes, threads);
+    if (failed.empty()) failed = payload.sealed->open(sealedBytes.data(), sealedBegin, sealedEnd, plain, threads);
+    if (!failed.empty()) {
+        return failed;
+    }
+    out.assign(plain.begin() + (begin - plainStart), plain.begin() + (end - plainStart));
+    return "";
+}
+
+// Opens the payload of a lossless stego image: its header, any CRC table and,
+// when sealed, the seal's own header. Returns "" or an error message.
+static std::string openPayload(const std::string& stegoPath, const Options& options, OpenPayload& payload,
+                               JobResult& result) {
+    report(options, Phase::Loading, 0, 0);
+    payload.path = stegoPath;
+    result.bytesRead = fileSize(stegoPath);
+
+    // The header rows first; a version 2 header says whether the stream
+    // runs in order
+    std::vector<uint8_t> leading;
+    unsigned width = 0, height = 0, firstRow = 0;
+    PayloadHeader fields;
+    Options job;
+    if (readPixelRows(stegoPath, 0, kHeaderPixels, leading, width, height, firstRow) &&
+        (uint64_t)width * height >= kHeaderPixels) {
+        uint8_t header[kHeaderBytes];
+        extractOrdered(leading.data(), kHeaderLayout, ChannelOrder(kHeaderLayout.channels), 0, header, kHeaderBytes);
+        payload.streaming = isVersioned(header) && unpackHeader(header, fields).empty() &&
+                            streamOptions(fields, options, job).empty() && job.traversal != TraversalMode::Keyed;
+    }
+
+    std::string failed;
+    if (payload.streaming) {
+        // Then the rows through any shard record and CRC table. A prefix
+        // past the end of the image fails open()'s size check before it is
+        // read.
+        const uint64_t prefixPixels = pixelsUsed(prefixBytes(fields, job), 0, job);
+        if (prefixPixels > kHeaderPixels && prefixPixels <= (uint64_t)width * height &&
+            !readPixelRows(stegoPath, 0, prefixPixels, leading, width, height, firstRow)) {
+            return "Error: Could not load the steganographic image.";
+        }
+        failed = payload.stored.open(leading.data(), sf::Vector2u(width, height), options, false);
+    } else {
+        if (!payload.image.loadFromFile(stegoPath)) {
+            return "Error: Could not load the steganographic image.";
+        }
+        failed = payload.stored.open(payload.image.getPixelsPtr(), payload.image.getSize(), options, false);
+    }
+    if (!failed.empty()) {
+        return failed;
+    }
+
+    payload.plainBytes = payload.stored.header().bytes;
+    if (payload.stored.header().encrypted) {
+        if (options.passphrase.empty()) {
+            return "Error: The hidden data is encrypted; a passphrase is needed.";
+        }
+        std::vector<char> header;
+        failed = readStored(payload, 0, std::min<uint64_t>(kSealHeaderBytes, payload.plainBytes), header,
+                            options.threads);
+        if (!failed.empty()) {
+            return failed;
+        }
+        header.resize(kSealHeaderBytes);
+        Stopwatch timer;
+        payload.sealed.reset(new SealedReader(options.passphrase, header.data(), payload.plainBytes));
+        result.timings.cryptoMs += timer.elapsedMs();
+        if (!payload.sealed->error().empty()) {
+            return payload.sealed->error();
+        }
+        payload.plainBytes = payload.sealed->plainSize();
+    }
+    return "";
+}
+
+JobResult decodeRange(const std::string& stegoPath, uint64_t offset, uint64_t length, const std::string& outputPath,
+                      const Options& options) {
+    JobResult result;
+    Stopwatch total, phase;
+
+    std::string invalid = validate(options);
+    if (!invalid.empty()) {
+        return finish(result, false, invalid, total);
+    }
+    if (isJpegPath(stegoPath)) {
+        return finish(result, false, "Error: Byte ranges need a lossless carrier.", total);
+    }
+    OpenPayload payload;
+    std::string failed = openPayload(stegoPath, options, payload, result);
+    const PayloadHeader& fields = payload.stored.header();
+    if (failed.empty() && fields.container) {
+        failed = kContainerImage;
+    }
+    if (failed.empty() && fields.codec != Compression::None) {
+        failed = "Error: The hidden data is compressed, so it can only be decoded whole.";
+    }
+    if (failed.empty() && offset > payload.plainBytes) {
+        failed = "Error: The range starts past the end of the hidden data (" + std::to_string(payload.plainBytes) +
+                 " bytes).";
+    }
+    if (!failed.empty()) {
+        result.pixelsTouched = payload.stored.pixelsTouched();
+        return finish(result, false, failed, total);
+    }
+    result.timings.loadMs = phase.lapMs();
+
+    // A range running past the end stops there
+    const uint64_t end = offset + std::min(length, payload.plainBytes - offset);
+    std::vector<char> range;
+    report(options, Phase::Extracting, 0, end - offset);
+    failed = readPlain(payload, offset, end, range, options.threads);
+    result.pixelsTouched = payload.stored.pixelsTouched();
+    if (!failed.empty()) {
+        return finish(result, false, failed, total);
+    }
+    report(options, Phase::Extracting, end - offset, end - offset);
+    result.timings.processMs = phase.lapMs();
+
+    report(options, Phase::Saving, end - offset, end - offset);
+    PayloadHeader plain;
+    plain.bytes = range.size();
+    std::string unwritable = writeSecret(outputPath, range, plain, options, result);
+    if (!unwritable.empty()) {
+        return finish(result, false, unwritable, total);
+    }
+    result.timings.saveMs = phase.lapMs();
+
+    return finish(result, true,
+                  "Success! Bytes " + std::to_string(offset) + " to " + std::to_string(end) + " saved to " + outputPath,
+                  total);
+}
+
+// --- Updates ---
+// Appending to or patching a payload rewrites only what changes: the header,
+// for its new length, and the chunks the new bytes fall in, with their CRCs.
+// Bit positions depend only on the stream offset, so the rest of the image
+// is left as it is. Each affected chunk is read back, merged with the new
+// bytes and embedded again whole, which leaves its unchanged bits alone in
+// every mode. When a CRC table has to grow, the payload behind it moves, so
+// the whole stream is embedded again instead. Sealed and compressed payloads
+// cannot be updated: each stored byte depends on those before it.
+//
+// Writing a BMP back over itself rewrites only the rows that changed;
+// anything else is saved whole.
+
+static JobResult updatePayload(const std::string& stegoPath, const std::string& secretPath, bool appending,
+                               uint64_t offset, const std::string& outputPath, const Options& options) {
+    JobResult result;
+    Stopwatch total, phase;
+
+    std::string invalid = validate(options);
+    if (!invalid.empty()) {
+        return finish(result, false, invalid, total);
+    }
+    if (isJpegPath(stegoPath) || isJpegPath(outputPath)) {
+        return finish(result, false, "Error: Only lossless carriers can be updated in place.", total);
+    }
+
+    report(options, Phase::Loading, 0, 0);
+    sf::Image image;
+    if (!image.loadFromFile(stegoPath)) {
+        return finish(result, false, "Error: Could not load the steganographic image.", total);
+    }
+    result.bytesRead = fileSize(stegoPath);
+    const sf::Vector2u imageSize = image.getSize();
+    const uint8_t* original = image.getPixelsPtr();
+    std::vector<uint8_t> pixels(original, original + (size_t)imageSize.x * imageSize.y * 4);
+
+    StoredPayload stored;
+    std::string failed = stored.open(pixels.data(), imageSize, options, false);
+    const PayloadHeader& fields = stored.header();
+    if (failed.empty() && fields.version < kHeaderVersion) {
+        failed = "Error: Only payloads with a version 2 header can be updated in place.";
+    }
+    if (failed.empty() && fields.container) {
+        failed = "Error: Containers cannot be updated in place; pack them again.";
+    }
+    if (failed.empty() && (fields.encrypted || fields.codec != Compression::None)) {
+        failed = "Error: Encrypted or compressed payloads cannot be updated in place; encode them again.";
+    }
+    if (!failed.empty()) {
+        result.pixelsTouched = stored.pixelsTouched();
+        return finish(result, false, failed, total);
+    }
+
+    // The new bytes go in as they are
+    std::vector<char> patch;
+    uint64_t patchBytes = 0;
+    failed = compressFile(secretPath, Compression::None, patch, patchBytes);
+    if (!failed.empty()) {
+        return finish(result, false, failed, total);
+    }
+    result.bytesRead += patchBytes;
+    if (appending) {
+        offset = fields.bytes;
+    }
+    if (offset > fields.bytes) {
+        return finish(result, false,
+                      "Error: The patch starts past the end of the hidden data (" + std::to_string(fields.bytes) +
+                          " bytes).",
+                      total);
+    }
+
+    const Options& job = stored.options();
+    PayloadHeader updated = fields;
+    updated.bytes = std::max(fields.bytes, offset + patchBytes);
+    const uint64_t prefixSize = prefixBytes(updated, job);
+    if (prefixSize * 8 + payloadBits(updated.bytes, job) > capacityBits((uint64_t)imageSize.x * imageSize.y, job.layout)) {
+        return finish(result, false, "Error: Carrier image is too small to hold the updated data.", total);
+    }
+    result.timings.loadMs = phase.lapMs();
+
+    // 1. Read back the affected chunks (all of them if the payload moves),
+    // checked against their CRCs, and lay the patch over them
+    const uint64_t chunk = chunkBytes(job);
+    const bool moved = prefixSize != prefixBytes(fields, job);
+    const uint64_t begin = moved ? 0 : offset / chunk * chunk;
+    const uint64_t end = moved ? updated.bytes : std::min((offset + patchBytes + chunk - 1) / chunk * chunk, updated.bytes);
+    std::vector<uint8_t> merged(end - begin);
+    std::string corrupt;
+    std::mutex corruptLock;
+    const uint64_t oldEnd = std::min(end, fields.bytes);
+    parallelFor(oldEnd > begin ? oldEnd - begin : 0, chunk, options.threads, [&](uint64_t from, uint64_t to) {
+        std::string failedRead = stored.read(begin + from, begin + to, merged.data() + from);
+        if (!failedRead.empty()) {
+            std::lock_guard<std::mutex> lock(corruptLock);
+            corrupt = failedRead;
+            return false;
+        }
+        return true;
+    });
+    if (!corrupt.empty()) {
+        result.pixelsTouched = stored.pixelsTouched();
+        return finish(result, false, corrupt, total);
+    }
+    std::memcpy(merged.data() + (offset - begin), patch.data(), patchBytes);
+    std::vector<char>().swap(patch);
+
+    // 2. Embed them again with the new header and CRCs
+    report(options, Phase::Embedding, 0, end - begin);
+    if (moved) {
+        sf::Image rewritten = image;
+        failed = embedStream(rewritten, updated, merged.data(), job, result);
+        if (!failed.empty()) {
+            return finish(result, false, failed, total);
+        }
+        pixels.assign(rewritten.getPixelsPtr(), rewritten.getPixelsPtr() + pixels.size());
+    } else {
+        uint8_t header[kHeaderBytes];
+        packHeader(updated, header);
+        embedPlain(pixels.data(), kHeaderLayout, ChannelOrder(kHeaderLayout.channels), job, 0, header, kHeaderBytes);
+        if (updated.chunkCrcs) {
+            std::vector<uint8_t> table = stored.crcTable();
+            for (uint64_t first = begin; first < end; first += chunk) {
+                const uint64_t last = std::min(first + chunk, end);
+                storeLe32(crc32c(merged.data() + (first - begin), last - first), table.data() + 4 * (first / chunk));
+            }
+            embedPlain(pixels.data(), job.layout, stored.channelOrder(), job, recordsEnd(updated, job), table.data(),
+                       table.size());
+        }
+        parallelFor(end - begin, chunk, options.threads, [&](uint64_t from, uint64_t to) {
+            embedPayload(pixels.data(), job, stored.channelOrder(), nullptr, prefixSize, begin + from,
+                         merged.data() + from, to - from);
+            return true;
+        });
+        result.pixelsTouched = kHeaderPixels + pixelsUsed(0, end - begin, job);
+    }
+    report(options, Phase::Embedding, end - begin, end - begin);
+    result.timings.processMs = phase.lapMs();
+
+    // 3. Write out only the changed rows of a BMP updated in place, else
+    // the whole image
+    report(options, Phase::Saving, end - begin, end - begin);
+    std::error_code ec;
+    bool written = false;
+    if (std::filesystem::equivalent(stegoPath, outputPath, ec)) {
+        const size_t rowBytes = (size_t)imageSize.x * 4;
+        std::vector<bool> changedRows(imageSize.y);
+        for (unsigned y = 0; y < imageSize.y; ++y) {
+            changedRows[y] = std::memcmp(original + y * rowBytes, pixels.data() + y * rowBytes, rowBytes) != 0;
+        }
+        written = rewriteBmpRows(outputPath, pixels.data(), imageSize.x, imageSize.y, changedRows, result.bytesWritten);
+    }
+    if (!written) {
+        image.create(imageSize.x, imageSize.y, pixels.data());
+        if (!image.saveToFile(outputPath)) {
+            return finish(result, false, "Error: Failed to save the output image. Ensure it's a .png file.", total);
+        }
+        result.bytesWritten = fileSize(outputPath);
+    }
+    result.timings.saveMs = phase.lapMs();
+
+    return finish(result, true,
+                  "Success! Hidden data now " + std::to_string(updated.bytes) + " bytes, saved to " + outputPath,
+                  total);
+}
+
+JobResult appendPayload(const std::string& stegoPath, const std::string& secretPath, const std::string& outputPath,
+                        const Options& options) {
+    return updatePayload(stegoPath, secretPath, true, 0, outputPath, options);
+}
+
+JobResult patchPayload(const std::string& stegoPath, const std::string& secretPath, uint64_t offset,
+                       const std::string& outputPath, const Options& options) {
+    return updatePayload(stegoPath, secretPath, false, offset, outputPath, options);
+}
+
+// --- Named Entries ---
+// A container payload holds several files behind a table of contents:
+//    0  TOC size T (4), entry count (4)
+//    8  per entry: name length (2), name (UTF-8), codec (1), offset in the
+//       container (8), stored size (8), file size (8)
+//  T-4  CRC32C of bytes 0 .. T-5
+// followed by the entries' stored bytes. Each entry is compressed on its
+// own, and sealing covers the whole container, whose segments open on their
+// own too, so extracting one entry reads and opens just the TOC and that
+// entry's part of the stream. Containers need lossless carriers: an F5 walk
+// can only be read from the start.
+
+struct ContainerEntry {
+    std::string name;
+    Compression codec = Compression::None;
+    uint64_t offset = 0;
+    uint64_t stored = 0;
+    uint64_t size = 0;
+};
+
+const uint64_t kTocFixedBytes = 12;     // Size, count and CRC
+const uint64_t kTocEntryFixedBytes = 27; // Everything but the name
+
+static std::vector<uint8_t> packToc(const std::vector<ContainerEntry>& entries) {
+    uint64_t size = kTocFixedBytes;
+    for (const ContainerEntry& entry : entries) size += kTocEntryFixedBytes + entry.name.size();
+    std::vector<uint8_t> toc(size);
+    storeLe32((uint32_t)size, toc.data());
+    storeLe32((uint32_t)entries.size(), toc.data() + 4);
+    uint8_t* at = toc.data() + 8;
+    for (const ContainerEntry& entry : entries) {
+        at[0] = (uint8_t)entry.name.size();
+        at[1] = (uint8_t)(entry.name.size() >> 8);
+        std::memcpy(at + 2, entry.name.data(), entry.name.size());
+        at += 2 + entry.name.size();
+        at[0] = (uint8_t)entry.codec;
+        storeLe64(entry.offset, at + 1);
+        storeLe64(entry.stored, at + 9);
+        storeLe64(entry.size, at + 17);
+        at += 25;
+    }
+    storeLe32(crc32c(toc.data(), size - 4), at);
+    return toc;
+}
+
+// Parses the TOC of a container of `containerBytes` bytes. Returns "" or an
+// error message.
+static std::string unpackToc(const std::vector<char>& bytes, uint64_t containerBytes,
+                             std::vector<ContainerEntry>& entries) {
+    const uint8_t* toc = reinterpret_cast<const uint8_t*>(bytes.data());
+    const uint64_t size = bytes.size();
+    if (size < kTocFixedBytes || crc32c(toc, size - 4) != loadLe32(toc + size - 4)) {
+        return "Error: The table of contents is corrupted.";
+    }
+    const uint32_t count = loadLe32(toc + 4);
+    const uint8_t* at = toc + 8;
+    const uint8_t* end = toc + size - 4;
+    for (uint32_t i = 0; i < count; ++i) {
+        if (end - at < 2 || (uint64_t)(end - at) < kTocEntryFixedBytes - 2 + 2 + (at[0] | (at[1] << 8))) {
+            return "Error: The table of contents is corrupted.";
+        }
+        ContainerEntry entry;
+        const uint64_t nameBytes = at[0] | (at[1] << 8);
+        entry.name.assign(reinterpret_cast<const char*>(at + 2), nameBytes);
+        at += 2 + nameBytes;
+        entry.codec = (Compression)at[0];
+        entry.offset = loadLe64(at + 1);
+        entry.stored = loadLe64(at + 9);
+        entry.size = loadLe64(at + 17);
+        at += 25;
+        if (entry.codec > Compression::Lz4 || entry.offset < size || entry.offset > containerBytes ||
+            entry.stored > containerBytes - entry.offset) {
+            return "Error: The table of contents is corrupted.";
+        }
+        entries.push_back(entry);
+    }
+    return "";
+}
+
+// Loads a container image and reads its TOC. Returns "" or an error message.
+static std::string openContainer(const std::string& stegoPath, const Options& options, OpenPayload& payload,
+                                 std::vector<ContainerEntry>& entries, JobResult& result) {
+    if (isJpegPath(stegoPath)) {
+        return "Error: Containers need lossless carriers.";
+    }
+    std::string failed = openPayload(stegoPath, options, payload, result);
+    if (failed.empty() && !payload.stored.header().container) {
+        failed = "Error: This image holds a single payload, not named entries.";
+    }
+    if (!failed.empty()) {
+        return failed;
+    }
+
+    // The TOC size first, then the TOC
+    std::vector<char> toc;
+    if (payload.plainBytes < kTocFixedBytes) {
+        return "Error: The table of contents is corrupted.";
+    }
+    failed = readPlain(payload, 0, 4, toc, options.threads);
+    const uint64_t tocBytes = toc.size() == 4 ? loadLe32(reinterpret_cast<const uint8_t*>(toc.data())) : 0;
+    if (failed.empty() && (tocBytes < kTocFixedBytes || tocBytes > payload.plainBytes)) {
+        failed = "Error: The table of contents is corrupted.";
+    }
+    if (failed.empty()) failed = readPlain(payload, 0, tocBytes, toc, options.threads);
+    if (failed.empty()) failed = unpackToc(toc, payload.plainBytes, entries);
+    return failed;
+}
+
+JobResult encodeEntries(const std::string& carrierPath, const std::vector<std::string>& secretPaths,
+                        const std::string& outputPath, const Options& options) {
+    JobResult result;
+    Stopwatch total, phase;
+
+    std::string invalid = validate(options);
+    if (!invalid.empty()) {
+        return finish(result, false, invalid, total);
+    }
+    if (isJpegPath(carrierPath) || isJpegPath(outputPath)) {
+        return finish(result, false, "Error: Containers need lossless carriers.", total);
+    }
+    const uint64_t count = secretPaths.size();
+    if (count == 0) {
+        return finish(result, false, "Error: No files were given.", total);
+    }
+    std::vector<ContainerEntry> entries(count);
+    for (uint64_t i = 0; i < count; ++i) {
+        entries[i].name = std::filesystem::path(secretPaths[i]).filename().string();
+        if (entries[i].name.size() > 0xFFFF) {
+            return finish(result, false, "Error: Entry names are at most 65535 bytes.", total);
+        }
+        for (uint64_t j = 0; j < i; ++j) {
+            if (entries[j].name == entries[i].name) {
+                return finish(result, false, "Error: Two entries are named " + entries[i].name + ".", total);
+            }
+        }
+    }
+
+    report(options, Phase::Loading, 0, 0);
+    sf::Image carrierImage;
+    if (!loadCarrier(carrierPath, options, carrierImage, result)) {
+        return finish(result, false, "Error: Could not load carrier image.", total);
+    }
+
+    // Compress the entries concurrently, each stored raw if it does not
+    // shrink
+    Stopwatch timer;
+    std::vector<std::vector<char>> blobs(count);
+    std::vector<std::string> errors(count);
+    parallelFor(count, 1, options.threads, [&](uint64_t begin, uint64_t end) {
+        for (uint64_t i = begin; i < end; ++i) {
+            entries[i].codec = options.compression;
+            errors[i] = compressFile(secretPaths[i], entries[i].codec, blobs[i], entries[i].size);
+            if (errors[i].empty() && entries[i].codec != Compression::None && blobs[i].size() >= entries[i].size) {
+                entries[i].codec = Compression::None;
+                errors[i] = compressFile(secretPaths[i], Compression::None, blobs[i], entries[i].size);
+            }
+            if (!errors[i].empty()) return false;
+        }
+        return true;
+    });
+    for (uint64_t i = 0; i < count; ++i) {
+        if (!errors[i].empty()) {
+            return finish(result, false, errors[i], total);
+        }
+        result.bytesRead += entries[i].size;
+    }
+    if (options.compression != Compression::None) {
+        result.timings.codecMs = timer.lapMs();
+    }
+
+    // The TOC, then the entries
+    uint64_t offset = packToc(entries).size();
+    for (uint64_t i = 0; i < count; ++i) {
+        entries[i].offset = offset;
+        entries[i].stored = blobs[i].size();
+        offset += entries[i].stored;
+    }
+    std::vector<char> container;
+    container.reserve(offset);
+    std::vector<uint8_t> toc = packToc(entries);
+    container.insert(container.end(), toc.begin(), toc.end());
+    for (std::vector<char>& blob : blobs) {
+        container.insert(container.end(), blob.begin(), blob.end());
+        std::vector<char>().swap(blob);
+    }
+
+    PayloadHeader fields = headerFor(options);
+    fields.container = true;
+    fields.encrypted = !options.passphrase.empty();
+    if (fields.encrypted) {
+        timer.lapMs();
+        std::vector<char> sealed;
+        std::string failed = seal(options.passphrase, container.data(), container.size(), sealed, options.threads);
+        if (!failed.empty()) {
+            return finish(result, false, failed, total);
+        }
+        container.swap(sealed);
+        result.timings.cryptoMs = timer.lapMs();
+    }
+    fields.bytes = container.size();
+    result.timings.loadMs = phase.lapMs();
+
+    std::string failed =
+        embedStream(carrierImage, fields, reinterpret_cast<const uint8_t*>(container.data()), options, result);
+    if (!failed.empty()) {
+        return finish(result, false, failed, total);
+    }
+    result.timings.processMs = phase.lapMs();
+
+    report(options, Phase::Saving, fields.bytes, fields.bytes);
+    if (!carrierImage.saveToFile(outputPath)) {
+        return finish(result, false, "Error: Failed to save the output image. Ensure it's a .png file.", total);
+    }
+    result.bytesWritten = fileSize(outputPath);
+    result.timings.saveMs = phase.lapMs();
+
+    return finish(result, true, "Success! " + std::to_string(count) + " entries encoded and saved to " + outputPath,
+                  total);
+}
+
+JobResult listEntries(const std::string& stegoPath, const Options& options) {
+    JobResult result;
+    Stopwatch total, phase;
+
+    std::string invalid = validate(options);
+    if (!invalid.empty()) {
+        return finish(result, false, invalid, total);
+    }
+    OpenPayload container;
+    std::vector<ContainerEntry> entries;
+    std::string failed = openContainer(stegoPath, options, container, entries, result);
+    result.pixelsTouched = container.stored.pixelsTouched();
+    if (!failed.empty()) {
+        return finish(result, false, failed, total);
+    }
+    result.timings.processMs = phase.lapMs();
+
+    std::string message = std::to_string(entries.size()) + " entries:";
+    for (const ContainerEntry& entry : entries) {
+        message += "\n  " + entry.name + " (" + std::to_string(entry.size) + " bytes)";
+    }
+    return finish(result, true, message, total);
+}
+
+JobResult decodeEntry(const std::string& stegoPath, const std::string& entryName, const std::string& outputPath,
+                      const Options& options) {
+    JobResult result;
+    Stopwatch total, phase;
+
+    std::string invalid = validate(options);
+    if (!invalid.empty()) {
+        return finish(result, false, invalid, total);
+    }
+    OpenPayload container;
+    std::vector<ContainerEntry> entries;
+    std::string failed = openContainer(stegoPath, options, container, entries, result);
+    if (!failed.empty()) {
+        result.pixelsTouched = container.stored.pixelsTouched();
+        return finish(result, false, failed, total);
+    }
+    result.timings.loadMs = phase.lapMs();
+
+    const ContainerEntry* entry = nullptr;
+    for (const ContainerEntry& candidate : entries) {
+        if (candidate.name == entryName) entry = &candidate;
+    }
+    if (!entry) {
+        return finish(result, false, "Error: The image has no entry named " + entryName + ".", total);
+    }
+
+    // Only the entry's own part of the stream
+    std::vector<char> stored;
+    report(options, Phase::Extracting, 0, entry->stored);
+    failed = readPlain(container, entry->offset, entry->offset + entry->stored, stored, options.threads);
+    result.pixelsTouched = container.stored.pixelsTouched();
+    if (!failed.empty()) {
+        return finish(result, false, failed, total);
+    }
+    report(options, Phase::Extracting, entry->stored, entry->stored);
+    result.timings.processMs = phase.lapMs();
+
+    report(options, Phase::Saving, entry->stored, entry->stored);
+    PayloadHeader fields;
+    fields.codec = entry->codec;
+    fields.bytes = entry->stored;
+    std::string unwritable = writeSecret(outputPath, stored, fields, options, result);
+    if (!unwritable.empty()) {
+        return finish(result, false, unwritable, total);
+    }
+    result.timings.saveMs = phase.lapMs();
+
+    return finish(result, true, "Success! Entry " + entryName + " saved to " + outputPath, total);
+}
+
+// One-line description of what a header says about its payload (a JPEG
+// header's layout is unused, a WAV header's channels too)
+static std::string describe(const PayloadHeader& fields, const std::string& stegoPath) {
+    static const char* modes[] = {"plain", "matching", "matrix", "trellis"};
+    static const char* codecs[] = {"", ", zstd", ", lz4"};
+    std::string text = std::to_string(fields.bytes) + " bytes, ";
+    if (isJpegPath(stegoPath)) {
+        text += "DCT coefficients, ";
+    } else if (isWavPath(stegoPath)) {
+        text += std::to_string(fields.layout.bitsPerChannel) +
+                (fields.layout.bitsPerChannel == 1 ? " bit per sample, " : " bits per sample, ");
+    } else {
+        text += std::to_string(fields.layout.bitsPerChannel) + (fields.layout.bitsPerChannel == 1 ? " bit" : " bits") +
+                (fields.layout.channels == ChannelLayout::RGBA ? " per RGBA channel, " : " per RGB channel, ");
+    }
+    text += modes[(int)fields.mode];
+    if (fields.modeParameter) text += " " + std::to_string(fields.modeParameter);
+    text += fields.traversal == TraversalMode::Keyed ? ", keyed" : ", sequential";
+    if (fields.sharded) text += ", shard of a set";
+    if (fields.container) text += ", named entries";
+    return text + codecs[(int)fields.codec] + (fields.encrypted ? ", encrypted" : "") +
+           (fields.chunkCrcs ? ", chunk CRCs" : "");
+}
+
+JobResult probe(const std::string& stegoPath) {
+    JobResult result;
+    Stopwatch total, phase;
+
+    // Only the header pixels are needed: the leading PNG rows where
+    // possible, else the whole image
+    uint8_t header[kHeaderBytes];
+    bool found = false;
+    if (isJpegPath(stegoPath)) {
+        JpegImage stego;
+        if (!stego.load(stegoPath)) {
+            return finish(result, false, "Error: Could not load the steganographic image.", total);
+        }
+        F5Reader reader(stego);
+        found = reader.read(header, 4, 1) && isVersioned(header) && reader.read(header + 4, kHeaderBytes - 4, 1);
+    } else if (isWavPath(stegoPath)) {
+        WavFormat format;
+        std::string unreadable = readWavFormat(stegoPath, format);
+        if (unreadable.empty()) unreadable = readWavHeader(stegoPath, format, header, found);
+        if (!unreadable.empty()) {
+            return finish(result, false, unreadable, total);
+        }
+        result.pixelsTouched = std::min<uint64_t>(kWavHeaderSamples, format.sampleCount());
+    } else {
+        std::vector<uint8_t> rgba;
+        unsigned width = 0, height = 0;
+        sf::Image stegoImage;
+        const uint8_t* pixels = rgba.data();
+        if (readLeadingPixels(stegoPath, kHeaderPixels, rgba, width, height)) {
+            pixels = rgba.data();
+        } else if (stegoImage.loadFromFile(stegoPath)) {
+            width = stegoImage.getSize().x;
+            height = stegoImage.getSize().y;
+            pixels = stegoImage.getPixelsPtr();
+        } else {
+            return finish(result, false, "Error: Could not load the steganographic image.", total);
+        }
+        if ((uint64_t)width * height >= kHeaderPixels) {
+            extractOrdered(pixels, kHeaderLayout, ChannelOrder(kHeaderLayout.channels), 0, header, kHeaderBytes);
+            found = isVersioned(header);
+        }
+        result.pixelsTouched = std::min<uint64_t>(kHeaderPixels, (uint64_t)width * height);
+    }
+    result.timings.loadMs = phase.lapMs();
+
+    if (!found) {
+        return finish(result, false, "No hidden data found.", total);
+    }
+    PayloadHeader fields;
+    std::string invalid = unpackHeader(header, fields);
+    if (!invalid.empty()) {
+        return finish(result, false, invalid, total);
+    }
+    return finish(result, true, "Found: " + describe(fields, stegoPath), total);
+}
+
+// --- Batch Scheduling ---
+// Payloads are packed into indexed carriers best-fit decreasing: largest
+// payload first, each into the open carrier it leaves least room in, else
+// into a new one, the smallest that holds it when saving pixels or the
+// largest unused one when saving carriers. A carrier that takes several
+// payloads holds them as named entries, so each is sized with the TOC it
+// adds and, when sealed, with the whole container sealed. A final pass
+// moves every carrier down to the smallest unused one that still holds
+// what it took, which keeps the carrier count and can only save pixels.
+// Sizes are those of the uncompressed files, which compression can only
+// shrink.
+
+namespace {
+
+// A carrier being filled
+struct OpenCarrier {
+    uint64_t carrier;                // Position in the capacity order
+    std::vector<uint64_t> payloads;  // Positions in the size order
+    uint64_t entryBytes = 0;         // Container bytes of the payloads so far
+};
+
+} // namespace
+
+JobResult scheduleJobs(const std::string& indexPath, const std::vector<std::string>& secretPaths,
+                       const std::string& outputDirectory, PackGoal goal, const Options& options,
+                       std::vector<ScheduledJob>& plan) {
+    JobResult result;
+    Stopwatch total, phase;
+    plan.clear();
+
+    std::string invalid = validate(options);
+    if (!invalid.empty()) {
+        return finish(result, false, invalid, total);
+    }
+    CarrierIndex index;
+    std::string failed = index.open(indexPath);
+    if (!failed.empty()) {
+        return finish(result, false, failed, total);
+    }
+
+    // 1. Payload sizes, largest first
+    struct Payload {
+        std::string path;
+        std::string name;
+        uint64_t bytes;
+    };
+    std::vector<Payload> payloads;
+    for (const std::string& path : secretPaths) {
+        std::error_code ec;
+        const uint64_t bytes = std::filesystem::file_size(path, ec);
+        if (ec) {
+            return finish(result, false, "Error: Could not read " + path + ".", total);
+        }
+        payloads.push_back({path, std::filesystem::path(path).filename().string(), bytes});
+    }
+    std::stable_sort(payloads.begin(), payloads.end(),
+                     [](const Payload& a, const Payload& b) { return a.bytes > b.bytes; });
+
+    // 2. Carrier capacities, smallest first. Pools hold many images of the
+    // same few sizes, so each pixel count is worked out once.
+    const bool needsAlpha = options.layout.channels == ChannelLayout::RGBA;
+    std::unordered_map<uint64_t, uint64_t> capacityOf;
+    struct Carrier {
+        uint64_t record;
+        uint64_t pixels;
+        uint64_t capacity;
+    };
+    std::vector<Carrier> carriers;
+    for (uint64_t i = 0; i < index.size(); ++i) {
+        if (needsAlpha && !index.hasAlpha(i)) continue;
+        const uint64_t pixels = index.pixelCount(i);
+        auto known = capacityOf.find(pixels);
+        const uint64_t capacity =
+            known != capacityOf.end() ? known->second : (capacityOf[pixels] = capacityFor(pixels, options));
+        if (capacity > 0) carriers.push_back({i, pixels, capacity});
+    }
+    std::sort(carriers.begin(), carriers.end(), [](const Carrier& a, const Carrier& b) {
+        return a.capacity != b.capacity ? a.capacity < b.capacity : a.record < b.record;
+    });
+    result.timings.loadMs = phase.lapMs();
+
+    // Stored bytes of a carrier's content: the payload as it is, or a
+    // container of several; sealed when encrypting
+    const bool sealing = !options.passphrase.empty();
+    auto storedBytes = [&](uint64_t count, uint64_t bytes) {
+        const uint64_t stored = count == 1 ? bytes : bytes + kTocFixedBytes;
+        return sealing ? sealedSize(stored) : stored;
+    };
+    auto entryBytes = [&](const Payload& payload) { return kTocEntryFixedBytes + payload.name.size() + payload.bytes; };
+
+    // 3. Pack
+    std::vector<char> used(carriers.size());
+    std::vector<OpenCarrier> open;
+    for (uint64_t p = 0; p < payloads.size(); ++p) {
+        const Payload& payload = payloads[p];
+        size_t best = open.size();
+        uint64_t bestLeft = UINT64_MAX;
+        for (size_t b = 0; b < open.size(); ++b) {
+            const OpenCarrier& bin = open[b];
+            bool clash = false;
+            for (uint64_t q : bin.payloads) clash = clash || payloads[q].name == payload.name;
+            const uint64_t stored = storedBytes(bin.payloads.size() + 1, bin.entryBytes + entryBytes(payload));
+            const uint64_t capacity = carriers[bin.carrier].capacity;
+            if (!clash && stored <= capacity && capacity - stored < bestLeft) {
+                best = b;
+                bestLeft = capacity - stored;
+            }
+        }
+        if (best == open.size()) {
+            // A new carrier: binary search for the smallest that holds the
+            // payload alone, or the largest there is
+            const uint64_t need = storedBytes(1, payload.bytes);
+            uint64_t pick = carriers.size();
+            if (goal == PackGoal::FewestPixels) {
+                auto first = std::lower_bound(carriers.begin(), carriers.end(), need,
+                                              [](const Carrier& c, uint64_t bytes) { return c.capacity < bytes; });
+                for (uint64_t c = first - carriers.begin(); c < carriers.size() && pick == carriers.size(); ++c) {
+                    if (!used[c]) pick = c;
+                }
+            } else {
+                for (uint64_t c = carriers.size(); c-- > 0 && carriers[c].capacity >= need;) {
+                    if (!used[c]) {
+                        pick = c;
+                        break;
+                    }
+                }
+            }
+            if (pick == carriers.size()) {
+                return finish(result, false,
+                              "Error: " + payload.path + " fits no free indexed carrier on its own; split it with shard.",
+                              total);
+            }
+            used[pick] = 1;
+            open.push_back({pick, {}, 0});
+        }
+        open[best].payloads.push_back(p);
+        open[best].entryBytes += entryBytes(payload);
+    }
+
+    // 4. Move each carrier down to the smallest free one that still holds
+    // its content
+    for (OpenCarrier& bin : open) {
+        const uint64_t need = storedBytes(bin.payloads.size(), bin.payloads.size() == 1
+                                                                   ? payloads[bin.payloads[0]].bytes
+                                                                   : bin.entryBytes);
+        auto first = std::lower_bound(carriers.begin(), carriers.end(), need,
+                                      [](const Carrier& c, uint64_t bytes) { return c.capacity < bytes; });
+        for (uint64_t c = first - carriers.begin(); c < bin.carrier; ++c) {
+            if (!used[c] && carriers[c].pixels < carriers[bin.carrier].pixels) {
+                used[bin.carrier] = 0;
+                used[c] = 1;
+                bin.carrier = c;
+                break;
+            }
+        }
+    }
+
+    // 5. The jobs, each writing a PNG named after its carrier
+    std::set<std::string> outputs;
+    uint64_t pixels = 0;
+    for (const OpenCarrier& bin : open) {
+        ScheduledJob job;
+        job.carrierPath = index.at(carriers[bin.carrier].record).path;
+        job.pixelCount = carriers[bin.carrier].pixels;
+        for (uint64_t p : bin.payloads) {
+            job.secretPaths.push_back(payloads[p].path);
+            job.payloadBytes += payloads[p].bytes;
+        }
+        const std::string stem = std::filesystem::path(job.carrierPath).stem().string();
+        std::string output = (std::filesystem::path(outputDirectory) / (stem + ".png")).string();
+        for (unsigned n = 2; !outputs.insert(output).second; ++n) {
+            output = (std::filesystem::path(outputDirectory) / (stem + "-" + std::to_string(n) + ".png")).string();
+        }
+        job.outputPath = output;
+        pixels += job.pixelCount;
+        plan.push_back(std::move(job));
+    }
+    result.timings.processMs = phase.lapMs();
+
+    return finish(result, true,
+                  "Planned " + std::to_string(payloads.size()) + " payloads into " + std::to_string(plan.size()) +
+                      (plan.size() == 1 ? " carrier, " : " carriers, ") + std::to_string(pixels) + " pixels in all.",
+                  total);
+}
+
+JobResult runSchedule(const std::vector<ScheduledJob>& plan, const Options& options) {
+    JobResult result;
+    Stopwatch total, phase;
+
+    // Jobs run concurrently, the workers shared out between them
+    std::vector<JobResult> results(plan.size());
+    uint64_t bytesTotal = 0;
+    for (const ScheduledJob& job : plan) bytesTotal += job.payloadBytes;
+    std::atomic<uint64_t> bytesDone{0};
+    const Options each = shardOptions(options, std::max<uint64_t>(1, plan.size()));
+    report(options, Phase::Embedding, 0, bytesTotal);
+    bool completed = parallelFor(plan.size(), 1, options.threads, [&](uint64_t begin, uint64_t end) {
+        for (uint64_t i = begin; i < end; ++i) {
+            if (isCancelled(options)) return false;
+            const ScheduledJob& job = plan[i];
+            results[i] = job.secretPaths.size() == 1 ? encode(job.carrierPath, job.secretPaths[0], job.outputPath, each)
+                                                     : encodeEntries(job.carrierPath, job.secretPaths, job.outputPath, each);
+            bytesDone += job.payloadBytes;
+        }
+        return true;
+    }, [&]() { report(options, Phase::Embedding, bytesDone, bytesTotal); });
+
+    uint64_t failures = 0;
+    std::string firstFailure;
+    for (size_t i = 0; i < plan.size(); ++i) {
+        result.bytesRead += results[i].bytesRead;
+        result.bytesWritten += results[i].bytesWritten;
+        result.pixelsTouched += results[i].pixelsTouched;
+        result.timings.codecMs += results[i].timings.codecMs;
+        result.timings.cryptoMs += results[i].timings.cryptoMs;
+        if (!results[i].ok && completed) {
+            if (failures++ == 0) firstFailure = inImage(results[i].message, plan[i].carrierPath);
+        }
+    }
+    result.timings.processMs = phase.lapMs();
+
+    if (!completed || isCancelled(options)) {
+        return finish(result, false, "Cancelled: The schedule stopped before every job ran.", total);
+    }
+    if (failures > 0) {
+        return finish(result, false,
+                      firstFailure + " (" + std::to_string(failures) + " of " + std::to_string(plan.size()) +
+                          (plan.size() == 1 ? " job" : " jobs") + " failed)",
+                      total);
+    }
+    report(options, Phase::Embedding, bytesTotal, bytesTotal);
+    return finish(result, true, "Success! Ran " + std::to_string(plan.size()) + (plan.size() == 1 ? " job." : " jobs."),
+                  total);
+}
+
+} // namespace Steganography
\ No newline at end of file
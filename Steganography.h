@@ -0,0 +1,223 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "Compression.h"
+#include "CostMap.h"
+#include "Kernels.h"
+
+// --- Steganography Logic ---
+namespace Steganography {
+
+// --- Progress & Cancellation ---
+// Jobs report progress and poll for cancellation once per chunk of payload
+// bytes, never per bit, so observers add no measurable cost to the hot loop.
+const uint32_t kChunkBytes = 64 * 1024;
+
+enum class Phase { Loading, Embedding, Extracting, Saving };
+
+struct Progress {
+    Phase phase;
+    uint64_t bytesDone;  // Payload bytes embedded/extracted so far
+    uint64_t bytesTotal; // Payload bytes in the whole job
+};
+
+// Cooperative cancellation flag shared between the caller and a running job
+class CancelToken {
+public:
+    void cancel() { cancelled.store(true, std::memory_order_relaxed); }
+    void reset() { cancelled.store(false, std::memory_order_relaxed); }
+    bool isCancelled() const { return cancelled.load(std::memory_order_relaxed); }
+private:
+    std::atomic<bool> cancelled{false};
+};
+
+class CarrierCache; // See CarrierCache.h
+
+// How payload bits are written into the channel LSBs
+enum class EmbedMode {
+    Replace,  // One payload bit per channel bit (the original scheme)
+    Matching, // Replace, but changed LSBs move by +-1 instead; decodes as Replace
+    Hamming, // Matrix embedding: k bits per 2^k - 1 channel LSBs, at most one change
+    Stc       // Syndrome-trellis code: 1 bit per `stcWidth` channel LSBs, fewest flips
+};
+
+// Order in which the bit stream visits the carrier's channels
+enum class TraversalMode {
+    Sequential, // Pixel by pixel from (0,0)
+    Keyed       // Keyed pseudo-random permutation of all channels
+};
+
+struct Options {
+    std::function<void(const Progress&)> onProgress; // Optional progress sink
+    const CancelToken* cancelToken = nullptr;        // Optional cancellation token
+    Layout layout;                                   // Recorded in the header; decode needs it for older images only
+    unsigned threads = 0;                            // Worker threads; 0 = one per hardware thread
+    EmbedMode mode = EmbedMode::Replace;             // Recorded in the header, as are hammingK and stcWidth
+    unsigned hammingK = 3;                           // Hamming mode: 2..6 payload bits per group
+    unsigned stcWidth = 4;                           // STC mode: 2..16 channels per payload bit
+    CostFilter costFilter = CostFilter::None;        // STC mode: adaptive flip costs (encode only)
+    TraversalMode traversal = TraversalMode::Sequential; // Recorded in the header; the key is not
+    std::string key;                                 // Keyed traversal passphrase; also seeds matching signs
+    Compression compression = Compression::None;     // Payload codec (encode only; recorded in the header)
+    std::string passphrase;                          // Seals the payload when set; needed to decode sealed ones
+    bool chunkCrcs = false;                          // CRC32C per payload chunk (encode only; recorded in the header)
+    unsigned parityShards = 0;                       // encodeShards: carriers given over to parity, any that many may be lost
+    CarrierCache* carrierCache = nullptr;            // Optional decoded carriers shared between encodes (lossless only)
+};
+
+// --- Job Results ---
+struct PhaseTimings {
+    double loadMs = 0;    // Carrier/stego image decode plus secret file read
+    double processMs = 0; // Embed or extract loop
+    double costMapMs = 0; // Adaptive cost map, part of processMs
+    double codecMs = 0;   // Payload compression (part of loadMs) or decompression (part of saveMs)
+    double cryptoMs = 0;  // Payload sealing (part of loadMs) or opening (part of saveMs)
+    double parityMs = 0;  // Shard parity encode (part of loadMs) or rebuild (part of processMs)
+    double saveMs = 0;    // Output image encode or decoded file write
+    double totalMs = 0;
+};
+
+struct JobResult {
+    bool ok = false;
+    std::string message;
+    PhaseTimings timings;
+    uint64_t bytesRead = 0;     // Bytes read from disk (image file + secret file)
+    uint64_t bytesWritten = 0;  // Bytes written to disk
+    uint64_t pixelsTouched = 0; // Pixels read or modified by the embed/extract loop
+};
+
+// Serializes a job result as a single-line JSON object for dashboards
+std::string toJson(const JobResult& result);
+
+// Human-readable one-line summary of a job's timings and I/O
+std::string summarize(const JobResult& result);
+
+// Main encoding function
+JobResult encode(const std::string& carrierPath, const std::string& secretPath, const std::string& outputPath, const Options& options = Options());
+
+// Main decoding function
+JobResult decode(const std::string& stegoPath, const std::string& outputPath, const Options& options = Options());
+
+// Decodes only bytes [offset, offset + length) of an uncompressed payload,
+// cut short at its end. Only the pixels holding them are read and, for a
+// PNG whose payload is not keyed, only the rows they lie in are decoded.
+JobResult decodeRange(const std::string& stegoPath, uint64_t offset, uint64_t length, const std::string& outputPath,
+                      const Options& options = Options());
+
+// Adds the contents of secretPath to the end of an uncompressed, unsealed
+// payload, re-embedding only the header and the chunks that change. Writing
+// a BMP back over itself rewrites only the rows that changed.
+JobResult appendPayload(const std::string& stegoPath, const std::string& secretPath, const std::string& outputPath,
+                        const Options& options = Options());
+
+// Overwrites payload bytes from `offset` on with the contents of secretPath,
+// growing the payload if they run past its end; otherwise as appendPayload
+JobResult patchPayload(const std::string& stegoPath, const std::string& secretPath, uint64_t offset,
+                       const std::string& outputPath, const Options& options = Options());
+
+// Splits one payload over several lossless carriers in proportion to their
+// capacity, writing carrierPaths[i] with its shard to outputPaths[i]. The
+// images are processed concurrently, so processMs spans their loads, embeds
+// and saves.
+JobResult encodeShards(const std::vector<std::string>& carrierPaths, const std::string& secretPath,
+                       const std::vector<std::string>& outputPaths, const Options& options = Options());
+
+// Joins the payload of a sharded set back together; the images may come in
+// any order but must include every shard. loadMs spans the concurrent loads
+// and extractions.
+JobResult decodeShards(const std::vector<std::string>& stegoPaths, const std::string& outputPath,
+                       const Options& options = Options());
+
+// Hides several files in one lossless carrier as named entries, each
+// compressed on its own (an entry that does not shrink is stored as is) and
+// listed in a table of contents. Entries are named by their file names.
+JobResult encodeEntries(const std::string& carrierPath, const std::vector<std::string>& secretPaths,
+                        const std::string& outputPath, const Options& options = Options());
+
+// Lists the entries of a container image in its message, one per line
+JobResult listEntries(const std::string& stegoPath, const Options& options = Options());
+
+// Extracts one named entry, reading (and, when sealed, opening) only the
+// table of contents and that entry's part of the payload
+JobResult decodeEntry(const std::string& stegoPath, const std::string& entryName, const std::string& outputPath,
+                      const Options& options = Options());
+
+// A carrier's capacity in payload bytes, worked out from its file header
+struct CarrierCapacity {
+    std::string path;
+    unsigned width = 0;
+    unsigned height = 0;
+    uint64_t chosen = 0;          // Under the options the plan was made with
+    std::vector<uint64_t> byMode; // Under each of planModes(), in order
+};
+
+// Names of the modes a plan reports: bits1/2/4, match, hamming2..6 and
+// stc2/4/8
+std::vector<std::string> planModes();
+
+// Largest payload, in bytes, a carrier of `pixelCount` pixels holds under
+// `options`
+uint64_t capacityFor(uint64_t pixelCount, const Options& options = Options());
+
+// capacityFor under each of planModes(), each keeping the channels and chunk
+// CRC choice of `options`
+std::vector<uint64_t> planCapacities(uint64_t pixelCount, const Options& options = Options());
+
+// Reads the size of every lossless image under `directory` (recursively)
+// from its file header alone, concurrently, and fills `plan` with their
+// capacities, largest first under `options`. Every mode keeps the channels
+// and chunk CRC choice of `options`. JPEGs are skipped.
+JobResult planCarriers(const std::string& directory, std::vector<CarrierCapacity>& plan,
+                       const Options& options = Options());
+
+// One carrier of a plan as a JSON object
+std::string toJson(const CarrierCapacity& carrier);
+
+// Brings the carrier index at indexPath (see CarrierIndex.h) up to date with
+// the lossless images under `directory`: new and changed files are read and
+// hashed, unchanged ones carried over, and vanished ones dropped.
+JobResult refreshIndex(const std::string& indexPath, const std::string& directory,
+                       const Options& options = Options());
+
+// Looks up the smallest indexed carrier that holds `payloadBytes` stored
+// bytes under `options` and sets carrierPath to it; not ok if none does
+JobResult chooseCarrier(const std::string& indexPath, uint64_t payloadBytes, const Options& options,
+                        std::string& carrierPath);
+
+// One encode of a schedule: a carrier and the payloads it takes, hidden as
+// a plain payload when there is one and as named entries when there are more
+struct ScheduledJob {
+    std::string carrierPath;
+    std::string outputPath;
+    std::vector<std::string> secretPaths;
+    uint64_t pixelCount = 0;
+    uint64_t payloadBytes = 0; // File sizes of the payloads together
+};
+
+// What a schedule keeps down: the pixels of the carriers it uses, or their
+// number
+enum class PackGoal { FewestPixels, FewestCarriers };
+
+// Packs the payloads into carriers of the index at indexPath (see
+// CarrierIndex.h), each used at most once, and sets `plan` to one job per
+// carrier used, writing a PNG under outputDirectory. Not ok if a payload
+// fits no carrier on its own.
+JobResult scheduleJobs(const std::string& indexPath, const std::vector<std::string>& secretPaths,
+                       const std::string& outputDirectory, PackGoal goal, const Options& options,
+                       std::vector<ScheduledJob>& plan);
+
+// Runs the jobs of a plan concurrently, the worker threads shared out
+// between them; progress counts the payload bytes of finished jobs
+JobResult runSchedule(const std::vector<ScheduledJob>& plan, const Options& options = Options());
+
+// Reads only the payload header of a stego image (for a PNG, just the rows
+// holding the header pixels) and describes what it records. Not ok when the
+// image carries no version 2 header.
+JobResult probe(const std::string& stegoPath);
+
+} // namespace Steganography
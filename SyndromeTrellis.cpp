@@ -0,0 +1,269 @@
+#include "SyndromeTrellis.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#ifdef STEG_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+#include "Bits.h"
+
+namespace Steganography {
+
+namespace {
+
+const unsigned kStates = 1u << kStcHeight;
+const unsigned kPathBytes = kStcPathBytes;
+const float kInfinity = std::numeric_limits<float>::infinity();
+
+// Columns of the h x width submatrix. Fixed per width so encoder and decoder
+// agree; every column has its top and bottom row set, so each payload bit
+// can always be reached from its own block and a flip reaches the whole
+// constraint window.
+struct Submatrix {
+    uint32_t columns[kMaxStcWidth];
+};
+
+Submatrix submatrixFor(unsigned width) {
+    Submatrix h = {};
+    uint32_t seed = 0x9E3779B9u ^ width;
+    for (unsigned c = 0; c < width;) {
+        seed = seed * 1664525u + 1013904223u;
+        uint32_t column = ((seed >> 16) & (kStates - 1)) | 1u | (1u << (kStcHeight - 1));
+        bool repeated = false;
+        for (unsigned p = 0; p < c; ++p) repeated |= h.columns[p] == column;
+        if (!repeated) h.columns[c++] = column;
+    }
+    return h;
+}
+
+// The last h - 1 payload bits of a block have fewer than h rows left below
+// them; the rows past the end of the block are cut off
+inline uint32_t rowMask(uint64_t rowsLeft) {
+    return rowsLeft >= kStcHeight ? kStates - 1 : (1u << rowsLeft) - 1;
+}
+
+inline unsigned bitAt(const uint8_t* bits, uint64_t i) {
+    return (bits[i >> 3] >> (i & 7)) & 1;
+}
+
+// --- Viterbi Forward Pass ---
+// Walks one block's trellis and records, for every channel and state,
+// whether the cheapest way into that state set the channel's LSB. Bit s of
+// a channel's kPathBytes entry is state s.
+typedef void (*ForwardPass)(const uint8_t* lsbs, const float* costs, const Submatrix& h, unsigned width,
+                            const uint8_t* message, uint64_t bits, uint8_t* path);
+
+void forwardScalar(const uint8_t* lsbs, const float* costs, const Submatrix& h, unsigned width,
+                   const uint8_t* message, uint64_t bits, uint8_t* path) {
+    float cost[kStates], next[kStates];
+    std::fill(cost, cost + kStates, kInfinity);
+    cost[0] = 0;
+
+    uint64_t i = 0;
+    for (uint64_t j = 0; j < bits; ++j) {
+        uint32_t mask = rowMask(bits - j);
+        for (unsigned c = 0; c < width; ++c, ++i) {
+            uint32_t column = h.columns[c] & mask;
+            float rho = costs ? costs[i] : 1.0f;
+            float zero = bitAt(lsbs, i) ? rho : 0.0f; // Cost of leaving/making the LSB 0
+            float one = bitAt(lsbs, i) ? 0.0f : rho;
+            uint8_t* out = path + i * kPathBytes;
+            std::memset(out, 0, kPathBytes);
+            for (unsigned s = 0; s < kStates; ++s) {
+                float a = cost[s] + zero;
+                float b = cost[s ^ column] + one;
+                bool takeOne = b < a;
+                next[s] = takeOne ? b : a;
+                out[s >> 3] |= (uint8_t)(takeOne << (s & 7));
+            }
+            std::memcpy(cost, next, sizeof(cost));
+        }
+
+        // Keep the states whose finished row matches the payload bit and
+        // shift the window down one row
+        unsigned bit = bitAt(message, j);
+        for (unsigned s = 0; s < kStates / 2; ++s) next[s] = cost[2 * s + bit];
+        std::fill(next + kStates / 2, next + kStates, kInfinity);
+        std::memcpy(cost, next, sizeof(cost));
+    }
+}
+
+#ifdef STEG_X86_KERNELS
+
+// 8 states per vector. Reaching state s from s ^ column is a swap of whole
+// vectors by the column's high bits and a lane permute by its low 3 bits, so
+// each channel is 16 add/permute/min/compare steps and one movemask per
+// vector of survivor bits.
+STEG_TARGET("avx2")
+void forwardAvx2(const uint8_t* lsbs, const float* costs, const Submatrix& h, unsigned width,
+                 const uint8_t* message, uint64_t bits, uint8_t* path) {
+    const unsigned kVectors = kStates / 8;
+    __m256 bufferA[kVectors], bufferB[kVectors];
+    __m256* cost = bufferA;
+    __m256* next = bufferB;
+    const __m256 infinity = _mm256_set1_ps(kInfinity);
+    const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    for (unsigned v = 0; v < kVectors; ++v) cost[v] = infinity;
+    cost[0] = _mm256_blend_ps(infinity, _mm256_setzero_ps(), 1);
+
+    uint64_t i = 0;
+    for (uint64_t j = 0; j < bits; ++j) {
+        uint32_t mask = rowMask(bits - j);
+        for (unsigned c = 0; c < width; ++c, ++i) {
+            uint32_t column = h.columns[c] & mask;
+            unsigned swap = column >> 3;
+            __m256i permute = _mm256_xor_si256(lanes, _mm256_set1_epi32((int)(column & 7)));
+            float rho = costs ? costs[i] : 1.0f;
+            __m256 zero = _mm256_set1_ps(bitAt(lsbs, i) ? rho : 0.0f);
+            __m256 one = _mm256_set1_ps(bitAt(lsbs, i) ? 0.0f : rho);
+            uint8_t* out = path + i * kPathBytes;
+            for (unsigned v = 0; v < kVectors; ++v) {
+                __m256 a = _mm256_add_ps(cost[v], zero);
+                __m256 b = _mm256_add_ps(_mm256_permutevar8x32_ps(cost[v ^ swap], permute), one);
+                out[v] = (uint8_t)_mm256_movemask_ps(_mm256_cmp_ps(b, a, _CMP_LT_OQ));
+                next[v] = _mm256_min_ps(b, a); // b < a ? b : a, ties keep the 0 branch
+            }
+            std::swap(cost, next);
+        }
+
+        // States 2s + bit of vectors 2v and 2v + 1 become states s of vector v
+        int bit = (int)bitAt(message, j);
+        __m256i pick = _mm256_setr_epi32(bit, bit + 2, bit + 4, bit + 6, bit, bit + 2, bit + 4, bit + 6);
+        for (unsigned v = 0; v < kVectors / 2; ++v) {
+            __m256 low = _mm256_permutevar8x32_ps(cost[2 * v], pick);
+            __m256 high = _mm256_permutevar8x32_ps(cost[2 * v + 1], pick);
+            next[v] = _mm256_permute2f128_ps(low, high, 0x20);
+        }
+        for (unsigned v = kVectors / 2; v < kVectors; ++v) next[v] = infinity;
+        std::swap(cost, next);
+    }
+}
+
+#endif // STEG_X86_KERNELS
+
+// STEG_KERNEL=scalar pins the scalar pass, like it does for the LSB kernels
+ForwardPass forwardPass() {
+    static const ForwardPass chosen = [] {
+#ifdef STEG_X86_KERNELS
+        const char* pinned = std::getenv("STEG_KERNEL");
+        bool scalarOnly = pinned && std::strcmp(pinned, "scalar") == 0;
+        if (!scalarOnly && cpuSupports("avx2")) return (ForwardPass)forwardAvx2;
+#endif
+        return (ForwardPass)forwardScalar;
+    }();
+    return chosen;
+}
+
+// Follows the survivor bits back from the final state and flips every
+// channel whose chosen LSB differs from the cover
+void traceBack(uint8_t* pixels, const ChannelOrder& order, uint64_t firstChannel, const uint8_t* lsbs,
+               const Submatrix& h, unsigned width, const uint8_t* message, uint64_t bits, const uint8_t* path) {
+    // Rows past the block end are cut off, so the only state left after the
+    // last payload bit is 0
+    uint32_t state = 0;
+    uint64_t i = bits * width;
+    for (uint64_t j = bits; j-- > 0;) {
+        state = ((state << 1) | bitAt(message, j)) & (kStates - 1);
+        uint32_t mask = rowMask(bits - j);
+        for (unsigned c = width; c-- > 0;) {
+            --i;
+            unsigned y = bitAt(path + i * kPathBytes, state);
+            if (y) state ^= h.columns[c] & mask;
+            if (y != bitAt(lsbs, i)) {
+                pixels[channelByte(order, firstChannel + i)] ^= 1;
+            }
+        }
+    }
+}
+
+void embedBlocks(ForwardPass forward, uint8_t* pixels, const ChannelOrder& order, uint64_t firstChannel,
+                 unsigned width, const uint8_t* data, uint64_t byteCount, const float* pixelCosts) {
+    const Submatrix h = submatrixFor(width);
+    const uint64_t blockChannels = stcChannels(std::min(byteCount, kStcBlockBytes), width);
+
+    std::vector<uint8_t> lsbs((size_t)blockChannels / 8);
+    std::vector<uint8_t> path((size_t)blockChannels * kPathBytes);
+    std::vector<float> costs(pixelCosts ? (size_t)blockChannels : 0);
+    for (uint64_t offset = 0; offset < byteCount; offset += kStcBlockBytes) {
+        uint64_t bytes = std::min(kStcBlockBytes, byteCount - offset);
+        uint64_t channel = stcChannels(offset, width);
+        gatherLsbs(pixels, order, firstChannel + channel, stcChannels(bytes, width), lsbs.data());
+
+        if (pixelCosts) {
+            gatherCosts(pixelCosts, order, firstChannel + channel, stcChannels(bytes, width), costs.data());
+        }
+        forward(lsbs.data(), pixelCosts ? costs.data() : nullptr, h, width, data + offset, bytes * 8, path.data());
+        traceBack(pixels, order, firstChannel + channel, lsbs.data(), h, width, data + offset, bytes * 8,
+                  path.data());
+    }
+}
+
+// A forward pass pinned into the public kernel signatures
+template <ForwardPass pass>
+void forwardBlock(const uint8_t* lsbs, const float* costs, unsigned width, const uint8_t* message, uint64_t bits,
+                  uint8_t* path) {
+    pass(lsbs, costs, submatrixFor(width), width, message, bits, path);
+}
+
+template <ForwardPass pass>
+void embedWith(uint8_t* pixels, const ChannelOrder& order, uint64_t firstChannel, unsigned width,
+               const uint8_t* data, uint64_t byteCount, const float* pixelCosts) {
+    embedBlocks(pass, pixels, order, firstChannel, width, data, byteCount, pixelCosts);
+}
+
+} // namespace
+
+uint64_t stcChannels(uint64_t byteCount, unsigned width) {
+    return byteCount * 8 * width;
+}
+
+uint64_t stcCapacityBytes(uint64_t channelCount, unsigned width) {
+    return channelCount / width / 8;
+}
+
+std::vector<StcVariant> availableStcKernels() {
+    std::vector<StcVariant> kernels = {{"scalar", forwardBlock<forwardScalar>, embedWith<forwardScalar>}};
+#ifdef STEG_X86_KERNELS
+    if (cpuSupports("avx2")) kernels.push_back({"avx2", forwardBlock<forwardAvx2>, embedWith<forwardAvx2>});
+#endif
+    return kernels;
+}
+
+void stcEmbed(uint8_t* pixels, const ChannelOrder& order, uint64_t firstChannel, unsigned width,
+              const uint8_t* data, uint64_t byteCount, const float* pixelCosts) {
+    embedBlocks(forwardPass(), pixels, order, firstChannel, width, data, byteCount, pixelCosts);
+}
+
+void stcExtract(const uint8_t* pixels, const ChannelOrder& order, uint64_t firstChannel, unsigned width,
+                uint8_t* data, uint64_t byteCount) {
+    const Submatrix h = submatrixFor(width);
+    const uint64_t blockChannels = stcChannels(std::min(byteCount, kStcBlockBytes), width);
+
+    // The payload is H y: run the window of open rows over the stego LSBs
+    std::vector<uint8_t> lsbs((size_t)blockChannels / 8);
+    for (uint64_t offset = 0; offset < byteCount; offset += kStcBlockBytes) {
+        uint64_t bytes = std::min(kStcBlockBytes, byteCount - offset);
+        uint64_t bits = bytes * 8;
+        gatherLsbs(pixels, order, firstChannel + stcChannels(offset, width), stcChannels(bytes, width),
+                   lsbs.data());
+
+        BitWriter out(data + offset, bytes);
+        uint32_t state = 0;
+        uint64_t i = 0;
+        for (uint64_t j = 0; j < bits; ++j) {
+            uint32_t mask = rowMask(bits - j);
+            for (unsigned c = 0; c < width; ++c, ++i) {
+                state ^= h.columns[c] & mask & (0u - bitAt(lsbs.data(), i));
+            }
+            out.write(state & 1, 1);
+            state >>= 1;
+        }
+    }
+}
+
+} // namespace Steganography
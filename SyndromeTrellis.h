@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Traversal.h"
+
+// --- Syndrome-Trellis Codes ---
+// Each payload bit is carried by `width` channel LSBs. The stego LSBs y
+// satisfy H y = m for a banded parity-check matrix H built from an h x width
+// submatrix; the Viterbi algorithm picks the y with the lowest total flip cost.
+// With uniform costs that is the fewest flips, and with a cost map the
+// flips land where they are least detectable.
+//
+// The trellis is cut into independent blocks of kStcBlockBytes payload bytes
+// starting at `firstChannel`, which is what lets blocks run in parallel.
+// Callers that split a payload across calls must split on block boundaries.
+namespace Steganography {
+
+const unsigned kStcHeight = 7; // Constraint height: 2^7 trellis states
+const unsigned kMinStcWidth = 2;
+const unsigned kMaxStcWidth = 16;
+const uint64_t kStcBlockBytes = 4096;
+const unsigned kStcPathBytes = (1u << kStcHeight) / 8; // Survivor bits per channel, one per state
+
+// Channels needed to carry `byteCount` payload bytes
+uint64_t stcChannels(uint64_t byteCount, unsigned width);
+
+// Payload bytes that fit in `channelCount` channels
+uint64_t stcCapacityBytes(uint64_t channelCount, unsigned width);
+
+// Embeds `byteCount` payload bytes in the channels starting at `firstChannel`
+// (a multiple of 8). `pixelCosts` is a per-pixel cost map of the whole
+// buffer (see CostMap.h) whose cost applies to every channel of the pixel,
+// or null for uniform costs. Extraction does not need the map.
+void stcEmbed(uint8_t* pixels, const ChannelOrder& order, uint64_t firstChannel, unsigned width,
+              const uint8_t* data, uint64_t byteCount, const float* pixelCosts = nullptr);
+
+void stcExtract(const uint8_t* pixels, const ChannelOrder& order, uint64_t firstChannel, unsigned width,
+                uint8_t* data, uint64_t byteCount);
+
+// --- Forward Pass Kernels ---
+// The Viterbi forward pass over one block: `lsbs` (bit-packed) and `costs`
+// (null for uniform) cover its bits * width channels, and `path` receives
+// kStcPathBytes survivor bits per channel. Every pass must record the same
+// survivors, ties included, or embeds would vary by CPU. `embed` is stcEmbed
+// run through that pass.
+typedef void (*StcForwardKernel)(const uint8_t* lsbs, const float* costs, unsigned width, const uint8_t* message,
+                                 uint64_t bits, uint8_t* path);
+typedef void (*StcEmbedKernel)(uint8_t* pixels, const ChannelOrder& order, uint64_t firstChannel, unsigned width,
+                               const uint8_t* data, uint64_t byteCount, const float* pixelCosts);
+
+struct StcVariant {
+    const char* name;
+    StcForwardKernel forward;
+    StcEmbedKernel embed;
+};
+
+// Every forward pass this CPU can run, scalar first
+std::vector<StcVariant> availableStcKernels();
+
+} // namespace Steganography
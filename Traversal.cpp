@@ -0,0 +1,322 @@
+#include "Traversal.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef STEG_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace Steganography {
+
+namespace {
+
+// Round function: a 32-bit integer hash of the half block and round key
+inline uint32_t roundFunction(uint32_t x, uint32_t key) {
+    uint32_t h = (x ^ key) * 0x9E3779B1u;
+    h ^= h >> 15;
+    h *= 0x85EBCA77u;
+    h ^= h >> 13;
+    return h;
+}
+
+inline uint64_t splitMix64(uint64_t& state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+// --- Batched Rounds ---
+void roundsScalar(uint32_t* low, uint32_t* high, unsigned n, const uint32_t* keys, unsigned rounds,
+                  uint32_t lowMask, uint32_t highMask) {
+    for (unsigned r = 0; r < rounds; r += 2) {
+        for (unsigned i = 0; i < n; ++i) low[i] ^= roundFunction(high[i], keys[r]) & lowMask;
+        for (unsigned i = 0; i < n; ++i) high[i] ^= roundFunction(low[i], keys[r + 1]) & highMask;
+    }
+}
+
+#ifdef STEG_X86_KERNELS
+
+STEG_TARGET("avx2")
+inline __m256i roundFunctionAvx2(__m256i x, __m256i key) {
+    __m256i h = _mm256_mullo_epi32(_mm256_xor_si256(x, key), _mm256_set1_epi32((int)0x9E3779B1u));
+    h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 15));
+    h = _mm256_mullo_epi32(h, _mm256_set1_epi32((int)0x85EBCA77u));
+    return _mm256_xor_si256(h, _mm256_srli_epi32(h, 13));
+}
+
+// 8 lanes per vector. Each round is a chain of dependent multiplies, so
+// four vectors are carried through the rounds together to overlap their
+// latency; leftover whole vectors go one at a time and the ragged end goes
+// through the scalar rounds.
+STEG_TARGET("avx2")
+void roundsAvx2(uint32_t* low, uint32_t* high, unsigned n, const uint32_t* keys, unsigned rounds,
+                uint32_t lowMask, uint32_t highMask) {
+    const unsigned kInterleave = 4;
+    const __m256i lowMaskV = _mm256_set1_epi32((int)lowMask);
+    const __m256i highMaskV = _mm256_set1_epi32((int)highMask);
+    unsigned i = 0;
+    for (; i + 8 * kInterleave <= n; i += 8 * kInterleave) {
+        __m256i l[kInterleave], h[kInterleave];
+        for (unsigned v = 0; v < kInterleave; ++v) {
+            l[v] = _mm256_loadu_si256((const __m256i*)(low + i + 8 * v));
+            h[v] = _mm256_loadu_si256((const __m256i*)(high + i + 8 * v));
+        }
+        for (unsigned r = 0; r < rounds; r += 2) {
+            __m256i lowKey = _mm256_set1_epi32((int)keys[r]);
+            __m256i highKey = _mm256_set1_epi32((int)keys[r + 1]);
+            for (unsigned v = 0; v < kInterleave; ++v) {
+                l[v] = _mm256_xor_si256(l[v], _mm256_and_si256(roundFunctionAvx2(h[v], lowKey), lowMaskV));
+            }
+            for (unsigned v = 0; v < kInterleave; ++v) {
+                h[v] = _mm256_xor_si256(h[v], _mm256_and_si256(roundFunctionAvx2(l[v], highKey), highMaskV));
+            }
+        }
+        for (unsigned v = 0; v < kInterleave; ++v) {
+            _mm256_storeu_si256((__m256i*)(low + i + 8 * v), l[v]);
+            _mm256_storeu_si256((__m256i*)(high + i + 8 * v), h[v]);
+        }
+    }
+    for (; i + 8 <= n; i += 8) {
+        __m256i l = _mm256_loadu_si256((const __m256i*)(low + i));
+        __m256i h = _mm256_loadu_si256((const __m256i*)(high + i));
+        for (unsigned r = 0; r < rounds; r += 2) {
+            __m256i f = roundFunctionAvx2(h, _mm256_set1_epi32((int)keys[r]));
+            l = _mm256_xor_si256(l, _mm256_and_si256(f, lowMaskV));
+            f = roundFunctionAvx2(l, _mm256_set1_epi32((int)keys[r + 1]));
+            h = _mm256_xor_si256(h, _mm256_and_si256(f, highMaskV));
+        }
+        _mm256_storeu_si256((__m256i*)(low + i), l);
+        _mm256_storeu_si256((__m256i*)(high + i), h);
+    }
+    roundsScalar(low + i, high + i, n - i, keys, rounds, lowMask, highMask);
+}
+
+#endif // STEG_X86_KERNELS
+
+// STEG_KERNEL=scalar pins the scalar rounds, like it does for the LSB kernels
+FeistelRoundsKernel roundsKernel() {
+    static const FeistelRoundsKernel chosen = [] {
+#ifdef STEG_X86_KERNELS
+        const char* pinned = std::getenv("STEG_KERNEL");
+        bool scalarOnly = pinned && std::strcmp(pinned, "scalar") == 0;
+        if (!scalarOnly && cpuSupports("avx2")) return (FeistelRoundsKernel)roundsAvx2;
+#endif
+        return (FeistelRoundsKernel)roundsScalar;
+    }();
+    return chosen;
+}
+
+} // namespace
+
+std::vector<RoundsVariant> availableRoundsKernels() {
+    std::vector<RoundsVariant> kernels = {{"scalar", roundsScalar}};
+#ifdef STEG_X86_KERNELS
+    if (cpuSupports("avx2")) kernels.push_back({"avx2", roundsAvx2});
+#endif
+    return kernels;
+}
+
+ChannelPermutation::ChannelPermutation(uint64_t channelCount, uint64_t key, uint64_t fixedChannels)
+    : count(channelCount), fixed(std::min(fixedChannels, channelCount)), permuted(count - fixed) {
+    unsigned bits = 2;
+    while (bits < 64 && (1ull << bits) < permuted) ++bits;
+    lowBits = bits / 2;
+    lowMask = (uint32_t)((1ull << lowBits) - 1);
+    highMask = (uint32_t)((1ull << (bits - lowBits)) - 1);
+
+    uint64_t state = key;
+    for (unsigned r = 0; r < kRounds; ++r) {
+        roundKeys[r] = (uint32_t)splitMix64(state);
+    }
+}
+
+// The halves are updated in place, low then high, which is the usual
+// swap-and-XOR Feistel round without the swap. Halves differ by at most one
+// bit when the domain has an odd bit count.
+uint64_t ChannelPermutation::encrypt(uint64_t x) const {
+    uint32_t low = (uint32_t)(x & lowMask);
+    uint32_t high = (uint32_t)(x >> lowBits);
+    for (unsigned r = 0; r < kRounds; r += 2) {
+        low ^= roundFunction(high, roundKeys[r]) & lowMask;
+        high ^= roundFunction(low, roundKeys[r + 1]) & highMask;
+    }
+    return low | ((uint64_t)high << lowBits);
+}
+
+uint64_t ChannelPermutation::operator()(uint64_t index) const {
+    if (index < fixed) return index;
+    uint64_t x = encrypt(index - fixed);
+    while (x >= permuted) x = encrypt(x); // Cycle-walk back into range
+    return fixed + x;
+}
+
+// Each pass runs the rounds over every lane still out of range, then
+// compacts the lanes that need another cycle-walk step to the front. With
+// at most half the domain out of range, the passes total under 2n lanes.
+void ChannelPermutation::map(uint64_t first, unsigned n, uint64_t* out) const {
+    map(first, n, out, roundsKernel());
+}
+
+void ChannelPermutation::map(uint64_t first, unsigned n, uint64_t* out, FeistelRoundsKernel rounds) const {
+    for (; n > 0 && first < fixed; --n) *out++ = first++;
+    first -= fixed;
+
+    uint32_t low[kBatch], high[kBatch];
+    uint16_t lane[kBatch];
+    for (unsigned i = 0; i < n; ++i) {
+        low[i] = (uint32_t)((first + i) & lowMask);
+        high[i] = (uint32_t)((first + i) >> lowBits);
+        lane[i] = (uint16_t)i;
+    }
+    for (unsigned pending = n; pending;) {
+        rounds(low, high, pending, roundKeys, kRounds, lowMask, highMask);
+        // Branch-free: whether a lane walks again is a coin flip, so every
+        // lane is written out and copied down, and only the walkers advance
+        // the write index. A walker's output is overwritten by a later pass.
+        unsigned walking = 0;
+        for (unsigned i = 0; i < pending; ++i) {
+            uint64_t x = low[i] | ((uint64_t)high[i] << lowBits);
+            out[lane[i]] = fixed + x;
+            low[walking] = low[i];
+            high[walking] = high[i];
+            lane[walking] = lane[i];
+            walking += x >= permuted;
+        }
+        pending = walking;
+    }
+}
+
+uint64_t traversalKey(const std::string& passphrase) {
+    uint64_t hash = 0xCBF29CE484222325ull; // FNV-1a
+    for (unsigned char c : passphrase) {
+        hash = (hash ^ c) * 0x100000001B3ull;
+    }
+    return splitMix64(hash);
+}
+
+void gatherLsbs(const uint8_t* pixels, const ChannelOrder& order, uint64_t firstChannel, uint64_t count, uint8_t* bits) {
+    if (!order.permutation) {
+        gatherLsbs(pixels, order.channels, firstChannel, count, bits);
+        return;
+    }
+
+    unsigned perPixel = channelsPerPixel(order.channels);
+    uint64_t positions[ChannelPermutation::kBatch];
+    for (uint64_t done = 0; done < count; done += ChannelPermutation::kBatch) {
+        unsigned n = (unsigned)std::min<uint64_t>(ChannelPermutation::kBatch, count - done);
+        order.permutation->map(firstChannel + done, n, positions);
+        for (unsigned i = 0; i < n; i += 8) {
+            uint8_t byte = 0;
+            for (unsigned j = 0; j < 8 && i + j < n; ++j) {
+                byte |= (uint8_t)((pixels[channelOffset(positions[i + j], perPixel)] & 1) << j);
+            }
+            bits[(done + i) / 8] = byte;
+        }
+    }
+}
+
+void gatherCosts(const float* pixelCosts, const ChannelOrder& order, uint64_t firstChannel, uint64_t count,
+                 float* costs) {
+    unsigned perPixel = channelsPerPixel(order.channels);
+    if (!order.permutation) {
+        for (uint64_t i = 0; i < count; ++i) {
+            uint64_t channel = firstChannel + i;
+            costs[i] = pixelCosts[perPixel == 3 ? channel / 3 : channel / 4];
+        }
+        return;
+    }
+
+    uint64_t positions[ChannelPermutation::kBatch];
+    for (uint64_t done = 0; done < count; done += ChannelPermutation::kBatch) {
+        unsigned n = (unsigned)std::min<uint64_t>(ChannelPermutation::kBatch, count - done);
+        order.permutation->map(firstChannel + done, n, positions);
+        for (unsigned i = 0; i < n; ++i) {
+            uint64_t channel = positions[i];
+            costs[done + i] = pixelCosts[perPixel == 3 ? channel / 3 : channel / 4];
+        }
+    }
+}
+
+// Stream channels are visited in batches: positions for a batch are
+// generated together, then each channel's bits are written or read.
+// With 1, 2 or 4 bits per channel a stream byte covers whole channels.
+void embedOrdered(uint8_t* pixels, const Layout& layout, const ChannelOrder& order, uint64_t streamOffset,
+                  const uint8_t* data, uint64_t byteCount) {
+    if (!order.permutation) {
+        embedFast(pixels, layout, streamOffset, data, byteCount);
+        return;
+    }
+
+    const unsigned bits = layout.bitsPerChannel;
+    const unsigned perPixel = channelsPerPixel(layout.channels);
+    const uint8_t valueMask = (uint8_t)((1u << bits) - 1);
+    const uint64_t firstChannel = streamOffset * 8 / bits;
+    const uint64_t channelCount = byteCount * 8 / bits;
+
+    uint64_t positions[ChannelPermutation::kBatch];
+    for (uint64_t done = 0; done < channelCount; done += ChannelPermutation::kBatch) {
+        unsigned n = (unsigned)std::min<uint64_t>(ChannelPermutation::kBatch, channelCount - done);
+        order.permutation->map(firstChannel + done, n, positions);
+        for (unsigned i = 0; i < n; ++i) {
+            uint64_t bit = (done + i) * bits;
+            uint8_t value = (uint8_t)((data[bit / 8] >> (bit % 8)) & valueMask);
+            uint8_t& channel = pixels[channelOffset(positions[i], perPixel)];
+            channel = (uint8_t)((channel & ~valueMask) | value);
+        }
+    }
+}
+
+void embedMatchingOrdered(uint8_t* pixels, const ChannelOrder& order, uint64_t streamOffset, const uint8_t* data,
+                          uint64_t byteCount, uint64_t key) {
+    if (!order.permutation) {
+        embedMatchingFast(pixels, order.channels, streamOffset, data, byteCount, key);
+        return;
+    }
+
+    const unsigned perPixel = channelsPerPixel(order.channels);
+    const uint64_t firstChannel = streamOffset * 8;
+    const uint64_t channelCount = byteCount * 8;
+
+    uint64_t positions[ChannelPermutation::kBatch];
+    for (uint64_t done = 0; done < channelCount; done += ChannelPermutation::kBatch) {
+        unsigned n = (unsigned)std::min<uint64_t>(ChannelPermutation::kBatch, channelCount - done);
+        order.permutation->map(firstChannel + done, n, positions);
+        for (unsigned i = 0; i < n; ++i) {
+            uint64_t bit = done + i;
+            uint64_t at = channelOffset(positions[i], perPixel);
+            uint32_t signs = matchingSigns(key, at >> 5);
+            pixels[at] = matchBit(pixels[at], (data[bit / 8] >> (bit % 8)) & 1, (signs >> (at & 31)) & 1);
+        }
+    }
+}
+
+void extractOrdered(const uint8_t* pixels, const Layout& layout, const ChannelOrder& order, uint64_t streamOffset,
+                    uint8_t* data, uint64_t byteCount) {
+    if (!order.permutation) {
+        extractFast(pixels, layout, streamOffset, data, byteCount);
+        return;
+    }
+
+    const unsigned bits = layout.bitsPerChannel;
+    const unsigned perPixel = channelsPerPixel(layout.channels);
+    const uint8_t valueMask = (uint8_t)((1u << bits) - 1);
+    const uint64_t firstChannel = streamOffset * 8 / bits;
+    const uint64_t channelCount = byteCount * 8 / bits;
+
+    std::memset(data, 0, (size_t)byteCount);
+    uint64_t positions[ChannelPermutation::kBatch];
+    for (uint64_t done = 0; done < channelCount; done += ChannelPermutation::kBatch) {
+        unsigned n = (unsigned)std::min<uint64_t>(ChannelPermutation::kBatch, channelCount - done);
+        order.permutation->map(firstChannel + done, n, positions);
+        for (unsigned i = 0; i < n; ++i) {
+            uint64_t bit = (done + i) * bits;
+            uint8_t value = pixels[channelOffset(positions[i], perPixel)] & valueMask;
+            data[bit / 8] |= (uint8_t)(value << (bit % 8));
+        }
+    }
+}
+
+} // namespace Steganography
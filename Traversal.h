@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Kernels.h"
+
+// --- Keyed Traversal ---
+// By default stream channel i is buffer channel i, so the payload sits in a
+// contiguous, easily located run of pixels from (0,0). A keyed traversal
+// scatters it: stream channel i goes to buffer channel P(i), where P is a
+// keyed bijection over [0, channelCount) computed on the fly, with no index
+// table.
+//
+// P is an alternating Feistel network over the smallest power-of-two domain
+// that holds channelCount, with cycle-walking for indices that land past the
+// end. The domain is less than twice channelCount, so a walk takes under two
+// steps on average.
+//
+// The first `fixedChannels` channels can be held in place, so a header at the
+// start of the buffer is never overwritten by the permuted channels; the rest
+// are permuted among themselves.
+namespace Steganography {
+
+// All Feistel rounds over `n` lanes of split indices (low and high halves),
+// in place. Every kernel must give the scalar rounds' results exactly.
+typedef void (*FeistelRoundsKernel)(uint32_t* low, uint32_t* high, unsigned n, const uint32_t* keys,
+                                    unsigned rounds, uint32_t lowMask, uint32_t highMask);
+
+struct RoundsVariant {
+    const char* name;
+    FeistelRoundsKernel rounds;
+};
+
+// Every Feistel rounds kernel this CPU can run, scalar first
+std::vector<RoundsVariant> availableRoundsKernels();
+
+class ChannelPermutation {
+public:
+    ChannelPermutation(uint64_t channelCount, uint64_t key, uint64_t fixedChannels = 0);
+
+    uint64_t size() const { return count; }
+
+    // Buffer channel of stream channel `index` (< size())
+    uint64_t operator()(uint64_t index) const;
+
+    // out[i] = (*this)(first + i) for i < n (<= kBatch). The Feistel rounds
+    // run over the whole batch in lockstep; the indices that land out of
+    // range are then compacted to the front and the rounds run again over
+    // just those, until every index has walked back into range.
+    static const unsigned kBatch = 256;
+    void map(uint64_t first, unsigned n, uint64_t* out) const;
+
+    // map() through the given rounds kernel rather than the fastest one
+    void map(uint64_t first, unsigned n, uint64_t* out, FeistelRoundsKernel rounds) const;
+
+private:
+    static const unsigned kRounds = 8;
+
+    uint64_t encrypt(uint64_t x) const;
+
+    uint64_t count;
+    uint64_t fixed;    // Leading channels mapped to themselves
+    uint64_t permuted; // count - fixed, the range the Feistel network covers
+    unsigned lowBits;  // Width of the low half, which holds the round input first
+    uint32_t lowMask;
+    uint32_t highMask;
+    uint32_t roundKeys[kRounds];
+};
+
+// 64-bit traversal key derived from a passphrase
+uint64_t traversalKey(const std::string& passphrase);
+
+// Where the channels of the stream live in an RGBA8 buffer: in order, or
+// permuted when a ChannelPermutation over the buffer's channels is given
+struct ChannelOrder {
+    ChannelOrder(ChannelLayout channels, const ChannelPermutation* permutation = nullptr)
+        : channels(channels), permutation(permutation) {}
+
+    ChannelLayout channels;
+    const ChannelPermutation* permutation;
+};
+
+// Buffer byte holding stream channel `channel`
+inline uint64_t channelByte(const ChannelOrder& order, uint64_t channel) {
+    if (order.permutation) channel = (*order.permutation)(channel);
+    return channelOffset(channel, order.channels == ChannelLayout::RGBA ? 4 : 3);
+}
+
+// Packs the LSBs of `count` stream channels starting at `firstChannel` (a
+// multiple of 8) into `bits`
+void gatherLsbs(const uint8_t* pixels, const ChannelOrder& order, uint64_t firstChannel, uint64_t count, uint8_t* bits);
+
+// Cost of each of `count` stream channels starting at `firstChannel`, taken
+// from a per-pixel cost map of the buffer
+void gatherCosts(const float* pixelCosts, const ChannelOrder& order, uint64_t firstChannel, uint64_t count,
+                 float* costs);
+
+// Embed/extract through the given order. Sequential orders go straight to
+// embedFast/extractFast.
+void embedOrdered(uint8_t* pixels, const Layout& layout, const ChannelOrder& order, uint64_t streamOffset,
+                  const uint8_t* data, uint64_t byteCount);
+void extractOrdered(const uint8_t* pixels, const Layout& layout, const ChannelOrder& order, uint64_t streamOffset,
+                    uint8_t* data, uint64_t byteCount);
+
+// LSB matching through the given order (1 bit per channel); the result
+// extracts with extractOrdered
+void embedMatchingOrdered(uint8_t* pixels, const ChannelOrder& order, uint64_t streamOffset, const uint8_t* data,
+                          uint64_t byteCount, uint64_t key);
+
+} // namespace Steganography
@@ -0,0 +1,283 @@
+// End-to-end encode -> decode harness over synthetic carriers.
+//
+// For every (pattern, size, format) configuration the harness writes a
+// deterministic carrier and payload, then runs the round trip in a child
+// process so that peak RSS is measured per configuration rather than for the
+// whole run. One CSV row is appended per configuration; with the same
+// arguments two runs produce the same inputs, so CSVs can be diffed between
+// releases.
+//
+// JPEG carriers round-trip through F5 into a .jpg stego file. Their payload
+// is sized from the non-zero AC coefficients F5 can use rather than from
+// pixel LSBs, so it is written per carrier; a carrier with too few of them
+// (a flat one) is skipped.
+//
+// Usage:
+//   e2e_bench [--out results.csv] [--workdir dir] [--sizes 1,12,50,200]
+//             [--patterns noise,gradient,flat] [--formats png,bmp,tga,jpg]
+//             [--fill 0.5]
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#define popen _popen
+#define pclose _pclose
+#else
+#include <sys/resource.h>
+#endif
+
+#include "JpegCarrier.h"
+#include "Steganography.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const char* kCsvHeader =
+    "pattern,megapixels,format,width,height,carrier_bytes,payload_bytes,"
+    "encode_ms,encode_load_ms,encode_process_ms,encode_save_ms,"
+    "decode_ms,decode_load_ms,decode_process_ms,decode_save_ms,"
+    "output_bytes,peak_rss_kb,roundtrip_ok";
+
+std::vector<std::string> split(const std::string& list) {
+    std::vector<std::string> items;
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (!item.empty()) items.push_back(item);
+    }
+    return items;
+}
+
+// Peak resident set size of this process in KiB
+uint64_t peakRssKb() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return counters.PeakWorkingSetSize / 1024;
+    }
+    return 0;
+#else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024; // Bytes on macOS
+#else
+    return usage.ru_maxrss;        // KiB on Linux
+#endif
+#endif
+}
+
+// 4:3 carrier with roughly `megapixels` million pixels
+sf::Vector2u dimensionsFor(double megapixels) {
+    unsigned width = (unsigned)std::lround(std::sqrt(megapixels * 1e6 * 4.0 / 3.0));
+    unsigned height = (unsigned)std::lround(megapixels * 1e6 / width);
+    return sf::Vector2u(width, height);
+}
+
+// Deterministic synthetic carrier: uniform noise, smooth photo-like
+// gradients with mild sensor noise, or a single flat color
+bool writeCarrier(const std::string& path, const std::string& pattern, sf::Vector2u size) {
+    std::vector<sf::Uint8> pixels((size_t)size.x * size.y * 4);
+    std::mt19937 rng(1234);
+
+    for (unsigned y = 0; y < size.y; ++y) {
+        for (unsigned x = 0; x < size.x; ++x) {
+            sf::Uint8* px = &pixels[((size_t)y * size.x + x) * 4];
+            if (pattern == "noise") {
+                uint32_t v = rng();
+                px[0] = (sf::Uint8)v;
+                px[1] = (sf::Uint8)(v >> 8);
+                px[2] = (sf::Uint8)(v >> 16);
+            } else if (pattern == "gradient") {
+                double fx = (double)x / size.x, fy = (double)y / size.y;
+                int grain = (int)(rng() % 9) - 4;
+                px[0] = (sf::Uint8)std::min(255.0, std::max(0.0, 255.0 * fx + grain));
+                px[1] = (sf::Uint8)std::min(255.0, std::max(0.0, 255.0 * fy + grain));
+                px[2] = (sf::Uint8)std::min(255.0, std::max(0.0, 127.5 + 100.0 * std::sin(6.0 * (fx + fy)) + grain));
+            } else {
+                px[0] = 90;
+                px[1] = 140;
+                px[2] = 200;
+            }
+            px[3] = 255;
+        }
+    }
+
+    sf::Image image;
+    image.create(size.x, size.y, pixels.data());
+    return image.saveToFile(path);
+}
+
+bool writePayload(const std::string& path, uint64_t bytes) {
+    std::ofstream file(path, std::ios::binary);
+    std::mt19937 rng(5678);
+    std::vector<char> block(1 << 20);
+    for (uint64_t written = 0; written < bytes; written += block.size()) {
+        for (auto& b : block) b = (char)rng();
+        file.write(block.data(), (std::streamsize)std::min<uint64_t>(block.size(), bytes - written));
+    }
+    return (bool)file;
+}
+
+// Payload bytes F5 can be counted on to fit in a JPEG carrier at k = 1: a
+// bit per non-zero AC coefficient, with the +-1s counted at half since they
+// can shrink to zero, less the 24-byte header
+uint64_t jpegCapacityBytes(const std::string& path) {
+    Steganography::JpegImage image;
+    if (!image.load(path)) return 0;
+    uint64_t halves = 0;
+    for (uint64_t i = 0; i < image.coefficientCount(); ++i) {
+        const int c = std::abs((int)image.data()[i]);
+        if ((i & 63) && c) halves += c == 1 ? 1 : 2;
+    }
+    return std::max<uint64_t>(halves / 16, 24) - 24;
+}
+
+bool sameContents(const std::string& a, const std::string& b) {
+    std::ifstream fa(a, std::ios::binary), fb(b, std::ios::binary);
+    std::istreambuf_iterator<char> ia(fa), ib(fb), end;
+    return std::equal(ia, end, ib, end);
+}
+
+// Child mode: one round trip, prints the timing part of the CSV row
+int runOne(const std::string& carrier, const std::string& payload, const std::string& stego, const std::string& decoded) {
+    Steganography::JobResult enc = Steganography::encode(carrier, payload, stego);
+    if (!enc.ok) {
+        std::cerr << enc.message << std::endl;
+        return 1;
+    }
+    Steganography::JobResult dec = Steganography::decode(stego, decoded);
+    bool ok = dec.ok && sameContents(payload, decoded);
+
+    printf("%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%llu,%llu,%d\n",
+           enc.timings.totalMs, enc.timings.loadMs, enc.timings.processMs, enc.timings.saveMs,
+           dec.timings.totalMs, dec.timings.loadMs, dec.timings.processMs, dec.timings.saveMs,
+           (unsigned long long)enc.bytesWritten, (unsigned long long)peakRssKb(), ok ? 1 : 0);
+    return ok ? 0 : 1;
+}
+
+std::string shellQuote(const std::string& s) {
+    return "\"" + s + "\"";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string outPath = "e2e_results.csv";
+    std::string workdir = "e2e_work";
+    std::vector<std::string> sizes = {"1", "12", "50", "200"};
+    std::vector<std::string> patterns = {"noise", "gradient", "flat"};
+    std::vector<std::string> formats = {"png", "bmp", "tga", "jpg"};
+    double fill = 0.5;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--one" && i + 4 < argc) {
+            return runOne(argv[i + 1], argv[i + 2], argv[i + 3], argv[i + 4]);
+        } else if (i + 1 >= argc) {
+            std::cerr << "Missing value for " << arg << std::endl;
+            return 2;
+        } else if (arg == "--out") {
+            outPath = argv[++i];
+        } else if (arg == "--workdir") {
+            workdir = argv[++i];
+        } else if (arg == "--sizes") {
+            sizes = split(argv[++i]);
+        } else if (arg == "--patterns") {
+            patterns = split(argv[++i]);
+        } else if (arg == "--formats") {
+            formats = split(argv[++i]);
+        } else if (arg == "--fill") {
+            fill = std::atof(argv[++i]);
+        } else {
+            std::cerr << "Unknown argument: " << arg << std::endl;
+            return 2;
+        }
+    }
+
+    fs::create_directories(workdir);
+    std::ofstream csv(outPath);
+    csv << kCsvHeader << "\n";
+
+    int failures = 0;
+    for (const std::string& mp : sizes) {
+        sf::Vector2u size = dimensionsFor(std::atof(mp.c_str()));
+        uint64_t capacityBytes = Steganography::capacityBits((uint64_t)size.x * size.y, Steganography::Layout()) / 8;
+        uint64_t payloadBytes = (uint64_t)(capacityBytes * fill);
+        payloadBytes = std::min<uint64_t>(payloadBytes, capacityBytes - 64); // Room for the header pixels
+        payloadBytes = std::min<uint64_t>(payloadBytes, UINT32_MAX);
+
+        std::string payload = (fs::path(workdir) / ("payload_" + mp + ".bin")).string();
+        writePayload(payload, payloadBytes);
+
+        for (const std::string& pattern : patterns) {
+            for (const std::string& format : formats) {
+                std::string stem = pattern + "_" + mp + "mp";
+                std::string carrier = (fs::path(workdir) / (stem + "." + format)).string();
+                // A JPEG carrier stays a JPEG: F5 writes the stego file as one
+                std::string stego = (fs::path(workdir) / (stem + "_stego." + format)).string();
+                std::string decoded = (fs::path(workdir) / (stem + "_decoded.bin")).string();
+
+                std::cerr << "[" << pattern << " " << mp << " MP " << format << "] " << std::flush;
+                if (!writeCarrier(carrier, pattern, size)) {
+                    std::cerr << "could not write carrier" << std::endl;
+                    failures++;
+                    continue;
+                }
+
+                std::string formatPayload = payload;
+                uint64_t formatBytes = payloadBytes;
+                if (format == "jpg") {
+                    formatBytes = (uint64_t)(jpegCapacityBytes(carrier) * fill);
+                    if (formatBytes == 0) {
+                        std::cerr << "skipped (no F5 capacity)" << std::endl;
+                        std::error_code ec;
+                        fs::remove(carrier, ec);
+                        continue;
+                    }
+                    formatPayload = (fs::path(workdir) / (stem + "_payload.bin")).string();
+                    writePayload(formatPayload, formatBytes);
+                }
+
+                std::string command = shellQuote(argv[0]) + " --one " + shellQuote(carrier) + " " +
+                                      shellQuote(formatPayload) + " " + shellQuote(stego) + " " + shellQuote(decoded);
+                char line[512] = "";
+                FILE* child = popen(command.c_str(), "r");
+                bool gotLine = child && fgets(line, sizeof(line), child) != nullptr;
+                int status = child ? pclose(child) : -1;
+
+                std::string measurements = gotLine ? std::string(line) : std::string(",,,,,,,,,,0\n");
+                if (!gotLine || status != 0) failures++;
+                csv << pattern << "," << mp << "," << format << "," << size.x << "," << size.y << ","
+                    << fs::file_size(carrier) << "," << formatBytes << "," << measurements;
+                csv.flush();
+                std::cerr << (gotLine && status == 0 ? "ok" : "FAILED") << std::endl;
+
+                std::error_code ec;
+                fs::remove(carrier, ec);
+                fs::remove(stego, ec);
+                fs::remove(decoded, ec);
+                if (formatPayload != payload) fs::remove(formatPayload, ec);
+            }
+        }
+        std::error_code ec;
+        fs::remove(payload, ec);
+    }
+
+    std::cerr << "Results written to " << outPath << std::endl;
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,392 @@
+// End-to-end checks of the engine logic that sits above the kernels, which
+// kernel_verify covers.
+//
+// Sealing: a payload of several segments is sealed and must open back to
+// itself, and must fail authentication after a flipped ciphertext byte, a
+// dropped or truncated final segment, two swapped segments, or with the
+// wrong passphrase.
+//
+// Updates: random carriers are encoded with a random payload under plain,
+// Hamming and trellis embedding, sequential or keyed, with and without chunk
+// CRCs, as PNG or as a BMP updated in place, and then appended to and
+// patched at random, patches running past the end included. After every
+// update the payload must decode to a model of what it should hold, whole
+// and over a random byte range. The run fails if the trials never covered
+// one of those cases, a CRC table growth (which re-embeds the whole stream)
+// or a BMP rewritten row by row.
+//
+// Shards: a payload is split with parity over random carriers with chunk
+// CRCs. With m parity images, dropping m - 1 of the set and flipping a
+// payload bit in one more (which must then fail its CRC) has to rebuild the
+// payload byte for byte, whatever order the images come in; losing one
+// more image has to fail.
+//
+// Usage: engine_verify [--trials N] [--seed S]
+// Exits non-zero on the first failure, printing the failing case.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Encryption.h"
+#include "Steganography.h"
+#include "SyndromeTrellis.h"
+
+using namespace Steganography;
+namespace fs = std::filesystem;
+
+namespace {
+
+std::vector<char> randomBytes(std::mt19937& rng, uint64_t size) {
+    std::vector<char> bytes(size);
+    for (auto& b : bytes) b = (char)rng();
+    return bytes;
+}
+
+// Seals 3.5 segments, then opens the sealed bytes as they are and after each
+// kind of damage
+bool checkSealing(std::mt19937& rng, uint32_t seed) {
+    const std::string passphrase = "correct horse battery staple";
+    const uint64_t plainBytes = 3 * kSealSegmentBytes + kSealSegmentBytes / 2;
+    const std::vector<char> plain = randomBytes(rng, plainBytes);
+    std::vector<char> sealed;
+    std::string failed = seal(passphrase, plain.data(), plain.size(), sealed);
+    if (!failed.empty()) {
+        printf("FAILED sealing seed=%u: %s\n", seed, failed.c_str());
+        return false;
+    }
+    std::vector<char> opened;
+    failed = open(passphrase, sealed.data(), sealed.size(), opened);
+    if (!failed.empty() || opened != plain) {
+        printf("FAILED sealing seed=%u: an untouched payload did not open to the original (%s)\n", seed,
+               failed.c_str());
+        return false;
+    }
+
+    // Sealed segment s (tag included) starts here
+    const uint64_t stride = sealedSize(kSealSegmentBytes) - kSealHeaderBytes;
+    auto segmentAt = [&](uint64_t s) { return kSealHeaderBytes + s * stride; };
+
+    struct Damage {
+        const char* name;
+        std::vector<char> sealed;
+        std::string passphrase;
+    };
+    std::vector<Damage> cases;
+
+    std::vector<char> flipped = sealed;
+    flipped[kSealHeaderBytes + rng() % (sealed.size() - kSealHeaderBytes)] ^= (char)(1 << (rng() % 8));
+    cases.push_back({"flipped ciphertext byte", flipped, passphrase});
+
+    cases.push_back({"dropped final segment",
+                     std::vector<char>(sealed.begin(), sealed.begin() + (ptrdiff_t)segmentAt(3)), passphrase});
+    cases.push_back({"truncated final segment", std::vector<char>(sealed.begin(), sealed.end() - 100), passphrase});
+
+    std::vector<char> swapped = sealed;
+    std::swap_ranges(swapped.begin() + (ptrdiff_t)segmentAt(0), swapped.begin() + (ptrdiff_t)segmentAt(1),
+                     swapped.begin() + (ptrdiff_t)segmentAt(1));
+    cases.push_back({"swapped segments", swapped, passphrase});
+
+    cases.push_back({"wrong passphrase", sealed, passphrase + "!"});
+
+    for (const Damage& damage : cases) {
+        failed = open(damage.passphrase, damage.sealed.data(), damage.sealed.size(), opened);
+        if (failed.empty()) {
+            printf("FAILED sealing seed=%u: a payload with a %s opened\n", seed, damage.name);
+            return false;
+        }
+    }
+    printf("sealing: untouched payload opens; %zu kinds of damage rejected\n", cases.size());
+    return true;
+}
+
+bool writeFile(const std::string& path, const char* bytes, uint64_t size) {
+    std::ofstream file(path, std::ios::binary);
+    file.write(bytes, (std::streamsize)size);
+    return (bool)file;
+}
+
+std::vector<char> readFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+// Payload bytes per re-embedded chunk, as the engine cuts them
+uint64_t updateChunkBytes(const Options& options) {
+    if (options.mode == EmbedMode::Hamming) return options.hammingK * (kChunkBytes / 8);
+    if (options.mode == EmbedMode::Stc) return 4 * kStcBlockBytes;
+    return kChunkBytes;
+}
+
+// Cases the update trials must have run into at least once
+struct UpdateCoverage {
+    unsigned plain = 0, hamming = 0, stc = 0, keyed = 0, crc = 0;
+    unsigned growing = 0, multiChunk = 0, crcGrowth = 0, bmpRows = 0;
+};
+
+// One trial: encodes a random carrier, then updates it a few times and
+// checks each result against `model`, the bytes the payload should hold
+bool checkUpdateTrial(std::mt19937& rng, uint32_t seed, unsigned trial, const fs::path& workdir,
+                      UpdateCoverage& coverage) {
+    Options options;
+    const unsigned pick = rng() % 3;
+    options.mode = pick == 0 ? EmbedMode::Replace : pick == 1 ? EmbedMode::Hamming : EmbedMode::Stc;
+    if (options.mode == EmbedMode::Replace) options.layout.bitsPerChannel = 1u << (rng() % 3);
+    options.hammingK = 2 + rng() % 3;
+    options.stcWidth = 2 + rng() % 3;
+    if (rng() % 3 == 0) {
+        options.traversal = TraversalMode::Keyed;
+        options.key = "key " + std::to_string(trial);
+    }
+    options.chunkCrcs = rng() % 2 == 0;
+    const bool bmp = rng() % 2 == 0;
+    // BMPs are saved without alpha, so only a PNG can carry payload in it
+    if (!bmp && rng() % 4 == 0) options.layout.channels = ChannelLayout::RGBA;
+
+    // Half the payloads end just short of a chunk, in a carrier tall enough
+    // for more, so appends cross into the next chunk and grow the CRC table
+    const uint64_t chunk = updateChunkBytes(options);
+    const bool crossing = rng() % 2 == 0;
+    const unsigned width = 64 + rng() % 257;
+    unsigned height = 64 + rng() % 257;
+    while (crossing && capacityFor((uint64_t)width * height, options) < chunk + chunk / 2) height += 64;
+    const uint64_t capacity = capacityFor((uint64_t)width * height, options);
+    if (capacity < 64) return true;
+
+    std::vector<uint8_t> pixels((size_t)width * height * 4);
+    for (auto& p : pixels) p = (uint8_t)rng();
+    const std::string extension = bmp ? ".bmp" : ".png";
+    const std::string carrierPath = (workdir / ("carrier" + extension)).string();
+    const std::string secretPath = (workdir / "secret.bin").string();
+    const std::string decodedPath = (workdir / "decoded.bin").string();
+    std::string stegoPath = (workdir / ("stego" + extension)).string();
+    sf::Image carrier;
+    carrier.create(width, height, pixels.data());
+    const uint64_t initialBytes = crossing ? chunk - rng() % 256 : 1 + rng() % (capacity / 2);
+    std::vector<char> model = randomBytes(rng, initialBytes);
+    if (!carrier.saveToFile(carrierPath) || !writeFile(secretPath, model.data(), model.size())) {
+        printf("FAILED updates trial=%u seed=%u: could not write the inputs\n", trial, seed);
+        return false;
+    }
+
+    auto describe = [&]() {
+        return std::string(pick == 0 ? "plain" : pick == 1 ? "hamming" : "stc") +
+               " bits=" + std::to_string(options.layout.bitsPerChannel) + " k=" + std::to_string(options.hammingK) +
+               " width=" + std::to_string(options.stcWidth) + (options.key.empty() ? "" : " keyed") +
+               (options.chunkCrcs ? " crc" : "") + (options.layout.channels == ChannelLayout::RGBA ? " rgba" : "") +
+               " " + std::to_string(width) + "x" + std::to_string(height) + extension;
+    };
+    JobResult job = encode(carrierPath, secretPath, stegoPath, options);
+    if (!job.ok) {
+        printf("FAILED updates trial=%u seed=%u %s: encode: %s\n", trial, seed, describe().c_str(),
+               job.message.c_str());
+        return false;
+    }
+    coverage.plain += pick == 0;
+    coverage.hamming += pick == 1;
+    coverage.stc += pick == 2;
+    coverage.keyed += !options.key.empty();
+    coverage.crc += options.chunkCrcs;
+
+    for (unsigned step = 0; step < 4 && model.size() < capacity; ++step) {
+        // Appends, patches inside the payload, and patches that run past its end
+        const unsigned kind = rng() % 3;
+        const uint64_t room = capacity - model.size();
+        const uint64_t offset = kind == 0 ? model.size() : rng() % (model.size() + 1);
+        const uint64_t limit = kind == 2 ? model.size() - offset + room : kind == 1 ? model.size() - offset : room;
+        if (limit == 0) continue;
+        // Mostly small patches, now and then one spanning several chunks
+        const uint64_t span = rng() % 4 == 0 ? limit : std::min<uint64_t>(limit, 1 + rng() % 2048);
+        const std::vector<char> patch = randomBytes(rng, 1 + rng() % span);
+        if (!writeFile(secretPath, patch.data(), patch.size())) return false;
+
+        const uint64_t oldChunks = (model.size() + chunk - 1) / chunk;
+        const uint64_t end = offset + patch.size();
+        coverage.growing += kind != 0 && end > model.size();
+        if (end > model.size()) model.resize(end);
+        std::copy(patch.begin(), patch.end(), model.begin() + (ptrdiff_t)offset);
+        coverage.multiChunk += (end - 1) / chunk > offset / chunk;
+        const bool crcGrowth = options.chunkCrcs && (model.size() + chunk - 1) / chunk > oldChunks;
+        coverage.crcGrowth += crcGrowth;
+
+        // A BMP is updated in place; a PNG goes to the other of two files
+        const std::string outputPath =
+            bmp ? stegoPath : (workdir / (step % 2 ? "stego.png" : "updated.png")).string();
+        job = kind == 0 ? appendPayload(stegoPath, secretPath, outputPath, options)
+                        : patchPayload(stegoPath, secretPath, offset, outputPath, options);
+        if (!job.ok) {
+            printf("FAILED updates trial=%u seed=%u step=%u %s: %s at %llu+%zu of %zu: %s\n", trial, seed, step,
+                   describe().c_str(), kind == 0 ? "append" : "patch", (unsigned long long)offset, patch.size(),
+                   model.size(), job.message.c_str());
+            return false;
+        }
+        if (bmp && job.bytesWritten < fs::file_size(stegoPath)) ++coverage.bmpRows;
+        stegoPath = outputPath;
+
+        job = decode(stegoPath, decodedPath, options);
+        if (!job.ok || readFile(decodedPath) != model) {
+            printf("FAILED updates trial=%u seed=%u step=%u %s: %s at %llu+%zu left %zu bytes that do not decode "
+                   "to the model (%s)\n",
+                   trial, seed, step, describe().c_str(), kind == 0 ? "append" : "patch", (unsigned long long)offset,
+                   patch.size(), model.size(), job.message.c_str());
+            return false;
+        }
+        const uint64_t rangeBegin = rng() % model.size();
+        const uint64_t rangeLength = 1 + rng() % (model.size() - rangeBegin);
+        job = decodeRange(stegoPath, rangeBegin, rangeLength, decodedPath, options);
+        if (!job.ok || readFile(decodedPath) != std::vector<char>(model.begin() + (ptrdiff_t)rangeBegin,
+                                                                   model.begin() + (ptrdiff_t)(rangeBegin + rangeLength))) {
+            printf("FAILED updates trial=%u seed=%u step=%u %s: range %llu+%llu of %zu (%s)\n", trial, seed, step,
+                   describe().c_str(), (unsigned long long)rangeBegin, (unsigned long long)rangeLength,
+                   model.size(), job.message.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+bool checkUpdates(std::mt19937& rng, uint32_t seed, unsigned trials) {
+    const fs::path workdir = fs::temp_directory_path() / ("engine_verify_" + std::to_string(seed));
+    std::error_code ec;
+    fs::create_directories(workdir, ec);
+    UpdateCoverage coverage;
+    bool ok = true;
+    for (unsigned trial = 0; trial < trials && ok; ++trial) {
+        ok = checkUpdateTrial(rng, seed, trial, workdir, coverage);
+    }
+    fs::remove_all(workdir, ec);
+    if (!ok) return false;
+
+    const std::pair<const char*, unsigned> cases[] = {
+        {"plain", coverage.plain},         {"hamming", coverage.hamming},
+        {"stc", coverage.stc},             {"keyed", coverage.keyed},
+        {"crc", coverage.crc},             {"growing patch", coverage.growing},
+        {"multi-chunk", coverage.multiChunk}, {"crc table growth", coverage.crcGrowth},
+        {"bmp row rewrite", coverage.bmpRows}};
+    for (const auto& c : cases) {
+        printf("updates: %-16s %u\n", c.first, c.second);
+        if (trials >= 100 && c.second == 0) {
+            printf("FAILED updates seed=%u: no trial covered %s\n", seed, c.first);
+            return false;
+        }
+    }
+    return true;
+}
+
+// One trial: shards a payload with parity, loses as many images as the
+// parity makes up for, one of them to a CRC failure, and gathers the rest
+bool checkShardTrial(std::mt19937& rng, uint32_t seed, unsigned trial, const fs::path& workdir) {
+    Options options;
+    options.chunkCrcs = true;
+    const unsigned images = 4 + rng() % 4;
+    options.parityShards = 2 + rng() % 2;
+
+    std::vector<std::string> carrierPaths(images), stegoPaths(images);
+    std::vector<sf::Vector2u> sizes(images);
+    uint64_t smallest = UINT64_MAX;
+    for (unsigned i = 0; i < images; ++i) {
+        sizes[i] = sf::Vector2u(96 + rng() % 161, 96 + rng() % 161);
+        std::vector<uint8_t> pixels((size_t)sizes[i].x * sizes[i].y * 4);
+        for (auto& p : pixels) p = (uint8_t)rng();
+        sf::Image carrier;
+        carrier.create(sizes[i].x, sizes[i].y, pixels.data());
+        carrierPaths[i] = (workdir / ("carrier" + std::to_string(i) + ".png")).string();
+        stegoPaths[i] = (workdir / ("shard" + std::to_string(i) + ".png")).string();
+        if (!carrier.saveToFile(carrierPaths[i])) return false;
+        smallest = std::min(smallest, capacityFor((uint64_t)sizes[i].x * sizes[i].y, options));
+    }
+    // Each data shard takes an equal slice of at least 1 KiB, leaving room
+    // for the shard record
+    const uint64_t dataShards = images - options.parityShards;
+    const uint64_t least = 1024 * dataShards;
+    const std::vector<char> payload = randomBytes(rng, least + rng() % (smallest * 4 / 5 * dataShards - least));
+    const std::string secretPath = (workdir / "secret.bin").string();
+    const std::string decodedPath = (workdir / "decoded.bin").string();
+    if (!writeFile(secretPath, payload.data(), payload.size())) return false;
+
+    const std::string config = std::to_string(images) + " images, parity " + std::to_string(options.parityShards) +
+                               ", " + std::to_string(payload.size()) + " bytes";
+    JobResult job = encodeShards(carrierPaths, secretPath, stegoPaths, options);
+    if (!job.ok) {
+        printf("FAILED shards trial=%u seed=%u %s: encode: %s\n", trial, seed, config.c_str(), job.message.c_str());
+        return false;
+    }
+
+    // Drop parity - 1 images, then flip a bit in the middle of the payload
+    // of another, past its header and CRC table
+    std::vector<std::string> kept = stegoPaths;
+    std::shuffle(kept.begin(), kept.end(), rng);
+    kept.resize(images - (options.parityShards - 1));
+    const std::string damaged = kept[rng() % kept.size()];
+    sf::Image image;
+    if (!image.loadFromFile(damaged)) return false;
+    const uint64_t slice = (payload.size() + dataShards - 1) / dataShards;
+    const uint64_t pixel = 512 + slice * 8 / 3 / 2;
+    const sf::Vector2u size = image.getSize();
+    const sf::Color color = image.getPixel((unsigned)(pixel % size.x), (unsigned)(pixel / size.x));
+    image.setPixel((unsigned)(pixel % size.x), (unsigned)(pixel / size.x),
+                   sf::Color(color.r ^ 1, color.g, color.b, color.a));
+    if (!image.saveToFile(damaged)) return false;
+
+    job = decodeShards({damaged}, decodedPath);
+    if (job.ok || job.message.find("checksum") == std::string::npos) {
+        printf("FAILED shards trial=%u seed=%u %s: the damaged image did not fail its CRC (%s)\n", trial, seed,
+               config.c_str(), job.message.c_str());
+        return false;
+    }
+    job = decodeShards(kept, decodedPath);
+    if (!job.ok || readFile(decodedPath) != payload) {
+        printf("FAILED shards trial=%u seed=%u %s: %zu images with one damaged did not rebuild the payload (%s)\n",
+               trial, seed, config.c_str(), kept.size(), job.message.c_str());
+        return false;
+    }
+
+    // One image more than the parity covers
+    kept.erase(std::find(kept.begin(), kept.end(), damaged) == kept.begin() ? kept.begin() + 1 : kept.begin());
+    job = decodeShards(kept, decodedPath);
+    if (job.ok) {
+        printf("FAILED shards trial=%u seed=%u %s: a set missing more than its parity decoded\n", trial, seed,
+               config.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool checkShards(std::mt19937& rng, uint32_t seed, unsigned trials) {
+    const fs::path workdir = fs::temp_directory_path() / ("engine_verify_" + std::to_string(seed));
+    std::error_code ec;
+    fs::create_directories(workdir, ec);
+    bool ok = true;
+    for (unsigned trial = 0; trial < trials && ok; ++trial) {
+        ok = checkShardTrial(rng, seed, trial, workdir);
+    }
+    fs::remove_all(workdir, ec);
+    if (ok) printf("shards: %u sets rebuilt past a CRC failure and m - 1 lost images\n", trials);
+    return ok;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    unsigned trials = 300;
+    uint32_t seed = 12345;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        if (arg == "--trials") trials = (unsigned)std::strtoul(argv[i + 1], nullptr, 10);
+        else if (arg == "--seed") seed = (uint32_t)std::strtoul(argv[i + 1], nullptr, 10);
+    }
+    std::mt19937 rng(seed);
+
+    if (!checkSealing(rng, seed)) return 1;
+    if (!checkUpdates(rng, seed, trials)) return 1;
+    if (!checkShards(rng, seed, std::max(trials / 10, 1u))) return 1;
+    return 0;
+}
@@ -0,0 +1,388 @@
+// Microbenchmarks for the embed/extract kernels.
+//
+// Every kernel (reference, scalar, each SIMD variant the CPU supports and the
+// threaded wrapper) is measured over payload sizes from 1 KB to 1 GB, for each
+// channel layout and each bit depth. Throughput is reported by Google
+// Benchmark as bytes/second of payload; the "cycles/B" counter is TSC ticks
+// per payload byte where the CPU provides a TSC.
+//
+// Large payloads need large carriers (1 GB at 1 bit/channel RGB is an 11 GB
+// pixel buffer), so configurations whose buffer would exceed
+// STEG_BENCH_MAX_BUFFER bytes (default 2 GiB) are skipped.
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "Kernels.h"
+#include "Checksum.h"
+#include "CostMap.h"
+#include "ErasureCode.h"
+#include "MatrixEmbedding.h"
+#include "SyndromeTrellis.h"
+#include "Traversal.h"
+
+using namespace Steganography;
+
+namespace {
+
+// The reference path costs a getPixel/setPixel per bit; past this size it
+// only measures how long we are willing to wait.
+const int64_t kReferenceMaxBytes = 16 << 20;
+
+uint64_t readCycles() {
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+uint64_t maxBufferBytes() {
+    const char* env = std::getenv("STEG_BENCH_MAX_BUFFER");
+    return env ? std::strtoull(env, nullptr, 10) : (2ull << 30);
+}
+
+Layout layoutFor(const benchmark::State& state) {
+    Layout layout;
+    layout.channels = state.range(1) ? ChannelLayout::RGBA : ChannelLayout::RGB;
+    layout.bitsPerChannel = (unsigned)state.range(2);
+    return layout;
+}
+
+// Square-ish carrier just large enough for `bytes` of payload
+sf::Vector2u carrierSizeFor(uint64_t bytes, const Layout& layout) {
+    uint64_t pixels = pixelsForBytes(bytes, layout);
+    unsigned width = 4096;
+    unsigned height = (unsigned)((pixels + width - 1) / width);
+    return sf::Vector2u(width, height);
+}
+
+std::vector<uint8_t> randomBytes(uint64_t count, uint32_t seed) {
+    std::vector<uint8_t> bytes(count);
+    std::mt19937 rng(seed);
+    for (auto& b : bytes) b = (uint8_t)rng();
+    return bytes;
+}
+
+void setCounters(benchmark::State& state, uint64_t cycles) {
+    uint64_t bytes = (uint64_t)state.iterations() * state.range(0);
+    state.SetBytesProcessed((int64_t)bytes);
+    if (cycles) {
+        state.counters["cycles/B"] = (double)cycles / (double)bytes;
+    }
+}
+
+// Returns false (and marks the run skipped) if the carrier is too large
+bool fitsInMemory(benchmark::State& state, const sf::Vector2u& size) {
+    if ((uint64_t)size.x * size.y * 4 > maxBufferBytes()) {
+        state.SkipWithError("carrier buffer exceeds STEG_BENCH_MAX_BUFFER");
+        return false;
+    }
+    return true;
+}
+
+void BM_EmbedReference(benchmark::State& state) {
+    Layout layout = layoutFor(state);
+    sf::Vector2u size = carrierSizeFor(state.range(0), layout);
+    sf::Image image;
+    image.create(size.x, size.y, sf::Color(120, 80, 200));
+    std::vector<uint8_t> payload = randomBytes(state.range(0), 1);
+
+    uint64_t start = readCycles();
+    for (auto _ : state) {
+        embedReference(image, layout, 0, payload.data(), payload.size());
+        benchmark::ClobberMemory();
+    }
+    setCounters(state, readCycles() - start);
+}
+
+void BM_ExtractReference(benchmark::State& state) {
+    Layout layout = layoutFor(state);
+    sf::Vector2u size = carrierSizeFor(state.range(0), layout);
+    sf::Image image;
+    image.create(size.x, size.y, sf::Color(120, 80, 200));
+    std::vector<uint8_t> payload(state.range(0));
+
+    uint64_t start = readCycles();
+    for (auto _ : state) {
+        extractReference(image, layout, 0, payload.data(), payload.size());
+        benchmark::DoNotOptimize(payload.data());
+    }
+    setCounters(state, readCycles() - start);
+}
+
+void BM_EmbedBuffer(benchmark::State& state, EmbedKernel kernel) {
+    Layout layout = layoutFor(state);
+    sf::Vector2u size = carrierSizeFor(state.range(0), layout);
+    if (!fitsInMemory(state, size)) return;
+    std::vector<uint8_t> pixels((size_t)size.x * size.y * 4, 0x5A);
+    std::vector<uint8_t> payload = randomBytes(state.range(0), 1);
+
+    uint64_t start = readCycles();
+    for (auto _ : state) {
+        kernel(pixels.data(), layout, 0, payload.data(), payload.size());
+        benchmark::ClobberMemory();
+    }
+    setCounters(state, readCycles() - start);
+}
+
+void BM_EmbedMatching(benchmark::State& state, MatchingKernel kernel) {
+    Layout layout = layoutFor(state);
+    sf::Vector2u size = carrierSizeFor(state.range(0), layout);
+    if (!fitsInMemory(state, size)) return;
+    std::vector<uint8_t> pixels = randomBytes((size_t)size.x * size.y * 4, 2);
+    std::vector<uint8_t> payload = randomBytes(state.range(0), 1);
+
+    uint64_t start = readCycles();
+    for (auto _ : state) {
+        kernel(pixels.data(), layout.channels, 0, payload.data(), payload.size(), 0x5EED);
+        benchmark::ClobberMemory();
+    }
+    setCounters(state, readCycles() - start);
+}
+
+void BM_ExtractBuffer(benchmark::State& state, ExtractKernel kernel) {
+    Layout layout = layoutFor(state);
+    sf::Vector2u size = carrierSizeFor(state.range(0), layout);
+    if (!fitsInMemory(state, size)) return;
+    std::vector<uint8_t> pixels = randomBytes((size_t)size.x * size.y * 4, 2);
+    std::vector<uint8_t> payload(state.range(0));
+
+    uint64_t start = readCycles();
+    for (auto _ : state) {
+        kernel(pixels.data(), layout, 0, payload.data(), payload.size());
+        benchmark::DoNotOptimize(payload.data());
+    }
+    setCounters(state, readCycles() - start);
+}
+
+// Matrix embedding: payload size x layout x k
+void BM_HammingEmbed(benchmark::State& state) {
+    ChannelLayout channels = state.range(1) ? ChannelLayout::RGBA : ChannelLayout::RGB;
+    unsigned k = (unsigned)state.range(2);
+    uint64_t pixelCount = hammingChannels(state.range(0), k) / channelsPerPixel(channels) + 1;
+    sf::Vector2u size(4096, (unsigned)((pixelCount + 4095) / 4096));
+    if (!fitsInMemory(state, size)) return;
+    std::vector<uint8_t> pixels = randomBytes((size_t)size.x * size.y * 4, 2);
+    std::vector<uint8_t> payload = randomBytes(state.range(0), 1);
+
+    uint64_t start = readCycles();
+    for (auto _ : state) {
+        hammingEmbed(pixels.data(), channels, 0, k, payload.data(), payload.size());
+        benchmark::ClobberMemory();
+    }
+    setCounters(state, readCycles() - start);
+}
+
+void BM_HammingExtract(benchmark::State& state) {
+    ChannelLayout channels = state.range(1) ? ChannelLayout::RGBA : ChannelLayout::RGB;
+    unsigned k = (unsigned)state.range(2);
+    uint64_t pixelCount = hammingChannels(state.range(0), k) / channelsPerPixel(channels) + 1;
+    sf::Vector2u size(4096, (unsigned)((pixelCount + 4095) / 4096));
+    if (!fitsInMemory(state, size)) return;
+    std::vector<uint8_t> pixels = randomBytes((size_t)size.x * size.y * 4, 2);
+    std::vector<uint8_t> payload(state.range(0));
+
+    uint64_t start = readCycles();
+    for (auto _ : state) {
+        hammingExtract(pixels.data(), channels, 0, k, payload.data(), payload.size());
+        benchmark::DoNotOptimize(payload.data());
+    }
+    setCounters(state, readCycles() - start);
+}
+
+void hammingArgs(benchmark::internal::Benchmark* b) {
+    b->ArgsProduct({{1 << 10, 1 << 15, 1 << 20, 1 << 25}, {0, 1}, {2, 3, 4, 6}})
+        ->ArgNames({"bytes", "rgba", "k"})
+        ->Unit(benchmark::kMicrosecond);
+}
+
+// Syndrome-trellis coding: payload size x layout x width
+void BM_StcEmbed(benchmark::State& state) {
+    ChannelLayout channels = state.range(1) ? ChannelLayout::RGBA : ChannelLayout::RGB;
+    unsigned width = (unsigned)state.range(2);
+    uint64_t pixelCount = stcChannels(state.range(0), width) / channelsPerPixel(channels) + 1;
+    sf::Vector2u size(4096, (unsigned)((pixelCount + 4095) / 4096));
+    if (!fitsInMemory(state, size)) return;
+    std::vector<uint8_t> pixels = randomBytes((size_t)size.x * size.y * 4, 2);
+    std::vector<uint8_t> payload = randomBytes(state.range(0), 1);
+
+    uint64_t start = readCycles();
+    for (auto _ : state) {
+        stcEmbed(pixels.data(), channels, 0, width, payload.data(), payload.size());
+        benchmark::ClobberMemory();
+    }
+    setCounters(state, readCycles() - start);
+}
+
+void BM_StcExtract(benchmark::State& state) {
+    ChannelLayout channels = state.range(1) ? ChannelLayout::RGBA : ChannelLayout::RGB;
+    unsigned width = (unsigned)state.range(2);
+    uint64_t pixelCount = stcChannels(state.range(0), width) / channelsPerPixel(channels) + 1;
+    sf::Vector2u size(4096, (unsigned)((pixelCount + 4095) / 4096));
+    if (!fitsInMemory(state, size)) return;
+    std::vector<uint8_t> pixels = randomBytes((size_t)size.x * size.y * 4, 2);
+    std::vector<uint8_t> payload(state.range(0));
+
+    uint64_t start = readCycles();
+    for (auto _ : state) {
+        stcExtract(pixels.data(), channels, 0, width, payload.data(), payload.size());
+        benchmark::DoNotOptimize(payload.data());
+    }
+    setCounters(state, readCycles() - start);
+}
+
+void stcArgs(benchmark::internal::Benchmark* b) {
+    b->ArgsProduct({{1 << 10, 1 << 15, 1 << 20}, {0, 1}, {2, 4, 8}})
+        ->ArgNames({"bytes", "rgba", "width"})
+        ->Unit(benchmark::kMillisecond);
+}
+
+// Adaptive cost map over a 24 MP noise carrier, per filter, single-threaded
+// (the map must cost less than decoding the carrier); bytes are pixels
+void BM_CostMap(benchmark::State& state) {
+    const unsigned width = 6000, height = 4000;
+    std::vector<uint8_t> pixels = randomBytes((uint64_t)width * height * 4, 3);
+    CostFilter filter = (CostFilter)state.range(0);
+
+    uint64_t start = readCycles();
+    for (auto _ : state) {
+        std::vector<float> costs = computeCostMap(pixels.data(), width, height, filter, 1);
+        benchmark::DoNotOptimize(costs.data());
+    }
+    uint64_t cycles = readCycles() - start;
+    uint64_t count = (uint64_t)state.iterations() * width * height;
+    state.SetBytesProcessed((int64_t)count);
+    state.counters["cycles/px"] = (double)cycles / (double)count;
+}
+
+// Keyed traversal: batched position generation over a carrier of
+// state.range(0) channels; throughput is in positions (reported as bytes)
+void BM_ChannelPermutation(benchmark::State& state) {
+    ChannelPermutation permutation((uint64_t)state.range(0), 0x5EED);
+    uint64_t positions[ChannelPermutation::kBatch];
+    uint64_t next = 0;
+
+    uint64_t start = readCycles();
+    for (auto _ : state) {
+        permutation.map(next, ChannelPermutation::kBatch, positions);
+        benchmark::DoNotOptimize(positions);
+        next = (next + ChannelPermutation::kBatch) % (permutation.size() - ChannelPermutation::kBatch);
+    }
+    uint64_t cycles = readCycles() - start;
+    uint64_t count = (uint64_t)state.iterations() * ChannelPermutation::kBatch;
+    state.SetBytesProcessed((int64_t)count);
+    state.counters["cycles/pos"] = (double)cycles / (double)count;
+}
+
+// CRC32C over state.range(0) bytes, the size of a header up to a large chunk
+void BM_Crc32c(benchmark::State& state, CrcKernel kernel) {
+    std::vector<uint8_t> data = randomBytes((uint64_t)state.range(0), 4);
+
+    uint64_t start = readCycles();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(kernel(data.data(), data.size(), 0));
+    }
+    uint64_t cycles = readCycles() - start;
+    uint64_t bytes = (uint64_t)state.iterations() * data.size();
+    state.SetBytesProcessed((int64_t)bytes);
+    state.counters["cycles/B"] = (double)cycles / (double)bytes;
+}
+
+// One parity shard from state.range(0) data shards of state.range(1) bytes;
+// bytes/s counts the data read
+void BM_GfDot(benchmark::State& state, GfDotKernel kernel) {
+    const unsigned count = (unsigned)state.range(0);
+    const uint64_t size = (uint64_t)state.range(1);
+    std::vector<std::vector<uint8_t>> sources;
+    std::vector<const uint8_t*> pointers;
+    std::vector<uint8_t> coefficients(count), out(size);
+    for (unsigned j = 0; j < count; ++j) {
+        sources.push_back(randomBytes(size, 5 + j));
+        pointers.push_back(sources.back().data());
+        coefficients[j] = gfInverse((uint8_t)(count + j + 1));
+    }
+
+    uint64_t start = readCycles();
+    for (auto _ : state) {
+        kernel(pointers.data(), coefficients.data(), count, out.data(), size);
+        benchmark::DoNotOptimize(out.data());
+    }
+    uint64_t cycles = readCycles() - start;
+    uint64_t bytes = (uint64_t)state.iterations() * count * size;
+    state.SetBytesProcessed((int64_t)bytes);
+    state.counters["cycles/B"] = (double)cycles / (double)bytes;
+}
+
+// Payload size x layout (0 = RGB, 1 = RGBA) x bits per channel
+void kernelArgs(benchmark::internal::Benchmark* b, int64_t maxBytes, std::vector<int64_t> depths = {1, 2, 4}) {
+    std::vector<int64_t> sizes;
+    for (int64_t bytes = 1 << 10; bytes <= maxBytes; bytes <<= 5) {
+        sizes.push_back(bytes);
+    }
+    b->ArgsProduct({sizes, {0, 1}, depths})->ArgNames({"bytes", "rgba", "bits"})->Unit(benchmark::kMicrosecond);
+}
+
+void referenceArgs(benchmark::internal::Benchmark* b) { kernelArgs(b, kReferenceMaxBytes); }
+void bufferArgs(benchmark::internal::Benchmark* b) { kernelArgs(b, 1 << 30); }
+void matchingArgs(benchmark::internal::Benchmark* b) { kernelArgs(b, 1 << 30, {1}); }
+
+} // namespace
+
+BENCHMARK(BM_EmbedReference)->Apply(referenceArgs);
+BENCHMARK(BM_ExtractReference)->Apply(referenceArgs);
+BENCHMARK(BM_HammingEmbed)->Apply(hammingArgs);
+BENCHMARK(BM_HammingExtract)->Apply(hammingArgs);
+BENCHMARK(BM_StcEmbed)->Apply(stcArgs);
+BENCHMARK(BM_StcExtract)->Apply(stcArgs);
+// 12 MP RGB, and a channel count just past a power of two (the most cycle-walking)
+BENCHMARK(BM_CostMap)
+    ->Arg((int)CostFilter::Variance3x3)
+    ->Arg((int)CostFilter::Variance5x5)
+    ->Arg((int)CostFilter::HighPass3x3)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ChannelPermutation)->Arg(36000000)->Arg((1 << 25) + 1);
+
+int main(int argc, char** argv) {
+    // Buffer kernels are registered at runtime: which SIMD variants exist
+    // depends on the CPU running the benchmark
+    for (const KernelVariant& kernel : availableKernels()) {
+        std::string name = kernel.name;
+        benchmark::RegisterBenchmark(("BM_Embed/" + name).c_str(), BM_EmbedBuffer, kernel.embed)->Apply(bufferArgs);
+        benchmark::RegisterBenchmark(("BM_Extract/" + name).c_str(), BM_ExtractBuffer, kernel.extract)->Apply(bufferArgs);
+    }
+    for (const MatchingVariant& kernel : availableMatchingKernels()) {
+        std::string name = kernel.name;
+        benchmark::RegisterBenchmark(("BM_EmbedMatching/" + name).c_str(), BM_EmbedMatching, kernel.embed)
+            ->Apply(matchingArgs);
+    }
+    for (const CrcVariant& kernel : availableCrcKernels()) {
+        std::string name = kernel.name;
+        benchmark::RegisterBenchmark(("BM_Crc32c/" + name).c_str(), BM_Crc32c, kernel.update)
+            ->Arg(12)->Arg(4 << 10)->Arg(64 << 10)->Arg(16 << 20);
+    }
+
+    for (const GfVariant& kernel : availableGfKernels()) {
+        std::string name = kernel.name;
+        benchmark::RegisterBenchmark(("BM_GfDot/" + name).c_str(), BM_GfDot, kernel.dot)
+            ->ArgsProduct({{4, 10}, {64 << 10, 4 << 20}})
+            ->ArgNames({"sources", "bytes"});
+    }
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,470 @@
+// Differential verification of the optimized embed/extract kernels.
+//
+// Random payloads, carrier dimensions, layouts, bit depths and stream offsets
+// are pushed through the reference kernel (getPixel/setPixel + embedBit) and
+// through every buffer kernel the CPU can run. Each variant's stego pixels
+// must match the reference byte for byte, and its extraction must return the
+// original payload. LSB matching kernels (1 bit per channel) are checked
+// against the scalar matching kernel the same way, and every channel they
+// touch must have moved by at most one. Trellis forward passes are checked
+// against the scalar pass over random widths, costs and lengths around the
+// block size, on both the survivor bits and the stego LSBs. Cost map row
+// kernels must build maps bit-identical to the scalar ones for every filter
+// and odd carrier sizes. Batched keyed traversal through each Feistel rounds
+// kernel must match the one-index permutation everywhere, cycle-walking
+// included, and be a bijection on small domains. CRC32C kernels are checked
+// against the standard check value and against the scalar tables on random
+// buffers, alignments and split points. GF(2^8) dot product kernels are
+// checked against the scalar tables, and Reed-Solomon parity must rebuild
+// random sets of lost data shards. WAV sample kernels are checked against the
+// scalar sample kernel over every sample width and depth, and must leave all
+// but the first byte of each sample alone. Per-variant time is reported so a
+// fast path that is correct but slow is visible too.
+//
+// Usage: kernel_verify [--trials N] [--seed S]
+// Exits non-zero on the first mismatch, printing the failing configuration.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "AudioCarrier.h"
+#include "Checksum.h"
+#include "CostMap.h"
+#include "ErasureCode.h"
+#include "Kernels.h"
+#include "SyndromeTrellis.h"
+#include "Traversal.h"
+
+using namespace Steganography;
+
+namespace {
+
+struct Timing {
+    double embedMs = 0;
+    double extractMs = 0;
+};
+
+double msSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    unsigned trials = 2000;
+    uint32_t seed = 12345;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        if (arg == "--trials") trials = (unsigned)std::strtoul(argv[i + 1], nullptr, 10);
+        else if (arg == "--seed") seed = (uint32_t)std::strtoul(argv[i + 1], nullptr, 10);
+    }
+
+    std::vector<KernelVariant> kernels = availableKernels();
+    std::vector<Timing> timings(kernels.size());
+    std::vector<MatchingVariant> matchingKernels = availableMatchingKernels();
+    std::vector<double> matchingMs(matchingKernels.size());
+    Timing referenceTiming;
+    std::mt19937 rng(seed);
+    const unsigned depths[] = {1, 2, 4};
+
+    for (unsigned trial = 0; trial < trials; ++trial) {
+        Layout layout;
+        layout.channels = rng() % 2 ? ChannelLayout::RGBA : ChannelLayout::RGB;
+        layout.bitsPerChannel = depths[rng() % 3];
+
+        // Mostly small carriers to hit edge cases, with the odd large one so
+        // the threaded kernel actually splits work
+        bool large = rng() % 50 == 0;
+        unsigned width = 1 + rng() % (large ? 2048 : 97);
+        unsigned height = 1 + rng() % (large ? 2048 : 61);
+
+        uint64_t capacityBytes = capacityBits((uint64_t)width * height, layout) / 8;
+        if (capacityBytes == 0) continue;
+        uint64_t offset = rng() % capacityBytes;
+        uint64_t length = rng() % (capacityBytes - offset + 1);
+
+        std::vector<uint8_t> cover((size_t)width * height * 4);
+        for (auto& b : cover) b = (uint8_t)rng();
+        std::vector<uint8_t> payload(length);
+        for (auto& b : payload) b = (uint8_t)rng();
+
+        sf::Image reference;
+        reference.create(width, height, cover.data());
+        auto start = std::chrono::steady_clock::now();
+        embedReference(reference, layout, offset, payload.data(), length);
+        referenceTiming.embedMs += msSince(start);
+
+        std::vector<uint8_t> referenceOut(length);
+        start = std::chrono::steady_clock::now();
+        extractReference(reference, layout, offset, referenceOut.data(), length);
+        referenceTiming.extractMs += msSince(start);
+
+        for (size_t k = 0; k < kernels.size(); ++k) {
+            std::vector<uint8_t> pixels = cover;
+            start = std::chrono::steady_clock::now();
+            kernels[k].embed(pixels.data(), layout, offset, payload.data(), length);
+            timings[k].embedMs += msSince(start);
+
+            std::vector<uint8_t> extracted(length);
+            start = std::chrono::steady_clock::now();
+            kernels[k].extract(pixels.data(), layout, offset, extracted.data(), length);
+            timings[k].extractMs += msSince(start);
+
+            bool pixelsMatch = std::memcmp(pixels.data(), reference.getPixelsPtr(), pixels.size()) == 0;
+            bool payloadMatch = extracted == payload && referenceOut == payload;
+            if (!pixelsMatch || !payloadMatch) {
+                printf("MISMATCH kernel=%s trial=%u seed=%u %ux%u %s bits=%u offset=%llu length=%llu (%s)\n",
+                       kernels[k].name, trial, seed, width, height,
+                       layout.channels == ChannelLayout::RGBA ? "rgba" : "rgb", layout.bitsPerChannel,
+                       (unsigned long long)offset, (unsigned long long)length,
+                       pixelsMatch ? "extracted payload differs" : "stego pixels differ");
+                return 1;
+            }
+        }
+
+        if (layout.bitsPerChannel != 1) continue;
+        uint64_t key = ((uint64_t)rng() << 32) | rng();
+        std::vector<uint8_t> matched;
+        for (size_t k = 0; k < matchingKernels.size(); ++k) {
+            std::vector<uint8_t> pixels = cover;
+            start = std::chrono::steady_clock::now();
+            matchingKernels[k].embed(pixels.data(), layout.channels, offset, payload.data(), length, key);
+            matchingMs[k] += msSince(start);
+            if (k == 0) matched = pixels;
+
+            std::vector<uint8_t> extracted(length);
+            extractScalar(pixels.data(), layout, offset, extracted.data(), length);
+            bool withinOne = true;
+            for (size_t i = 0; i < pixels.size(); ++i) {
+                withinOne &= std::abs((int)pixels[i] - (int)cover[i]) <= 1;
+            }
+            if (pixels != matched || extracted != payload || !withinOne) {
+                printf("MISMATCH matching kernel=%s trial=%u seed=%u %ux%u %s offset=%llu length=%llu (%s)\n",
+                       matchingKernels[k].name, trial, seed, width, height,
+                       layout.channels == ChannelLayout::RGBA ? "rgba" : "rgb", (unsigned long long)offset,
+                       (unsigned long long)length,
+                       pixels != matched ? "stego pixels differ" : !withinOne ? "channel moved by more than one"
+                                                                               : "extracted payload differs");
+                return 1;
+            }
+        }
+    }
+
+    // Trellis forward passes: random widths, cover LSBs and costs over short
+    // payloads and lengths around the block size. Each pass must record the
+    // scalar pass's survivor bits for a block, and embedding through it must
+    // leave the same stego LSBs, which extract to the message.
+    std::vector<StcVariant> stcKernels = availableStcKernels();
+    std::vector<double> stcMs(stcKernels.size());
+    const unsigned stcTrials = std::max(1u, trials / 20);
+    for (unsigned trial = 0; trial < stcTrials; ++trial) {
+        const unsigned width = kMinStcWidth + rng() % (kMaxStcWidth - kMinStcWidth + 1);
+        uint64_t length = 1 + rng() % 96;
+        if (rng() % 4 == 0) {
+            const uint64_t boundaries[] = {kStcBlockBytes - 1, kStcBlockBytes, kStcBlockBytes + 1,
+                                           2 * kStcBlockBytes + 1 + rng() % 64};
+            length = boundaries[rng() % 4];
+        }
+        const ChannelOrder order(rng() % 2 ? ChannelLayout::RGBA : ChannelLayout::RGB);
+        const unsigned perPixel = order.channels == ChannelLayout::RGBA ? 4 : 3;
+        const uint64_t firstChannel = 8 * (rng() % 16);
+        const uint64_t pixelCount = (firstChannel + stcChannels(length, width)) / perPixel + 1 + rng() % 16;
+
+        std::vector<uint8_t> cover((size_t)pixelCount * 4);
+        for (auto& b : cover) b = (uint8_t)rng();
+        std::vector<uint8_t> message(length);
+        for (auto& b : message) b = (uint8_t)rng();
+
+        // Uniform costs tie all the time and quantized ones often, which is
+        // where two passes are most likely to pick different survivors
+        const unsigned costKind = rng() % 3;
+        std::vector<float> pixelCosts(costKind ? (size_t)pixelCount : 0);
+        for (auto& c : pixelCosts) {
+            c = costKind == 1 ? (float)(1 + rng() % 4) / 4 : (float)(1 + rng() % 1000000) / 1e6f;
+        }
+        const float* costs = costKind ? pixelCosts.data() : nullptr;
+
+        const uint64_t blockBytes = std::min(length, kStcBlockBytes);
+        const uint64_t blockChannels = stcChannels(blockBytes, width);
+        std::vector<uint8_t> lsbs((size_t)blockChannels / 8);
+        gatherLsbs(cover.data(), order, firstChannel, blockChannels, lsbs.data());
+        std::vector<float> channelCosts(costs ? (size_t)blockChannels : 0);
+        if (costs) gatherCosts(costs, order, firstChannel, blockChannels, channelCosts.data());
+
+        std::vector<uint8_t> expectedPath, expectedPixels;
+        for (size_t k = 0; k < stcKernels.size(); ++k) {
+            std::vector<uint8_t> path((size_t)blockChannels * kStcPathBytes);
+            std::vector<uint8_t> stego = cover;
+            auto start = std::chrono::steady_clock::now();
+            stcKernels[k].forward(lsbs.data(), costs ? channelCosts.data() : nullptr, width, message.data(),
+                                  blockBytes * 8, path.data());
+            stcKernels[k].embed(stego.data(), order, firstChannel, width, message.data(), length, costs);
+            stcMs[k] += msSince(start);
+            if (k == 0) {
+                expectedPath = path;
+                expectedPixels = stego;
+            }
+
+            std::vector<uint8_t> extracted(length);
+            stcExtract(stego.data(), order, firstChannel, width, extracted.data(), length);
+            if (path != expectedPath || stego != expectedPixels || extracted != message) {
+                printf("MISMATCH stc kernel=%s trial=%u seed=%u width=%u %s first=%llu length=%llu costs=%s (%s)\n",
+                       stcKernels[k].name, trial, seed, width,
+                       order.channels == ChannelLayout::RGBA ? "rgba" : "rgb", (unsigned long long)firstChannel,
+                       (unsigned long long)length, costKind == 0 ? "uniform" : costKind == 1 ? "quantized" : "random",
+                       path != expectedPath ? "survivor bits differ" : stego != expectedPixels ? "stego LSBs differ"
+                                                                                                : "extracted message differs");
+                return 1;
+            }
+        }
+    }
+
+    // Cost maps: every filter over odd sizes, narrow ones below a vector
+    // included, on noise and on smooth gradients where the variance cancels
+    // down to rounding. Each map must match the scalar one bit for bit.
+    std::vector<CostMapVariant> costMapKernels = availableCostMapKernels();
+    std::vector<double> costMapMs(costMapKernels.size());
+    const CostFilter filters[] = {CostFilter::Variance3x3, CostFilter::Variance5x5, CostFilter::HighPass3x3};
+    const char* filterNames[] = {"variance3x3", "variance5x5", "highpass3x3"};
+    for (unsigned trial = 0; trial < std::max(1u, trials / 10); ++trial) {
+        const bool large = rng() % 20 == 0;
+        const unsigned width = 1 + rng() % (large ? 300 : 40);
+        const unsigned height = 1 + rng() % (large ? 300 : 40);
+        const bool smooth = rng() % 2;
+        std::vector<uint8_t> pixels((size_t)width * height * 4);
+        for (size_t i = 0; i < pixels.size(); ++i) {
+            const size_t pixel = i / 4;
+            pixels[i] = smooth ? (uint8_t)((pixel % width + pixel / width) / 2 + rng() % 3) : (uint8_t)rng();
+        }
+        const unsigned f = rng() % 3;
+        std::vector<float> expected;
+        for (size_t k = 0; k < costMapKernels.size(); ++k) {
+            auto start = std::chrono::steady_clock::now();
+            std::vector<float> costs = costMapKernels[k].compute(pixels.data(), width, height, filters[f], 1);
+            costMapMs[k] += msSince(start);
+            if (k == 0) expected = costs;
+            if (std::memcmp(costs.data(), expected.data(), costs.size() * sizeof(float)) != 0) {
+                printf("MISMATCH cost map kernel=%s trial=%u seed=%u %ux%u %s %s\n", costMapKernels[k].name, trial,
+                       seed, width, height, filterNames[f], smooth ? "smooth" : "noise");
+                return 1;
+            }
+        }
+    }
+
+    // Keyed traversal: map() through every rounds kernel must agree with
+    // operator() at every index, in ragged batches. Just past a power of
+    // two almost half of each batch cycle-walks; small domains, some with
+    // held channels, must also map one to one.
+    std::vector<RoundsVariant> roundsKernels = availableRoundsKernels();
+    std::vector<double> roundsMs(roundsKernels.size());
+    std::vector<std::pair<uint64_t, uint64_t>> domains = {{(1ull << 25) + 1, 0}, {(1ull << 20) + 1, 24}};
+    for (unsigned trial = 0; trial < std::max(1u, trials / 10); ++trial) {
+        domains.push_back({1 + rng() % 5000, rng() % 4 == 0 ? rng() % 64 : 0});
+    }
+    for (const auto& domain : domains) {
+        const uint64_t count = domain.first, fixed = domain.second;
+        const uint64_t key = ((uint64_t)rng() << 32) | rng();
+        const ChannelPermutation permutation(count, key, fixed);
+        std::vector<bool> seen(count <= 5000 ? count : 0);
+        uint64_t expected[ChannelPermutation::kBatch], out[ChannelPermutation::kBatch];
+        for (uint64_t first = 0; first < count;) {
+            const unsigned n = (unsigned)std::min<uint64_t>(count - first, 1 + rng() % ChannelPermutation::kBatch);
+            for (unsigned i = 0; i < n; ++i) expected[i] = permutation(first + i);
+            for (size_t k = 0; k < roundsKernels.size(); ++k) {
+                auto start = std::chrono::steady_clock::now();
+                permutation.map(first, n, out, roundsKernels[k].rounds);
+                roundsMs[k] += msSince(start);
+                for (unsigned i = 0; i < n; ++i) {
+                    if (out[i] != expected[i]) {
+                        printf("MISMATCH rounds kernel=%s seed=%u count=%llu fixed=%llu key=%016llx index=%llu\n",
+                               roundsKernels[k].name, seed, (unsigned long long)count, (unsigned long long)fixed,
+                               (unsigned long long)key, (unsigned long long)(first + i));
+                        return 1;
+                    }
+                }
+            }
+            for (unsigned i = 0; i < n && !seen.empty(); ++i) {
+                if (expected[i] >= count || seen[expected[i]]) {
+                    printf("MISMATCH traversal seed=%u count=%llu fixed=%llu key=%016llx: index %llu is not a "
+                           "bijection\n",
+                           seed, (unsigned long long)count, (unsigned long long)fixed, (unsigned long long)key,
+                           (unsigned long long)(first + i));
+                    return 1;
+                }
+                seen[expected[i]] = true;
+            }
+            first += n;
+        }
+    }
+
+    // CRC32C: the standard check value, then random buffers hashed in two
+    // chained pieces from a random alignment
+    std::vector<CrcVariant> crcKernels = availableCrcKernels();
+    std::vector<double> crcMs(crcKernels.size());
+    const char* check = "123456789";
+    for (const CrcVariant& kernel : crcKernels) {
+        uint32_t crc = kernel.update(reinterpret_cast<const uint8_t*>(check), 9, 0);
+        if (crc != 0xE3069283) {
+            printf("MISMATCH crc kernel=%s check value %08x\n", kernel.name, crc);
+            return 1;
+        }
+    }
+    for (unsigned trial = 0; trial < trials; ++trial) {
+        uint64_t length = rng() % (rng() % 20 == 0 ? 200000 : 300);
+        uint64_t align = rng() % 8;
+        uint64_t split = rng() % (length + 1);
+        std::vector<uint8_t> buffer(length + align);
+        for (auto& b : buffer) b = (uint8_t)rng();
+        const uint8_t* data = buffer.data() + align;
+        uint32_t expected = crc32cScalar(data, length);
+        for (size_t k = 0; k < crcKernels.size(); ++k) {
+            auto start = std::chrono::steady_clock::now();
+            uint32_t crc = crcKernels[k].update(data + split, length - split, crcKernels[k].update(data, split, 0));
+            crcMs[k] += msSince(start);
+            if (crc != expected) {
+                printf("MISMATCH crc kernel=%s trial=%u seed=%u length=%llu align=%llu split=%llu\n",
+                       crcKernels[k].name, trial, seed, (unsigned long long)length, (unsigned long long)align,
+                       (unsigned long long)split);
+                return 1;
+            }
+        }
+    }
+
+    // GF(2^8) dot products over random coefficients, source counts and
+    // lengths, then parity encode and rebuild after random erasures
+    std::vector<GfVariant> gfKernels = availableGfKernels();
+    std::vector<double> gfMs(gfKernels.size());
+    for (unsigned trial = 0; trial < trials; ++trial) {
+        unsigned count = 1 + rng() % 12;
+        uint64_t length = rng() % (rng() % 20 == 0 ? 200000 : 300);
+        std::vector<std::vector<uint8_t>> sources(count, std::vector<uint8_t>(length));
+        std::vector<const uint8_t*> pointers;
+        std::vector<uint8_t> coefficients(count);
+        for (unsigned j = 0; j < count; ++j) {
+            for (auto& b : sources[j]) b = (uint8_t)rng();
+            pointers.push_back(sources[j].data());
+            coefficients[j] = (uint8_t)rng();
+        }
+        std::vector<uint8_t> expected(length), out(length);
+        gfDotScalar(pointers.data(), coefficients.data(), count, expected.data(), length);
+        for (size_t k = 0; k < gfKernels.size(); ++k) {
+            auto start = std::chrono::steady_clock::now();
+            gfKernels[k].dot(pointers.data(), coefficients.data(), count, out.data(), length);
+            gfMs[k] += msSince(start);
+            if (out != expected) {
+                printf("MISMATCH gf kernel=%s trial=%u seed=%u sources=%u length=%llu\n", gfKernels[k].name, trial,
+                       seed, count, (unsigned long long)length);
+                return 1;
+            }
+        }
+
+        unsigned dataCount = 1 + rng() % 10, parityCount = 1 + rng() % 4;
+        std::vector<std::vector<uint8_t>> shards(dataCount + parityCount, std::vector<uint8_t>(length));
+        std::vector<uint8_t*> shardPointers;
+        for (auto& shard : shards) shardPointers.push_back(shard.data());
+        for (unsigned j = 0; j < dataCount; ++j) {
+            for (auto& b : shards[j]) b = (uint8_t)rng();
+        }
+        encodeParity(shardPointers.data(), dataCount, shardPointers.data() + dataCount, parityCount, length, 0);
+        std::vector<std::vector<uint8_t>> original = shards;
+        std::vector<bool> present(dataCount + parityCount, true);
+        for (unsigned lost = 0; lost < parityCount; ++lost) {
+            unsigned s = rng() % (dataCount + parityCount);
+            present[s] = false;
+            std::fill(shards[s].begin(), shards[s].end(), 0);
+        }
+        rebuildData(shardPointers.data(), present, dataCount, length, 0);
+        for (unsigned j = 0; j < dataCount; ++j) {
+            if (shards[j] != original[j]) {
+                printf("MISMATCH parity rebuild trial=%u seed=%u data=%u parity=%u length=%llu shard=%u\n", trial,
+                       seed, dataCount, parityCount, (unsigned long long)length, j);
+                return 1;
+            }
+        }
+    }
+
+    // WAV sample kernels: random widths, depths, offsets and lengths
+    std::vector<SampleVariant> sampleKernels = availableSampleKernels();
+    std::vector<Timing> sampleTimings(sampleKernels.size());
+    for (unsigned trial = 0; trial < trials; ++trial) {
+        const unsigned width = 1 + rng() % 3;
+        const unsigned depths[] = {1, 2, 4};
+        const unsigned depth = depths[rng() % 3];
+        const uint64_t offset = rng() % 64;
+        const uint64_t length = rng() % (rng() % 20 == 0 ? 50000 : 300);
+        std::vector<uint8_t> samples((offset + length) * 8 / depth * width);
+        for (auto& b : samples) b = (uint8_t)rng();
+        std::vector<uint8_t> payload(length);
+        for (auto& b : payload) b = (uint8_t)rng();
+
+        std::vector<uint8_t> expected = samples;
+        embedSamplesScalar(expected.data(), width, depth, offset, payload.data(), length);
+        for (size_t i = 0; i < samples.size(); ++i) {
+            if (i % width != 0 && expected[i] != samples[i]) {
+                printf("MISMATCH sample kernel=scalar trial=%u seed=%u width=%u: byte %llu is not a sample's first\n",
+                       trial, seed, width, (unsigned long long)i);
+                return 1;
+            }
+        }
+        for (size_t k = 0; k < sampleKernels.size(); ++k) {
+            std::vector<uint8_t> stego = samples;
+            std::vector<uint8_t> extracted(length);
+            auto start = std::chrono::steady_clock::now();
+            sampleKernels[k].embed(stego.data(), width, depth, offset, payload.data(), length);
+            sampleTimings[k].embedMs += msSince(start);
+            start = std::chrono::steady_clock::now();
+            sampleKernels[k].extract(stego.data(), width, depth, offset, extracted.data(), length);
+            sampleTimings[k].extractMs += msSince(start);
+            if (stego != expected || extracted != payload) {
+                printf("MISMATCH sample kernel=%s trial=%u seed=%u width=%u depth=%u offset=%llu length=%llu: %s\n",
+                       sampleKernels[k].name, trial, seed, width, depth, (unsigned long long)offset,
+                       (unsigned long long)length, stego != expected ? "stego samples differ" : "extracted payload differs");
+                return 1;
+            }
+        }
+    }
+
+    printf("%u trials, all kernels bit-identical to the reference\n\n", trials);
+    printf("%-10s %12s %12s\n", "kernel", "embed ms", "extract ms");
+    printf("%-10s %12.2f %12.2f\n", "reference", referenceTiming.embedMs, referenceTiming.extractMs);
+    for (size_t k = 0; k < kernels.size(); ++k) {
+        printf("%-10s %12.2f %12.2f\n", kernels[k].name, timings[k].embedMs, timings[k].extractMs);
+    }
+    printf("\n%-10s %12s\n", "matching", "embed ms");
+    for (size_t k = 0; k < matchingKernels.size(); ++k) {
+        printf("%-10s %12.2f\n", matchingKernels[k].name, matchingMs[k]);
+    }
+    printf("\n%-10s %12s\n", "stc", "ms");
+    for (size_t k = 0; k < stcKernels.size(); ++k) {
+        printf("%-10s %12.2f\n", stcKernels[k].name, stcMs[k]);
+    }
+    printf("\n%-10s %12s\n", "cost map", "ms");
+    for (size_t k = 0; k < costMapKernels.size(); ++k) {
+        printf("%-10s %12.2f\n", costMapKernels[k].name, costMapMs[k]);
+    }
+    printf("\n%-10s %12s\n", "rounds", "ms");
+    for (size_t k = 0; k < roundsKernels.size(); ++k) {
+        printf("%-10s %12.2f\n", roundsKernels[k].name, roundsMs[k]);
+    }
+    printf("\n%-10s %12s\n", "crc32c", "ms");
+    for (size_t k = 0; k < crcKernels.size(); ++k) {
+        printf("%-10s %12.2f\n", crcKernels[k].name, crcMs[k]);
+    }
+    printf("\n%-10s %12s\n", "gf dot", "ms");
+    for (size_t k = 0; k < gfKernels.size(); ++k) {
+        printf("%-10s %12.2f\n", gfKernels[k].name, gfMs[k]);
+    }
+    printf("\n%-10s %12s %12s\n", "samples", "embed ms", "extract ms");
+    for (size_t k = 0; k < sampleKernels.size(); ++k) {
+        printf("%-10s %12.2f %12.2f\n", sampleKernels[k].name, sampleTimings[k].embedMs, sampleTimings[k].extractMs);
+    }
+    return 0;
+}
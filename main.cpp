@@ -1,187 +1,350 @@
 #include <SFML/Graphics.hpp>
 #include <iostream>
 #include <vector>
-#include <fstream>
 #include <string>
 #include <cstdint> // For uint32_t
+#include <atomic>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <filesystem>
 
 // --- Library Includes (Corrected Paths) ---
 #include "imgui.h"
 #include "imgui-sfml.h"
 #include "portable-file-dialogs.h"
 
-// --- Steganography Logic ---
-namespace Steganography {
-
-// Helper to embed a single bit into a color channel
-void embedBit(sf::Uint8& colorChannel, bool bit) {
-    if (bit) {
-        colorChannel |= 1; // Set LSB to 1
-    } else {
-        colorChannel &= ~1; // Set LSB to 0
+#include "Steganography.h"
+#include "CarrierCache.h"
+#include "Encryption.h"
+
+// --- Background Job ---
+// Runs one encode/decode off the UI thread so the window can show progress
+// and offer a Cancel button while the job is running.
+struct BackgroundJob {
+    std::thread worker;
+    std::atomic<bool> running{false};
+    std::atomic<uint64_t> bytesDone{0};
+    std::atomic<uint64_t> bytesTotal{0};
+    std::atomic<int> phase{0};
+    Steganography::CancelToken cancelToken;
+    // Carriers of earlier encodes stay decoded, so encoding another secret
+    // into the same image skips reading it again
+    Steganography::CarrierCache carrierCache{256ull << 20};
+    std::mutex resultMutex;
+    Steganography::JobResult result;
+    bool hasResult = false;
+
+    template <typename Fn>
+    void start(Fn job) {
+        if (worker.joinable()) worker.join();
+        cancelToken.reset();
+        bytesDone = 0;
+        bytesTotal = 0;
+        running = true;
+
+        Steganography::Options options;
+        options.cancelToken = &cancelToken;
+        options.carrierCache = &carrierCache;
+        options.onProgress = [this](const Steganography::Progress& p) {
+            phase = static_cast<int>(p.phase);
+            bytesDone = p.bytesDone;
+            bytesTotal = p.bytesTotal;
+        };
+
+        worker = std::thread([this, job, options]() {
+            Steganography::JobResult jobResult = job(options);
+            std::lock_guard<std::mutex> lock(resultMutex);
+            result = jobResult;
+            hasResult = true;
+            running = false;
+        });
     }
-}
 
-// Helper to extract a single bit from a color channel
-bool extractBit(const sf::Uint8& colorChannel) {
-    return (colorChannel & 1);
-}
-
-// Main encoding function
-std::string encode(const std::string& carrierPath, const std::string& secretPath, const std::string& outputPath) {
-    sf::Image carrierImage;
-    if (!carrierImage.loadFromFile(carrierPath)) {
-        return "Error: Could not load carrier image.";
-    }
-
-    std::ifstream secretFile(secretPath, std::ios::binary);
-    if (!secretFile) {
-        return "Error: Could not open secret file.";
+    // Moves a finished job's status message and stats into the UI buffers
+    void collect(char* status, char* stats, size_t size) {
+        std::lock_guard<std::mutex> lock(resultMutex);
+        if (hasResult) {
+            snprintf(status, size, "%s", result.message.c_str());
+            snprintf(stats, size, "%s", Steganography::summarize(result).c_str());
+            hasResult = false;
+        }
     }
 
-    // Read secret file into a vector
-    std::vector<char> secretData((std::istreambuf_iterator<char>(secretFile)), std::istreambuf_iterator<char>());
-    uint32_t secretSize = secretData.size();
-
-    // Check if the image has enough capacity
-    sf::Vector2u imageSize = carrierImage.getSize();
-    uint64_t capacity = (uint64_t)imageSize.x * imageSize.y * 3;
-    uint64_t requiredBits = (sizeof(secretSize) * 8) + ((uint64_t)secretSize * 8);
-
-    if (capacity < requiredBits) {
-        return "Error: Carrier image is too small to hold the secret data.";
+    ~BackgroundJob() {
+        cancelToken.cancel();
+        if (worker.joinable()) worker.join();
     }
-
-    // --- Embed Data ---
-    unsigned int bitIndex = 0;
-
-    // 1. Embed the 32-bit size of the secret file first
-    for (int i = 0; i < 32; ++i) {
-        sf::Vector2u pos;
-        pos.x = (bitIndex / 3) % imageSize.x;
-        pos.y = (bitIndex / 3) / imageSize.x;
-        sf::Color color = carrierImage.getPixel(pos.x, pos.y);
-
-        bool bit = (secretSize >> i) & 1;
-
-        switch(bitIndex % 3) {
-            case 0: embedBit(color.r, bit); break;
-            case 1: embedBit(color.g, bit); break;
-            case 2: embedBit(color.b, bit); break;
+};
+
+// --- Command Line ---
+// StegTool encode <carrier> <secret> <output> [flags]
+// StegTool decode <stego> <output> [flags]
+// StegTool probe <stego>...
+// StegTool shard <secret> <carrier> <output> [<carrier> <output>]... [flags]
+// StegTool gather <output> <stego>... [flags]
+// StegTool append <stego> <secret> <output> [flags]
+// StegTool patch <stego> <secret> <output> --offset <n> [flags]
+// StegTool plan <directory> [flags]
+// StegTool index <index> <directory>
+// StegTool choose <index> <secret> [flags]
+// StegTool schedule <index> <directory> <secret>... [flags]
+// StegTool pack <carrier> <output> <secret>... [flags]
+// StegTool list <stego> [flags]
+// StegTool extract <stego> <name> <output> [flags]
+const char* kUsage =
+    "Usage:\n"
+    "  StegTool encode <carrier> <secret> <output> [flags]\n"
+    "  StegTool decode <stego> <output> [flags]\n"
+    "  StegTool probe <stego>... [--json]\n"
+    "  StegTool shard <secret> <carrier> <output> [<carrier> <output>]... [flags]\n"
+    "  StegTool gather <output> <stego>... [flags]\n"
+    "  shard splits a secret too big for one carrier over several PNG carriers;\n"
+    "  gather joins it back from all of them\n"
+    "  StegTool append <stego> <secret> <output> [flags]\n"
+    "  StegTool patch <stego> <secret> <output> --offset <n> [flags]\n"
+    "  append and patch rewrite only the chunks they change of an uncompressed,\n"
+    "  unencrypted payload; a .bmp written over itself gets only its changed rows\n"
+    "  StegTool plan <directory> [flags]\n"
+    "  plan lists the capacity of every lossless image under a directory in each\n"
+    "  mode, read from the file headers, largest first under the given flags\n"
+    "  StegTool index <index> <directory>\n"
+    "  StegTool choose <index> <secret> [flags]\n"
+    "  index builds or refreshes a carrier index file for a directory, reading only\n"
+    "  new and changed images; choose picks the smallest indexed carrier that holds\n"
+    "  the secret under the flags\n"
+    "  StegTool schedule <index> <directory> <secret>... [flags]\n"
+    "  schedule packs the secrets into indexed carriers, several to a carrier as\n"
+    "  named entries where they fit, prints the jobs and runs them in parallel,\n"
+    "  writing one PNG per carrier under the directory\n"
+    "  StegTool pack <carrier> <output> <secret>... [flags]\n"
+    "  StegTool list <stego> [flags]\n"
+    "  StegTool extract <stego> <name> <output> [flags]\n"
+    "  pack hides several files as named entries in one PNG carrier; extract reads\n"
+    "  back just the one named\n"
+    "  Images record how their payload was embedded, so decode needs --key and\n"
+    "  --encrypt only; probe reads just that record\n"
+    "  A .jpg carrier is embedded in its DCT coefficients (F5, with --hamming k for\n"
+    "  matrix coding) and must be saved as .jpg\n"
+    "  A .wav carrier (8, 16 or 24-bit PCM) is streamed through with the payload in\n"
+    "  its sample LSBs (--bits per sample, no --key) and must be saved as .wav\n"
+    "Flags:\n"
+    "  --json         Print the job result as JSON\n"
+    "  --rgba         Also use the alpha channel\n"
+    "  --bits <n>     Bits per channel: 1, 2 or 4 (default 1)\n"
+    "  --match        LSB matching: change channels by +-1 instead of overwriting the LSB\n"
+    "                 (1 bit per channel)\n"
+    "  --hamming <k>  Matrix embedding, k payload bits per 2^k-1 channels (2..6)\n"
+    "  --stc <w>      Syndrome-trellis embedding, 1 payload bit per w channels (2..16)\n"
+    "  --adaptive <f> With --stc, steer changes into textured areas using cost filter\n"
+    "                 f = var3 | var5 | highpass; works best together with --key\n"
+    "  --compress <c> Compress the secret before embedding, c = zstd | lz4\n"
+    "  --encrypt <p>  Seal the secret with ChaCha20-Poly1305 under passphrase p; decode\n"
+    "                 needs the same flag to open it\n"
+    "  --crc          Store a CRC32C per payload chunk so decode reports corrupted data\n"
+    "  --parity <m>   With shard, turn m of the carriers into Reed-Solomon parity so\n"
+    "                 gather survives any m lost or damaged images (use with --crc)\n"
+    "  --key <phrase> Scatter the payload over the image in a keyed pseudo-random order\n"
+    "  --offset <n>   With decode, write only the payload bytes from n on (uncompressed\n"
+    "                 payloads), reading just the pixels that hold them; with patch,\n"
+    "                 where the new bytes go\n"
+    "  --length <n>   With decode, write at most n payload bytes\n"
+    "  --fewest-carriers With schedule, use as few carriers as possible rather than as\n"
+    "                 few pixels\n"
+    "  --dry-run      With schedule, print the jobs without running them\n";
+
+int runCommandLine(int argc, char** argv) {
+    std::vector<std::string> args;
+    Steganography::Options options;
+    bool json = false;
+    bool ranged = false;
+    bool dryRun = false;
+    Steganography::PackGoal goal = Steganography::PackGoal::FewestPixels;
+    uint64_t offset = 0, length = UINT64_MAX;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--json") {
+            json = true;
+        } else if (arg == "--rgba") {
+            options.layout.channels = Steganography::ChannelLayout::RGBA;
+        } else if (arg == "--bits" && i + 1 < argc) {
+            options.layout.bitsPerChannel = (unsigned)strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--match") {
+            options.mode = Steganography::EmbedMode::Matching;
+        } else if (arg == "--hamming" && i + 1 < argc) {
+            options.mode = Steganography::EmbedMode::Hamming;
+            options.hammingK = (unsigned)strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--stc" && i + 1 < argc) {
+            options.mode = Steganography::EmbedMode::Stc;
+            options.stcWidth = (unsigned)strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--adaptive" && i + 1 < argc) {
+            std::string filter = argv[++i];
+            if (filter == "var3") options.costFilter = Steganography::CostFilter::Variance3x3;
+            else if (filter == "var5") options.costFilter = Steganography::CostFilter::Variance5x5;
+            else if (filter == "highpass") options.costFilter = Steganography::CostFilter::HighPass3x3;
+            else {
+                std::cerr << "Unknown cost filter: " << filter << "\n" << kUsage;
+                return 2;
+            }
+        } else if (arg == "--compress" && i + 1 < argc) {
+            std::string codec = argv[++i];
+            if (codec == "zstd") options.compression = Steganography::Compression::Zstd;
+            else if (codec == "lz4") options.compression = Steganography::Compression::Lz4;
+            else {
+                std::cerr << "Unknown codec: " << codec << "\n" << kUsage;
+                return 2;
+            }
+        } else if (arg == "--crc") {
+            options.chunkCrcs = true;
+        } else if (arg == "--parity" && i + 1 < argc) {
+            options.parityShards = (unsigned)strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--encrypt" && i + 1 < argc) {
+            options.passphrase = argv[++i];
+        } else if (arg == "--offset" && i + 1 < argc) {
+            ranged = true;
+            offset = strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--length" && i + 1 < argc) {
+            ranged = true;
+            length = strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--fewest-carriers") {
+            goal = Steganography::PackGoal::FewestCarriers;
+        } else if (arg == "--dry-run") {
+            dryRun = true;
+        } else if (arg == "--key" && i + 1 < argc) {
+            options.traversal = Steganography::TraversalMode::Keyed;
+            options.key = argv[++i];
+        } else if (arg.rfind("--", 0) == 0) {
+            std::cerr << "Unknown flag: " << arg << "\n" << kUsage;
+            return 2;
+        } else {
+            args.push_back(arg);
         }
-
-        carrierImage.setPixel(pos.x, pos.y, color);
-        bitIndex++;
     }
 
-    // 2. Embed the secret data itself
-    for (char byte : secretData) {
-        for (int i = 0; i < 8; ++i) {
-            sf::Vector2u pos;
-            pos.x = (bitIndex / 3) % imageSize.x;
-            pos.y = (bitIndex / 3) / imageSize.x;
-
-            sf::Color color = carrierImage.getPixel(pos.x, pos.y);
-            bool bit = (byte >> i) & 1;
-
-            switch(bitIndex % 3) {
-                case 0: embedBit(color.r, bit); break;
-                case 1: embedBit(color.g, bit); break;
-                case 2: embedBit(color.b, bit); break;
+    // One line per image, ok only if every image carries a payload
+    if (args.size() >= 2 && args[0] == "probe") {
+        bool allFound = true;
+        for (size_t i = 1; i < args.size(); ++i) {
+            Steganography::JobResult probed = Steganography::probe(args[i]);
+            allFound = allFound && probed.ok;
+            if (json) {
+                std::cout << Steganography::toJson(probed) << std::endl;
+            } else {
+                std::cout << args[i] << ": " << probed.message << std::endl;
             }
-
-            carrierImage.setPixel(pos.x, pos.y, color);
-            bitIndex++;
         }
+        return allFound ? 0 : 1;
     }
 
-    if (!carrierImage.saveToFile(outputPath)) {
-        return "Error: Failed to save the output image. Ensure it's a .png file.";
-    }
-
-    return "Success! Data encoded and saved to " + outputPath;
-}
-
-// Main decoding function
-std::string decode(const std::string& stegoPath, const std::string& outputPath) {
-    sf::Image stegoImage;
-    if (!stegoImage.loadFromFile(stegoPath)) {
-        return "Error: Could not load the steganographic image.";
-    }
-
-    sf::Vector2u imageSize = stegoImage.getSize();
-    unsigned int bitIndex = 0;
-
-    // 1. Extract the 32-bit size of the secret file
-    uint32_t secretSize = 0;
-    for (int i = 0; i < 32; ++i) {
-        sf::Vector2u pos;
-        pos.x = (bitIndex / 3) % imageSize.x;
-        pos.y = (bitIndex / 3) / imageSize.x;
-        sf::Color color = stegoImage.getPixel(pos.x, pos.y);
-        bool bit = false;
-
-        switch(bitIndex % 3) {
-            case 0: bit = extractBit(color.r); break;
-            case 1: bit = extractBit(color.g); break;
-            case 2: bit = extractBit(color.b); break;
+    // One row per carrier: its size and its capacity in bytes under the
+    // flags, then in every mode
+    if (args.size() == 2 && args[0] == "plan") {
+        std::vector<Steganography::CarrierCapacity> plan;
+        Steganography::JobResult planned = Steganography::planCarriers(args[1], plan, options);
+        if (json) {
+            for (const Steganography::CarrierCapacity& carrier : plan) {
+                std::cout << Steganography::toJson(carrier) << "\n";
+            }
+            std::cout << Steganography::toJson(planned) << std::endl;
+            return planned.ok ? 0 : 1;
         }
-
-        if (bit) {
-            secretSize |= (1 << i);
+        std::cout << "carrier\twidth\theight\tchosen";
+        for (const std::string& mode : Steganography::planModes()) std::cout << "\t" << mode;
+        std::cout << "\n";
+        for (const Steganography::CarrierCapacity& carrier : plan) {
+            std::cout << carrier.path << "\t" << carrier.width << "\t" << carrier.height << "\t" << carrier.chosen;
+            for (uint64_t bytes : carrier.byMode) std::cout << "\t" << bytes;
+            std::cout << "\n";
         }
-        bitIndex++;
+        std::cout << planned.message << "\n" << Steganography::summarize(planned) << std::endl;
+        return planned.ok ? 0 : 1;
     }
 
-    // Sanity check
-    uint64_t capacity = (uint64_t)imageSize.x * imageSize.y * 3;
-    if ((uint64_t)secretSize * 8 + 32 > capacity) {
-        return "Error: Decoded size is invalid or larger than image capacity.";
-    }
-    if (secretSize == 0) {
-        return "Warning: Decoded size is 0. Nothing to extract.";
+    // One line per job: its carrier, its output and the payloads it takes,
+    // then the jobs are run
+    if (args.size() >= 4 && args[0] == "schedule") {
+        std::vector<Steganography::ScheduledJob> plan;
+        Steganography::JobResult scheduled = Steganography::scheduleJobs(
+            args[1], std::vector<std::string>(args.begin() + 3, args.end()), args[2], goal, options, plan);
+        for (const Steganography::ScheduledJob& job : plan) {
+            std::cout << job.carrierPath << "\t" << job.outputPath;
+            for (const std::string& secret : job.secretPaths) std::cout << "\t" << secret;
+            std::cout << "\n";
+        }
+        if (scheduled.ok && !dryRun) {
+            std::cout << scheduled.message << std::endl;
+            scheduled = Steganography::runSchedule(plan, options);
+        }
+        if (json) {
+            std::cout << Steganography::toJson(scheduled) << std::endl;
+        } else {
+            std::cout << scheduled.message << "\n" << Steganography::summarize(scheduled) << std::endl;
+        }
+        return scheduled.ok ? 0 : 1;
     }
 
-    // 2. Extract the secret data
-    std::vector<char> secretData;
-    secretData.reserve(secretSize);
-    for (uint32_t byte_i = 0; byte_i < secretSize; ++byte_i) {
-        char currentByte = 0;
-        for (int bit_i = 0; bit_i < 8; ++bit_i) {
-            sf::Vector2u pos;
-            pos.x = (bitIndex / 3) % imageSize.x;
-            pos.y = (bitIndex / 3) / imageSize.x;
-
-            sf::Color color = stegoImage.getPixel(pos.x, pos.y);
-            bool bit = false;
-
-            switch(bitIndex % 3) {
-                case 0: bit = extractBit(color.r); break;
-                case 1: bit = extractBit(color.g); break;
-                case 2: bit = extractBit(color.b); break;
-            }
-
-            if (bit) {
-                currentByte |= (1 << bit_i);
-            }
-            bitIndex++;
+    Steganography::JobResult result;
+    if (args.size() == 4 && args[0] == "encode") {
+        result = Steganography::encode(args[1], args[2], args[3], options);
+    } else if (args.size() == 3 && args[0] == "decode" && ranged) {
+        result = Steganography::decodeRange(args[1], offset, length, args[2], options);
+    } else if (args.size() == 3 && args[0] == "decode") {
+        result = Steganography::decode(args[1], args[2], options);
+    } else if (args.size() >= 4 && args.size() % 2 == 0 && args[0] == "shard") {
+        std::vector<std::string> carriers, outputs;
+        for (size_t i = 2; i < args.size(); i += 2) {
+            carriers.push_back(args[i]);
+            outputs.push_back(args[i + 1]);
+        }
+        result = Steganography::encodeShards(carriers, args[1], outputs, options);
+    } else if (args.size() >= 3 && args[0] == "gather") {
+        result = Steganography::decodeShards(std::vector<std::string>(args.begin() + 2, args.end()), args[1], options);
+    } else if (args.size() == 4 && args[0] == "append") {
+        result = Steganography::appendPayload(args[1], args[2], args[3], options);
+    } else if (args.size() == 4 && args[0] == "patch" && ranged) {
+        result = Steganography::patchPayload(args[1], args[2], offset, args[3], options);
+    } else if (args.size() == 3 && args[0] == "index") {
+        result = Steganography::refreshIndex(args[1], args[2], options);
+    } else if (args.size() == 3 && args[0] == "choose") {
+        // Sized as stored uncompressed, which compression can only shrink
+        std::error_code ec;
+        uint64_t bytes = std::filesystem::file_size(args[2], ec);
+        if (ec) {
+            std::cerr << "Cannot read " << args[2] << "\n";
+            return 1;
         }
-        secretData.push_back(currentByte);
+        if (!options.passphrase.empty()) bytes = Steganography::sealedSize(bytes);
+        std::string carrier;
+        result = Steganography::chooseCarrier(args[1], bytes, options, carrier);
+    } else if (args.size() >= 4 && args[0] == "pack") {
+        result = Steganography::encodeEntries(args[1], std::vector<std::string>(args.begin() + 3, args.end()), args[2],
+                                              options);
+    } else if (args.size() == 2 && args[0] == "list") {
+        result = Steganography::listEntries(args[1], options);
+    } else if (args.size() == 4 && args[0] == "extract") {
+        result = Steganography::decodeEntry(args[1], args[2], args[3], options);
+    } else {
+        std::cerr << kUsage;
+        return 2;
     }
 
-    std::ofstream outputFile(outputPath, std::ios::binary);
-    if (!outputFile) {
-        return "Error: Could not create output file for decoded data.";
+    if (json) {
+        std::cout << Steganography::toJson(result) << std::endl;
+    } else {
+        std::cout << result.message << "\n" << Steganography::summarize(result) << std::endl;
     }
-    outputFile.write(secretData.data(), secretData.size());
-    outputFile.close();
-
-    return "Success! Decoded data saved to " + outputPath;
+    return result.ok ? 0 : 1;
 }
 
-} // namespace Steganography
+int main(int argc, char** argv) {
+    if (argc > 1) {
+        return runCommandLine(argc, argv);
+    }
 
-int main() {
     sf::RenderWindow window(sf::VideoMode(800, 450), "Steganography Tool", sf::Style::Titlebar | sf::Style::Close);
     window.setFramerateLimit(60);
     ImGui::SFML::Init(window);
@@ -193,6 +356,8 @@ int main() {
     char stegoPath[256] = "";
     char decodeOutputPath[256] = "decoded_file";
     char status[256] = "Ready.";
+    char stats[256] = "";
+    BackgroundJob job;
 
     sf::Clock deltaClock;
     while (window.isOpen()) {
@@ -215,7 +380,7 @@ int main() {
         ImGui::InputText("Carrier Image", carrierPath, 256, ImGuiInputTextFlags_ReadOnly);
         ImGui::SameLine();
         if (ImGui::Button("...##1")) {
-             auto f = pfd::open_file("Select a carrier image", ".", {"Image Files", "*.png *.bmp"}).result();
+             auto f = pfd::open_file("Select a carrier image", ".", {"Image Files", "*.png *.bmp *.jpg *.jpeg", "WAV Audio", "*.wav"}).result();
              if (!f.empty()) strncpy(carrierPath, f[0].c_str(), 256);
         }
 
@@ -228,9 +393,12 @@ int main() {
 
         ImGui::InputText("Output Image Path", encodeOutputPath, 256);
 
-        if (ImGui::Button("Encode")) {
-            std::string result = Steganography::encode(carrierPath, secretPath, encodeOutputPath);
-            strncpy(status, result.c_str(), 256);
+        if (ImGui::Button("Encode") && !job.running) {
+            std::string carrier = carrierPath, secret = secretPath, output = encodeOutputPath;
+            job.start([carrier, secret, output](const Steganography::Options& options) {
+                return Steganography::encode(carrier, secret, output, options);
+            });
+            strncpy(status, "Encoding...", 256);
         }
 
         ImGui::Separator();
@@ -240,22 +408,39 @@ int main() {
         ImGui::InputText("Stego Image", stegoPath, 256, ImGuiInputTextFlags_ReadOnly);
         ImGui::SameLine();
         if (ImGui::Button("...##3")) {
-            auto f = pfd::open_file("Select a stego image", ".", {"Image Files", "*.png *.bmp"}).result();
+            auto f = pfd::open_file("Select a stego image", ".", {"Image Files", "*.png *.bmp *.jpg *.jpeg", "WAV Audio", "*.wav"}).result();
             if (!f.empty()) strncpy(stegoPath, f[0].c_str(), 256);
         }
 
         ImGui::InputText("Decoded File Path", decodeOutputPath, 256);
 
-        if (ImGui::Button("Decode")) {
-            std::string result = Steganography::decode(stegoPath, decodeOutputPath);
-            strncpy(status, result.c_str(), 256);
+        if (ImGui::Button("Decode") && !job.running) {
+            std::string stego = stegoPath, output = decodeOutputPath;
+            job.start([stego, output](const Steganography::Options& options) {
+                return Steganography::decode(stego, output, options);
+            });
+            strncpy(status, "Decoding...", 256);
         }
 
         ImGui::Separator();
 
         // --- STATUS ---
+        job.collect(status, stats, 256);
         ImGui::Text("Status:");
         ImGui::TextWrapped("%s", status);
+        if (stats[0] != '\0') {
+            ImGui::TextWrapped("%s", stats);
+        }
+
+        if (job.running) {
+            static const char* phaseNames[] = {"Loading", "Embedding", "Extracting", "Saving"};
+            uint64_t total = job.bytesTotal;
+            float fraction = total ? (float)job.bytesDone / (float)total : 0.0f;
+            ImGui::ProgressBar(fraction, ImVec2(-1, 0), phaseNames[job.phase]);
+            if (ImGui::Button("Cancel")) {
+                job.cancelToken.cancel();
+            }
+        }
 
         ImGui::End();
 